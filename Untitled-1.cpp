@@ -1,8 +1,12 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <deque>
 #include <memory>
+#include <type_traits>
 #include <algorithm>
 #include <chrono>
 #include <ctime>
@@ -12,12 +16,37 @@
 #include <fstream>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <optional>
+#include <array>
 #include <sstream>
 #include <limits>
 #include <numeric>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -30,6 +59,518 @@ class Asset;
 class Portfolio;
 class MarketDataFetcher;
 
+// Compact calendar date: days since 1970-01-01
+struct Date {
+    std::int32_t days = 0;
+    
+    // Days since the epoch for a proleptic Gregorian date
+    static Date fromCivil(int year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return Date{era * 146097 + static_cast<std::int32_t>(doe) - 719468};
+    }
+    
+    void toCivil(int& year, unsigned& month, unsigned& day) const {
+        const std::int32_t z = days + 719468;
+        const int era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+    }
+    
+    // Render as YYYY-MM-DD (display only)
+    std::string toString() const {
+        int year;
+        unsigned month, day;
+        toCivil(year, month, day);
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", year, month, day);
+        return buffer;
+    }
+    
+    bool operator==(const Date& other) const { return days == other.days; }
+    bool operator!=(const Date& other) const { return days != other.days; }
+    bool operator<(const Date& other) const { return days < other.days; }
+};
+
+// Clock service for hot paths: timestamps come straight from the system
+// clock, and today's local calendar date is resolved once per day and
+// cached, so callers never touch localtime or allocate
+class Clock {
+private:
+    // Cached day packed as (end of day in epoch seconds << 24) | days
+    static std::atomic<std::uint64_t>& cachedDay() {
+        static std::atomic<std::uint64_t> packed{0};
+        return packed;
+    }
+    
+    static Date refreshToday(std::int64_t timestamp) {
+        std::time_t t = static_cast<std::time_t>(timestamp);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &t);
+#else
+        localtime_r(&t, &local);
+#endif
+        Date date = Date::fromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+        
+        // Next local midnight; days are 23 or 25 hours long across DST changes
+        std::tm midnight = local;
+        midnight.tm_mday += 1;
+        midnight.tm_hour = 0;
+        midnight.tm_min = 0;
+        midnight.tm_sec = 0;
+        midnight.tm_isdst = -1;
+        std::time_t nextDay = std::mktime(&midnight);
+        if (nextDay <= t) {
+            nextDay = t + 1;
+        }
+        std::uint64_t dayEnd = static_cast<std::uint64_t>(nextDay);
+        
+        cachedDay().store((dayEnd << 24) | static_cast<std::uint32_t>(date.days),
+                          std::memory_order_release);
+        return date;
+    }
+
+public:
+    // Seconds since the Unix epoch
+    static std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    
+    // Milliseconds since the Unix epoch
+    static std::int64_t nowMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    
+    // Today's local calendar date
+    static Date today() {
+        std::int64_t timestamp = now();
+        std::uint64_t packed = cachedDay().load(std::memory_order_acquire);
+        if (static_cast<std::int64_t>(packed >> 24) > timestamp) {
+            return Date{static_cast<std::int32_t>(packed & 0xFFFFFF)};
+        }
+        return refreshToday(timestamp);
+    }
+};
+
+// Philox4x32-10 counter-based generator. Each 128-bit counter maps to four
+// 32-bit outputs through a keyed bijection, so a stream is fully determined
+// by (seed, stream id) and any number of streams can run in parallel
+// without sharing state
+class Philox4x32 {
+public:
+    using result_type = std::uint32_t;
+
+private:
+    static constexpr std::uint32_t kMul0 = 0xD2511F53u;
+    static constexpr std::uint32_t kMul1 = 0xCD9E8D57u;
+    static constexpr std::uint32_t kWeyl0 = 0x9E3779B9u;
+    static constexpr std::uint32_t kWeyl1 = 0xBB67AE85u;
+    
+    std::uint32_t key[2];
+    std::uint32_t counter[4];   // [0..1] block index, [2..3] stream id
+    std::uint32_t output[4];
+    int outputIndex = 4;
+    
+    static void round(std::uint32_t ctr[4], const std::uint32_t k[2]) {
+        std::uint64_t p0 = static_cast<std::uint64_t>(kMul0) * ctr[0];
+        std::uint64_t p1 = static_cast<std::uint64_t>(kMul1) * ctr[2];
+        std::uint32_t next[4] = {
+            static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ k[0],
+            static_cast<std::uint32_t>(p1),
+            static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ k[1],
+            static_cast<std::uint32_t>(p0)
+        };
+        std::memcpy(ctr, next, sizeof(next));
+    }
+    
+    void generateBlock() {
+        std::uint32_t ctr[4] = {counter[0], counter[1], counter[2], counter[3]};
+        std::uint32_t k[2] = {key[0], key[1]};
+        for (int r = 0; r < 10; ++r) {
+            if (r > 0) {
+                k[0] += kWeyl0;
+                k[1] += kWeyl1;
+            }
+            round(ctr, k);
+        }
+        std::memcpy(output, ctr, sizeof(ctr));
+        outputIndex = 0;
+        
+        if (++counter[0] == 0) {
+            ++counter[1];
+        }
+    }
+
+public:
+    Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) {
+        key[0] = static_cast<std::uint32_t>(seed);
+        key[1] = static_cast<std::uint32_t>(seed >> 32);
+        counter[0] = 0;
+        counter[1] = 0;
+        counter[2] = static_cast<std::uint32_t>(stream);
+        counter[3] = static_cast<std::uint32_t>(stream >> 32);
+    }
+    
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+    
+    result_type operator()() {
+        if (outputIndex == 4) {
+            generateBlock();
+        }
+        return output[outputIndex++];
+    }
+    
+    // Skip ahead by whole 4-word blocks in O(1)
+    void discardBlocks(std::uint64_t blocks) {
+        std::uint64_t position = (static_cast<std::uint64_t>(counter[1]) << 32 | counter[0]) + blocks;
+        counter[0] = static_cast<std::uint32_t>(position);
+        counter[1] = static_cast<std::uint32_t>(position >> 32);
+        outputIndex = 4;
+    }
+};
+
+// One reproducible random stream: uniforms with 53-bit resolution and
+// standard normals from a 128-layer ziggurat, which needs no transcendental
+// functions except on the rare draws that fall outside a layer's core
+class RandomStream {
+private:
+    // Layer tables for the Marsaglia-Tsang ziggurat, built once
+    struct Ziggurat {
+        static constexpr double kTail = 3.442619855899;
+        std::uint32_t kn[128];
+        double wn[128];
+        double fn[128];
+        
+        Ziggurat() {
+            const double m1 = 2147483648.0;
+            const double area = 9.91256303526217e-3;
+            double dn = kTail, tn = kTail;
+            double q = area / std::exp(-0.5 * dn * dn);
+            kn[0] = static_cast<std::uint32_t>((dn / q) * m1);
+            kn[1] = 0;
+            wn[0] = q / m1;
+            wn[127] = dn / m1;
+            fn[0] = 1.0;
+            fn[127] = std::exp(-0.5 * dn * dn);
+            for (int i = 126; i >= 1; --i) {
+                dn = std::sqrt(-2.0 * std::log(area / dn + std::exp(-0.5 * dn * dn)));
+                kn[i + 1] = static_cast<std::uint32_t>((dn / tn) * m1);
+                tn = dn;
+                fn[i] = std::exp(-0.5 * dn * dn);
+                wn[i] = dn / m1;
+            }
+        }
+    };
+    
+    static const Ziggurat& ziggurat() {
+        static const Ziggurat tables;
+        return tables;
+    }
+    
+    Philox4x32 engine;
+    
+    // Slow path: the draw fell in a layer's wedge or in the tail
+    double normalSlow(std::int32_t hz, std::uint32_t iz) {
+        const Ziggurat& z = ziggurat();
+        while (true) {
+            double x = hz * z.wn[iz];
+            if (iz == 0) {
+                double y;
+                do {
+                    x = -std::log(1.0 - uniform()) / Ziggurat::kTail;
+                    y = -std::log(1.0 - uniform());
+                } while (y + y < x * x);
+                return hz > 0 ? Ziggurat::kTail + x : -Ziggurat::kTail - x;
+            }
+            if (z.fn[iz] + uniform() * (z.fn[iz - 1] - z.fn[iz]) < std::exp(-0.5 * x * x)) {
+                return x;
+            }
+            
+            std::uint64_t bits = nextUInt64();
+            hz = static_cast<std::int32_t>(bits >> 32);
+            iz = bits & 127;
+            std::uint32_t magnitude = hz < 0 ? 0u - static_cast<std::uint32_t>(hz) : static_cast<std::uint32_t>(hz);
+            if (magnitude < z.kn[iz]) {
+                return hz * z.wn[iz];
+            }
+        }
+    }
+
+public:
+    RandomStream(std::uint64_t seed = 0, std::uint64_t stream = 0) : engine(seed, stream) {}
+    
+    Philox4x32& getEngine() { return engine; }
+    
+    std::uint64_t nextUInt64() {
+        std::uint64_t high = engine();
+        return (high << 32) | engine();
+    }
+    
+    // Uniform on [0, 1)
+    double uniform() {
+        return static_cast<double>(nextUInt64() >> 11) * 0x1.0p-53;
+    }
+    
+    double uniform(double low, double high) {
+        return low + (high - low) * uniform();
+    }
+    
+    // Standard normal N(0, 1); layer and value come from separate bits of
+    // one 64-bit draw so they are independent
+    double normal() {
+        const Ziggurat& z = ziggurat();
+        std::uint64_t bits = nextUInt64();
+        std::int32_t hz = static_cast<std::int32_t>(bits >> 32);
+        std::uint32_t iz = bits & 127;
+        std::uint32_t magnitude = hz < 0 ? 0u - static_cast<std::uint32_t>(hz) : static_cast<std::uint32_t>(hz);
+        if (magnitude < z.kn[iz]) {
+            return hz * z.wn[iz];
+        }
+        return normalSlow(hz, iz);
+    }
+    
+    double normal(double mean, double stddev) {
+        return mean + stddev * normal();
+    }
+    
+    void fillNormal(double* out, size_t count, double mean = 0.0, double stddev = 1.0) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = mean + stddev * normal();
+        }
+    }
+};
+
+// Process-wide source of random streams. Every stream is derived from one
+// seed and an explicit stream id, so a run is reproducible bit for bit once
+// the seed is fixed; without setSeed() a random seed is drawn at startup.
+// Stream ids are namespaced by domain so unrelated consumers never overlap.
+class RandomService {
+public:
+    enum class Domain : std::uint32_t {
+        Thread = 1,
+        MarketSymbol = 2,
+        Simulation = 3,
+        Risk = 4
+    };
+
+private:
+    std::atomic<std::uint64_t> seed;
+    std::atomic<std::uint64_t> epoch{0};            // Bumped on every reseed
+    std::atomic<std::uint32_t> nextThreadIndex{0};
+    
+    RandomService() {
+        std::random_device rd;
+        seed.store((static_cast<std::uint64_t>(rd()) << 32) | rd());
+    }
+
+public:
+    static RandomService& global() {
+        static RandomService instance;
+        return instance;
+    }
+    
+    static std::uint64_t streamId(Domain domain, std::uint32_t index) {
+        return (static_cast<std::uint64_t>(domain) << 32) | index;
+    }
+    
+    // Reseed every stream; per-thread and per-symbol streams restart
+    void setSeed(std::uint64_t newSeed) {
+        seed.store(newSeed);
+        nextThreadIndex.store(0);
+        epoch.fetch_add(1);
+    }
+    
+    std::uint64_t getSeed() const { return seed.load(); }
+    std::uint64_t getEpoch() const { return epoch.load(); }
+    
+    // A fresh stream for (domain, index); parallel work should take one
+    // per task index so results do not depend on thread scheduling
+    RandomStream stream(Domain domain, std::uint32_t index) const {
+        return RandomStream(getSeed(), streamId(domain, index));
+    }
+    
+    // Calling thread's own stream, numbered in order of first use
+    RandomStream& threadStream() {
+        thread_local RandomStream local;
+        thread_local std::uint64_t localEpoch = ~0ull;
+        std::uint64_t current = getEpoch();
+        if (localEpoch != current) {
+            local = stream(Domain::Thread, nextThreadIndex.fetch_add(1));
+            localEpoch = current;
+        }
+        return local;
+    }
+};
+
+// Work-stealing thread pool. Each worker owns a task deque: it pops its own
+// work from the back and steals from the front of other workers' deques
+// when it runs dry. Threads waiting in parallelFor() help run tasks, so
+// nested parallel loops cannot deadlock.
+class ThreadPool {
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false;
+    
+    // Run one task: own queue first (when `self` is a worker), then steal
+    bool tryRunOne(size_t self) {
+        std::function<void()> task;
+        size_t count = queues.size();
+        
+        if (self < count) {
+            WorkQueue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        for (size_t i = 1; !task && i <= count; ++i) {
+            WorkQueue& victim = *queues[(self + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        
+        pending.fetch_sub(1);
+        task();
+        return true;
+    }
+    
+    void workerLoop(size_t index) {
+        while (true) {
+            if (tryRunOne(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this]() { return stopping || pending.load() > 0; });
+            if (stopping && pending.load() == 0) {
+                return;
+            }
+        }
+    }
+    
+    void push(size_t queueIndex, std::function<void()> task) {
+        {
+            WorkQueue& queue = *queues[queueIndex % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        pending.fetch_add(1);
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wake.notify_one();
+    }
+
+public:
+    explicit ThreadPool(size_t threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < threadCount; ++i) {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+    
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    static ThreadPool& global() {
+        static ThreadPool instance;
+        return instance;
+    }
+    
+    size_t size() const { return workers.size(); }
+    
+    // Fire-and-forget task
+    void submit(std::function<void()> task) {
+        push(nextQueue.fetch_add(1), std::move(task));
+    }
+    
+    // Run fn(chunkBegin, chunkEnd) over [begin, end) in chunks of `grain`
+    // and wait for all of them; the first exception thrown is rethrown here.
+    // Chunks are dealt to the workers in contiguous runs and rebalanced by
+    // stealing.
+    template <typename Fn>
+    void parallelFor(size_t begin, size_t end, size_t grain, Fn&& fn) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max<size_t>(1, grain);
+        size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1) {
+            fn(begin, end);
+            return;
+        }
+        
+        std::atomic<size_t> remaining{chunks};
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        size_t perQueue = (chunks + queues.size() - 1) / queues.size();
+        
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t chunkBegin = begin + c * grain;
+            size_t chunkEnd = std::min(end, chunkBegin + grain);
+            push(c / perQueue, [&, chunkBegin, chunkEnd]() {
+                try {
+                    fn(chunkBegin, chunkEnd);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                }
+                remaining.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+        
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!tryRunOne(queues.size())) {
+                std::this_thread::yield();
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+};
+
 // Utility functions
 namespace Utils {
     // Callback function for cURL
@@ -56,16 +597,52 @@ namespace Utils {
         
         std::string result = oss.str();
         
-        // Add commas for thousands
-        int insertPosition = result.find('.') - 3;
-        while (insertPosition > 0) {
-            result.insert(insertPosition, ",");
+        // Add commas for thousands, between the currency sign and the decimal point
+        size_t digitsStart = result.find('$') + 1;
+        size_t insertPosition = std::min(result.find('.'), result.size());
+        while (insertPosition > digitsStart + 3) {
             insertPosition -= 3;
+            result.insert(insertPosition, ",");
         }
         
         return result;
     }
 
+    // Standard normal density
+    double normalPDF(double x) {
+        return std::exp(-0.5 * x * x) / std::sqrt(2.0 * M_PI);
+    }
+    
+    // Inverse of the standard normal CDF (Acklam's rational approximation,
+    // relative error below 1.2e-9), for p in (0, 1)
+    double inverseNormalCDF(double p) {
+        static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                   1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+        static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                   6.680131188771972e+01, -1.328068155288572e+01};
+        static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                   -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+        static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                   3.754408661907416e+00};
+        const double low = 0.02425;
+        
+        p = std::min(std::max(p, 1e-300), 1.0 - 1e-16);
+        if (p < low) {
+            double q = std::sqrt(-2.0 * std::log(p));
+            return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                   ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        }
+        if (p > 1.0 - low) {
+            double q = std::sqrt(-2.0 * std::log(1.0 - p));
+            return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                    ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        }
+        double q = p - 0.5;
+        double r = q * q;
+        return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+               (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+
     // Calculate percentage change
     double percentChange(double oldValue, double newValue) {
         if (oldValue == 0) return 0.0;
@@ -142,100 +719,421 @@ namespace Utils {
         return result;
     }
     
-    // Get current date as string
+    // Get current date as string (for display; hot paths use Clock::today())
     std::string getCurrentDate() {
-        auto now = std::chrono::system_clock::now();
-        auto now_time_t = std::chrono::system_clock::to_time_t(now);
-        std::tm* now_tm = std::localtime(&now_time_t);
-        
-        std::ostringstream oss;
-        oss << std::put_time(now_tm, "%Y-%m-%d");
-        return oss.str();
+        return Clock::today().toString();
     }
     
-    // Simulate market volatility
+    // Parse a YYYY-MM-DD date into an epoch timestamp (UTC midnight), 0 on failure
+    std::int64_t parseDate(const std::string& date) {
+        int year = 0;
+        unsigned month = 0, day = 0;
+        if (std::sscanf(date.c_str(), "%d-%u-%u", &year, &month, &day) != 3 ||
+            month < 1 || month > 12 || day < 1 || day > 31) {
+            return 0;
+        }
+        return static_cast<std::int64_t>(Date::fromCivil(year, month, day).days) * 86400;
+    }
+    
+    // Simulate market volatility with the given random stream
+    double simulateVolatility(double basePrice, RandomStream& rng, double volatilityFactor = 0.02) {
+        return basePrice * (1.0 + volatilityFactor * rng.normal());
+    }
+    
+    // Simulate market volatility with the calling thread's stream
     double simulateVolatility(double basePrice, double volatilityFactor = 0.02) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::normal_distribution<> d(0, volatilityFactor);
-        return basePrice * (1.0 + d(gen));
+        return simulateVolatility(basePrice, RandomService::global().threadStream(), volatilityFactor);
+    }
+    
+    // Write the whole buffer to a descriptor, retrying short writes
+    bool writeAll(int fd, const char* data, size_t size) {
+#ifdef _WIN32
+        (void)fd;
+        (void)data;
+        return size == 0;
+#else
+        size_t offset = 0;
+        while (offset < size) {
+            ssize_t bytes = write(fd, data + offset, size - offset);
+            if (bytes < 0 && errno == EINTR) continue;
+            if (bytes <= 0) return false;
+            offset += static_cast<size_t>(bytes);
+        }
+        return true;
+#endif
+    }
+    
+    // 64-bit checksum for catching torn or corrupted files, mixing eight
+    // bytes per step so large files verify at memory speed
+    std::uint64_t checksum64(const void* data, size_t size, std::uint64_t seed = 0) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        std::uint64_t hash = seed ^ (static_cast<std::uint64_t>(size) * 0x9E3779B97F4A7C15ULL);
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            hash ^= word * 0xBF58476D1CE4E5B9ULL;
+            hash = ((hash << 27) | (hash >> 37)) * 0x94D049BB133111EBULL;
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, bytes + i, size - i);
+        hash ^= tail * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+        hash *= 0x94D049BB133111EBULL;
+        hash ^= hash >> 29;
+        return hash;
     }
 }
 
-// Enums for risk appetite and investment goals
-enum class RiskAppetite { LOW, MEDIUM, HIGH };
-enum class InvestmentGoal { WEALTH_GROWTH, STABILITY, HIGH_RETURNS };
-enum class TimeHorizon { SHORT, MEDIUM, LONG };
+// Dense integer handle for an interned instrument symbol
+using SymbolId = std::uint32_t;
 
-// Class to represent a user profile
-class UserProfile {
+// Process-wide symbol table: each instrument symbol is interned once and
+// referred to by its SymbolId everywhere except I/O and display
+class SymbolTable {
 private:
-    std::string name;
-    int age;
-    double investmentCapital;
-    RiskAppetite riskAppetite;
-    InvestmentGoal investmentGoal;
-    TimeHorizon timeHorizon;
-    double monthlyInvestment;  // For SIP
+    std::deque<std::string> names;  // Indexed by SymbolId; deque keeps references stable
+    std::unordered_map<std::string, SymbolId> ids;
+    mutable std::mutex tableMutex;
+
+    SymbolTable() = default;
 
 public:
-    UserProfile() : age(0), investmentCapital(0.0), riskAppetite(RiskAppetite::MEDIUM),
-                   investmentGoal(InvestmentGoal::WEALTH_GROWTH), timeHorizon(TimeHorizon::MEDIUM), 
-                   monthlyInvestment(0.0) {}
-    
-    void setup() {
-        std::cout << "\n========== USER PROFILE SETUP ==========\n" << std::endl;
-        
-        std::cout << "[Neural Scan Initiated...]" << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        std::cout << "[Identity Verified]\n" << std::endl;
-        
-        std::cout << "Enter your name: ";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');  // Clear any previous input
-        std::getline(std::cin, name);
-        
-        std::cout << "Enter your age: ";
-        std::cin >> age;
-        
-        std::cout << "Enter total investment capital ($): ";
-        std::cin >> investmentCapital;
-        
-        std::cout << "Enter monthly investment amount for SIP ($): ";
-        std::cin >> monthlyInvestment;
-        
-        int riskChoice;
-        std::cout << "\nSelect your risk appetite:\n";
-        std::cout << "1. Low Risk\n";
-        std::cout << "2. Medium Risk\n";
-        std::cout << "3. High Risk\n";
-        std::cout << "Choice: ";
-        std::cin >> riskChoice;
-        
-        switch (riskChoice) {
-            case 1: riskAppetite = RiskAppetite::LOW; break;
-            case 2: riskAppetite = RiskAppetite::MEDIUM; break;
-            case 3: riskAppetite = RiskAppetite::HIGH; break;
-            default: riskAppetite = RiskAppetite::MEDIUM;
-        }
-        
-        int goalChoice;
-        std::cout << "\nSelect your investment goal:\n";
-        std::cout << "1. Wealth Growth\n";
-        std::cout << "2. Stability\n";
-        std::cout << "3. High Returns\n";
-        std::cout << "Choice: ";
-        std::cin >> goalChoice;
-        
-        switch (goalChoice) {
-            case 1: investmentGoal = InvestmentGoal::WEALTH_GROWTH; break;
-            case 2: investmentGoal = InvestmentGoal::STABILITY; break;
-            case 3: investmentGoal = InvestmentGoal::HIGH_RETURNS; break;
-            default: investmentGoal = InvestmentGoal::WEALTH_GROWTH;
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    static SymbolTable& global() {
+        static SymbolTable table;
+        return table;
+    }
+
+    // Get the id for a symbol, assigning the next dense id on first use
+    SymbolId intern(const std::string& symbol) {
+        std::lock_guard<std::mutex> lock(tableMutex);
+        auto it = ids.find(symbol);
+        if (it != ids.end()) {
+            return it->second;
         }
-        
-        int timeChoice;
-        std::cout << "\nSelect your time horizon:\n";
-        std::cout << "1. Short Term (1-3 years)\n";
+
+        SymbolId id = static_cast<SymbolId>(names.size());
+        names.push_back(symbol);
+        ids.emplace(symbol, id);
+        return id;
+    }
+
+    // Look up an existing symbol without interning it
+    bool find(const std::string& symbol, SymbolId& id) const {
+        std::lock_guard<std::mutex> lock(tableMutex);
+        auto it = ids.find(symbol);
+        if (it == ids.end()) return false;
+        id = it->second;
+        return true;
+    }
+
+    const std::string& name(SymbolId id) const {
+        std::lock_guard<std::mutex> lock(tableMutex);
+        return names.at(id);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(tableMutex);
+        return names.size();
+    }
+};
+
+// Flat map keyed by SymbolId: values are stored in a vector indexed by id
+// and iteration follows insertion order, yielding (id, value) pairs
+template <typename T>
+class SymbolMap {
+private:
+    std::vector<T> values;            // Indexed by SymbolId
+    std::vector<std::uint32_t> slots; // SymbolId -> position in `order` + 1 (0 = absent)
+    std::vector<SymbolId> order;      // Present ids in insertion order
+
+    template <bool Const>
+    class Iterator {
+    private:
+        using Map = typename std::conditional<Const, const SymbolMap, SymbolMap>::type;
+        using Value = typename std::conditional<Const, const T, T>::type;
+        Map* map;
+        size_t pos;
+
+    public:
+        Iterator(Map* map, size_t pos) : map(map), pos(pos) {}
+        std::pair<SymbolId, Value&> operator*() const {
+            SymbolId id = map->order[pos];
+            return {id, map->values[id]};
+        }
+        Iterator& operator++() { ++pos; return *this; }
+        bool operator!=(const Iterator& other) const { return pos != other.pos; }
+        bool operator==(const Iterator& other) const { return pos == other.pos; }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, order.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, order.size()); }
+
+    // Insert a default value on first access
+    T& operator[](SymbolId id) {
+        if (id >= slots.size()) {
+            slots.resize(id + 1, 0);
+            values.resize(id + 1);
+        }
+        if (slots[id] == 0) {
+            order.push_back(id);
+            slots[id] = static_cast<std::uint32_t>(order.size());
+        }
+        return values[id];
+    }
+
+    T* find(SymbolId id) {
+        return contains(id) ? &values[id] : nullptr;
+    }
+
+    const T* find(SymbolId id) const {
+        return contains(id) ? &values[id] : nullptr;
+    }
+
+    bool contains(SymbolId id) const {
+        return id < slots.size() && slots[id] != 0;
+    }
+
+    bool erase(SymbolId id) {
+        if (!contains(id)) return false;
+
+        order.erase(order.begin() + (slots[id] - 1));
+        slots[id] = 0;
+        values[id] = T();
+        for (size_t i = 0; i < order.size(); ++i) {
+            slots[order[i]] = static_cast<std::uint32_t>(i + 1);
+        }
+        return true;
+    }
+
+    void clear() {
+        for (SymbolId id : order) {
+            slots[id] = 0;
+            values[id] = T();
+        }
+        order.clear();
+    }
+
+    size_t size() const { return order.size(); }
+    bool empty() const { return order.empty(); }
+    const std::vector<SymbolId>& ids() const { return order; }
+};
+
+// Binary encoding for saved state: native little-endian scalars, arrays
+// as a count followed by the raw elements, strings length-prefixed.
+// Reading is a bounds-checked memcpy, no text is parsed. Symbols are
+// written as indexes into a table collected by the writer, since a
+// SymbolId only means something inside one process.
+class BinaryWriter {
+private:
+    std::string bytes;
+    std::vector<SymbolId> symbols;         // Local index -> SymbolId
+    SymbolMap<std::uint32_t> localIndex;   // SymbolId -> local index + 1
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() needs a trivially copyable type");
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    
+    template <typename T>
+    void putArray(const T* values, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "putArray() needs a trivially copyable type");
+        put<std::uint64_t>(count);
+        bytes.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+    }
+    
+    template <typename T>
+    void putArray(const std::vector<T>& values) {
+        putArray(values.data(), values.size());
+    }
+    
+    void putString(const std::string& value) {
+        put<std::uint32_t>(static_cast<std::uint32_t>(value.size()));
+        bytes += value;
+    }
+    
+    void putSymbol(SymbolId id) {
+        std::uint32_t& index = localIndex[id];
+        if (index == 0) {
+            symbols.push_back(id);
+            index = static_cast<std::uint32_t>(symbols.size());
+        }
+        put<std::uint32_t>(index - 1);
+    }
+    
+    // Reuse the buffer for a new message; the symbol table is kept
+    void clear() { bytes.clear(); }
+    
+    const std::string& data() const { return bytes; }
+    const std::vector<SymbolId>& getSymbols() const { return symbols; }
+};
+
+class BinaryReader {
+private:
+    const char* cursor;
+    const char* end;
+    std::vector<SymbolId> symbols;
+    std::uint32_t version = 0;
+    bool failed = false;
+    
+    bool take(void* out, size_t size) {
+        if (failed || static_cast<size_t>(end - cursor) < size) {
+            failed = true;
+            return false;
+        }
+        std::memcpy(out, cursor, size);
+        cursor += size;
+        return true;
+    }
+
+public:
+    BinaryReader(const char* data, size_t size) : cursor(data), end(data + size) {}
+    
+    // Overruns leave the value default-constructed and set failed()
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "get() needs a trivially copyable type");
+        T value{};
+        take(&value, sizeof(T));
+        return value;
+    }
+    
+    template <typename T>
+    std::vector<T> getArray() {
+        std::uint64_t count = get<std::uint64_t>();
+        std::vector<T> values;
+        if (failed || count > static_cast<std::uint64_t>(end - cursor) / sizeof(T)) {
+            failed = true;
+            return values;
+        }
+        values.resize(static_cast<size_t>(count));
+        take(values.data(), values.size() * sizeof(T));
+        return values;
+    }
+    
+    std::string getString() {
+        std::uint32_t length = get<std::uint32_t>();
+        if (failed || length > static_cast<size_t>(end - cursor)) {
+            failed = true;
+            return std::string();
+        }
+        std::string value(cursor, length);
+        cursor += length;
+        return value;
+    }
+    
+    SymbolId getSymbol() {
+        std::uint32_t index = get<std::uint32_t>();
+        if (index >= symbols.size()) {
+            failed = true;
+            return 0;
+        }
+        return symbols[index];
+    }
+    
+    // Symbol table written ahead of the data, interned in this process
+    void readSymbols() {
+        std::uint32_t count = get<std::uint32_t>();
+        symbols.clear();
+        for (std::uint32_t i = 0; i < count && !failed; ++i) {
+            symbols.push_back(SymbolTable::global().intern(getString()));
+        }
+    }
+    
+    // Format version of the data, for readers of older layouts
+    void setVersion(std::uint32_t newVersion) { version = newVersion; }
+    std::uint32_t getVersion() const { return version; }
+    
+    void fail() { failed = true; }
+    bool ok() const { return !failed; }
+    bool atEnd() const { return cursor == end; }
+};
+
+// Enums for risk appetite and investment goals
+enum class RiskAppetite { LOW, MEDIUM, HIGH };
+enum class InvestmentGoal { WEALTH_GROWTH, STABILITY, HIGH_RETURNS };
+enum class TimeHorizon { SHORT, MEDIUM, LONG };
+
+// Class to represent a user profile
+class UserProfile {
+private:
+    std::string name;
+    int age;
+    double investmentCapital;
+    RiskAppetite riskAppetite;
+    InvestmentGoal investmentGoal;
+    TimeHorizon timeHorizon;
+    double monthlyInvestment;  // For SIP
+
+public:
+    UserProfile() : age(0), investmentCapital(0.0), riskAppetite(RiskAppetite::MEDIUM),
+                   investmentGoal(InvestmentGoal::WEALTH_GROWTH), timeHorizon(TimeHorizon::MEDIUM), 
+                   monthlyInvestment(0.0) {}
+    
+    void setup() {
+        std::cout << "\n========== USER PROFILE SETUP ==========\n" << std::endl;
+        
+        std::cout << "[Neural Scan Initiated...]" << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        std::cout << "[Identity Verified]\n" << std::endl;
+        
+        std::cout << "Enter your name: ";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');  // Clear any previous input
+        std::getline(std::cin, name);
+        
+        std::cout << "Enter your age: ";
+        std::cin >> age;
+        
+        std::cout << "Enter total investment capital ($): ";
+        std::cin >> investmentCapital;
+        
+        std::cout << "Enter monthly investment amount for SIP ($): ";
+        std::cin >> monthlyInvestment;
+        
+        int riskChoice;
+        std::cout << "\nSelect your risk appetite:\n";
+        std::cout << "1. Low Risk\n";
+        std::cout << "2. Medium Risk\n";
+        std::cout << "3. High Risk\n";
+        std::cout << "Choice: ";
+        std::cin >> riskChoice;
+        
+        switch (riskChoice) {
+            case 1: riskAppetite = RiskAppetite::LOW; break;
+            case 2: riskAppetite = RiskAppetite::MEDIUM; break;
+            case 3: riskAppetite = RiskAppetite::HIGH; break;
+            default: riskAppetite = RiskAppetite::MEDIUM;
+        }
+        
+        int goalChoice;
+        std::cout << "\nSelect your investment goal:\n";
+        std::cout << "1. Wealth Growth\n";
+        std::cout << "2. Stability\n";
+        std::cout << "3. High Returns\n";
+        std::cout << "Choice: ";
+        std::cin >> goalChoice;
+        
+        switch (goalChoice) {
+            case 1: investmentGoal = InvestmentGoal::WEALTH_GROWTH; break;
+            case 2: investmentGoal = InvestmentGoal::STABILITY; break;
+            case 3: investmentGoal = InvestmentGoal::HIGH_RETURNS; break;
+            default: investmentGoal = InvestmentGoal::WEALTH_GROWTH;
+        }
+        
+        int timeChoice;
+        std::cout << "\nSelect your time horizon:\n";
+        std::cout << "1. Short Term (1-3 years)\n";
         std::cout << "2. Medium Term (3-7 years)\n";
         std::cout << "3. Long Term (7+ years)\n";
         std::cout << "Choice: ";
@@ -263,6 +1161,34 @@ public:
     TimeHorizon getTimeHorizon() const { return timeHorizon; }
     double getMonthlyInvestment() const { return monthlyInvestment; }
     
+    // Saved state
+    void save(BinaryWriter& out) const {
+        out.putString(name);
+        out.put<std::int32_t>(age);
+        out.put(investmentCapital);
+        out.put(monthlyInvestment);
+        out.put<std::uint8_t>(static_cast<std::uint8_t>(riskAppetite));
+        out.put<std::uint8_t>(static_cast<std::uint8_t>(investmentGoal));
+        out.put<std::uint8_t>(static_cast<std::uint8_t>(timeHorizon));
+    }
+    
+    void load(BinaryReader& in) {
+        name = in.getString();
+        age = in.get<std::int32_t>();
+        investmentCapital = in.get<double>();
+        monthlyInvestment = in.get<double>();
+        std::uint8_t risk = in.get<std::uint8_t>();
+        std::uint8_t goal = in.get<std::uint8_t>();
+        std::uint8_t horizon = in.get<std::uint8_t>();
+        if (risk > 2 || goal > 2 || horizon > 2) {
+            in.fail();
+            return;
+        }
+        riskAppetite = static_cast<RiskAppetite>(risk);
+        investmentGoal = static_cast<InvestmentGoal>(goal);
+        timeHorizon = static_cast<TimeHorizon>(horizon);
+    }
+    
     // Risk profile as string
     std::string getRiskProfileStr() const {
         switch (riskAppetite) {
@@ -306,1075 +1232,7497 @@ public:
     }
 };
 
-// Base class for all assets
-class Asset {
-protected:
-    std::string name;
-    std::string symbol;
-    double currentPrice;
-    double quantity;
-    double initialInvestment;
-    std::vector<std::pair<std::string, double>> priceHistory;  // Date, Price
-    double volatility;  // Measured as standard deviation of returns
+// Streaming statistics of simple returns, updated in O(1) per price point.
+// A window of 0 tracks all history; otherwise only the most recent `window`
+// returns contribute (e.g. 30, 90 or 252 observations).
+class ReturnStats {
+private:
+    size_t window;
+    std::vector<double> ring;  // Last `window` returns, oldest at ringHead once full
+    size_t ringHead;
+    size_t count;
+    double mean;
+    double m2;                 // Sum of squared deviations from the mean
+    double lastPrice;
 
 public:
-    Asset(const std::string& name, const std::string& symbol, double currentPrice, double quantity = 0.0)
-        : name(name), symbol(symbol), currentPrice(currentPrice), quantity(quantity), 
-          initialInvestment(currentPrice * quantity), volatility(0.0) {
-        
-        // Add initial price to history
-        if (currentPrice > 0) {
-            priceHistory.push_back({Utils::getCurrentDate(), currentPrice});
-        }
-    }
-    
-    virtual ~Asset() = default;
-    
-    // Getters
-    std::string getName() const { return name; }
-    std::string getSymbol() const { return symbol; }
-    double getCurrentPrice() const { return currentPrice; }
-    double getQuantity() const { return quantity; }
-    double getCurrentValue() const { return currentPrice * quantity; }
-    double getInitialInvestment() const { return initialInvestment; }
-    double getVolatility() const { return volatility; }
-    
-    // Price history operations
-    void addPricePoint(const std::string& date, double price) {
-        priceHistory.push_back({date, price});
-        updateVolatility();
+    explicit ReturnStats(size_t window = 0)
+        : window(window), ring(window, 0.0), ringHead(0), count(0),
+          mean(0.0), m2(0.0), lastPrice(0.0) {}
+
+    // Change the window size; clears all accumulated statistics
+    void setWindow(size_t newWindow) {
+        window = newWindow;
+        ring.assign(window, 0.0);
+        reset();
     }
-    
-    void updateCurrentPrice(double newPrice) {
-        currentPrice = newPrice;
-        addPricePoint(Utils::getCurrentDate(), newPrice);
+
+    void reset() {
+        ringHead = 0;
+        count = 0;
+        mean = 0.0;
+        m2 = 0.0;
+        lastPrice = 0.0;
     }
-    
-    double getReturnPercentage() const {
-        if (initialInvestment == 0) return 0.0;
-        return ((getCurrentValue() - initialInvestment) / initialInvestment) * 100.0;
+
+    // Feed the next price; the return versus the previous price is recorded
+    void addPrice(double price) {
+        if (lastPrice > 0.0) {
+            addReturn((price - lastPrice) / lastPrice);
+        }
+        lastPrice = price;
     }
-    
-    // Buy more of this asset
-    void buy(double investmentAmount) {
-        double additionalQuantity = investmentAmount / currentPrice;
-        quantity += additionalQuantity;
-        initialInvestment += investmentAmount;
+
+    // Welford's update, with an in-place replacement once the window is full
+    void addReturn(double ret) {
+        if (window > 0 && count == window) {
+            double oldest = ring[ringHead];
+            double oldMean = mean;
+            mean += (ret - oldest) / count;
+            m2 += (ret - oldest) * (ret - mean + oldest - oldMean);
+            if (m2 < 0.0) m2 = 0.0;  // Guard against rounding drift
+        } else {
+            ++count;
+            double delta = ret - mean;
+            mean += delta / count;
+            m2 += delta * (ret - mean);
+        }
+
+        if (window > 0) {
+            ring[ringHead] = ret;
+            ringHead = (ringHead + 1) % window;
+        }
     }
+
+    // Getters
+    size_t getWindow() const { return window; }
+    size_t getCount() const { return count; }
+    double getMean() const { return mean; }
+    double getVariance() const { return count > 0 ? m2 / count : 0.0; }  // Population variance
+    double getStdDev() const { return std::sqrt(getVariance()); }
     
-    // Sell some of this asset
-    double sell(double percentageToSell) {
-        if (percentageToSell <= 0 || percentageToSell > 100) {
-            return 0.0;
+    // Saved state, ring unrolled oldest first so it can be restored verbatim
+    void save(BinaryWriter& out) const {
+        out.put<std::uint64_t>(window);
+        out.put<std::uint64_t>(count);
+        out.put(mean);
+        out.put(m2);
+        out.put(lastPrice);
+        std::vector<double> returns;
+        size_t held = window > 0 ? std::min(count, window) : 0;
+        size_t start = (count >= window) ? ringHead : 0;
+        returns.reserve(held);
+        for (size_t i = 0; i < held; ++i) {
+            returns.push_back(ring[(start + i) % window]);
         }
-        
-        double quantityToSell = quantity * (percentageToSell / 100.0);
-        double saleProceeds = quantityToSell * currentPrice;
-        
-        quantity -= quantityToSell;
-        initialInvestment *= (1.0 - percentageToSell / 100.0);
-        
-        return saleProceeds;
+        out.putArray(returns);
     }
     
-    // Calculate volatility as standard deviation of returns
-    void updateVolatility() {
-        if (priceHistory.size() < 2) {
-            volatility = 0.0;
+    void load(BinaryReader& in) {
+        size_t savedWindow = static_cast<size_t>(in.get<std::uint64_t>());
+        size_t savedCount = static_cast<size_t>(in.get<std::uint64_t>());
+        double savedMean = in.get<double>();
+        double savedM2 = in.get<double>();
+        double savedLast = in.get<double>();
+        std::vector<double> returns = in.getArray<double>();
+        if (!in.ok() || returns.size() != (savedWindow > 0 ? std::min(savedCount, savedWindow) : 0)) {
+            in.fail();
             return;
         }
-        
-        std::vector<double> returns;
-        for (size_t i = 1; i < priceHistory.size(); ++i) {
-            double previousPrice = priceHistory[i-1].second;
-            double currentPrice = priceHistory[i].second;
-            double dailyReturn = (currentPrice - previousPrice) / previousPrice;
-            returns.push_back(dailyReturn);
+        setWindow(savedWindow);
+        std::copy(returns.begin(), returns.end(), ring.begin());
+        ringHead = (window > 0) ? returns.size() % window : 0;
+        count = savedCount;
+        mean = savedMean;
+        m2 = savedM2;
+        lastPrice = savedLast;
+    }
+};
+
+// Columnar price history: epoch-second timestamps and prices in separate
+// contiguous arrays. With a recent-tier capacity the series is a ring buffer;
+// points evicted from it are thinned into an optional coarse tier that keeps
+// every Nth point, so long-running feeds stay bounded in memory.
+class PriceSeries {
+public:
+    struct RetentionPolicy {
+        size_t recentCapacity;  // Full-resolution points kept (0 = unbounded)
+        size_t coarseCapacity;  // Thinned points kept after eviction (0 = none)
+        size_t coarseStride;    // Keep every Nth evicted point
+    };
+
+private:
+    // One retention tier; a ring once it reaches capacity
+    struct Tier {
+        std::vector<std::int64_t> timestamps;
+        std::vector<double> prices;
+        size_t capacity = 0;
+        size_t head = 0;  // Physical index of the oldest point
+
+        size_t size() const { return prices.size(); }
+
+        size_t physical(size_t i) const {
+            size_t j = head + i;
+            return j < prices.size() ? j : j - prices.size();
         }
-        
-        double mean = std::accumulate(returns.begin(), returns.end(), 0.0) / returns.size();
-        
-        double squaredSum = 0.0;
-        for (double ret : returns) {
-            squaredSum += (ret - mean) * (ret - mean);
+
+        // Returns true and reports the overwritten point when the tier was full
+        bool push(std::int64_t timestamp, double price, std::int64_t& evictedTimestamp, double& evictedPrice) {
+            if (capacity == 0 || prices.size() < capacity) {
+                timestamps.push_back(timestamp);
+                prices.push_back(price);
+                return false;
+            }
+
+            evictedTimestamp = timestamps[head];
+            evictedPrice = prices[head];
+            timestamps[head] = timestamp;
+            prices[head] = price;
+            head = (head + 1 == capacity) ? 0 : head + 1;
+            return true;
         }
-        
-        volatility = std::sqrt(squaredSum / returns.size()) * 100.0; // As percentage
+
+        void clear() {
+            timestamps.clear();
+            prices.clear();
+            head = 0;
+        }
+    };
+
+    Tier recent;
+    Tier coarse;
+    size_t coarseStride;
+    size_t evictedCount;
+    size_t appendedCount;
+    std::int64_t firstTimestamp;
+    double firstPrice;
+
+public:
+    explicit PriceSeries(const RetentionPolicy& policy = {0, 0, 1})
+        : coarseStride(1), evictedCount(0), appendedCount(0), firstTimestamp(0), firstPrice(0.0) {
+        applyPolicy(policy);
     }
-    
-    // Display asset details
-    virtual void display() const {
-        std::cout << name << " (" << symbol << "):" << std::endl;
-        std::cout << "  Price: " << Utils::formatCurrency(currentPrice) << std::endl;
-        std::cout << "  Quantity: " << std::fixed << std::setprecision(6) << quantity << std::endl;
-        std::cout << "  Current Value: " << Utils::formatCurrency(getCurrentValue()) << std::endl;
-        std::cout << "  Initial Investment: " << Utils::formatCurrency(initialInvestment) << std::endl;
-        std::cout << "  Return: " << std::fixed << std::setprecision(2) << getReturnPercentage() << "%" << std::endl;
-        std::cout << "  Volatility: " << std::fixed << std::setprecision(2) << volatility << "%" << std::endl;
-        std::cout << std::endl;
+
+    // O(1) append; the oldest point moves to the coarse tier (or is dropped) when full
+    void append(std::int64_t timestamp, double price) {
+        if (appendedCount == 0) {
+            firstTimestamp = timestamp;
+            firstPrice = price;
+        }
+        ++appendedCount;
+
+        std::int64_t evictedTimestamp;
+        double evictedPrice;
+        if (recent.push(timestamp, price, evictedTimestamp, evictedPrice) && coarse.capacity > 0) {
+            if (evictedCount++ % coarseStride == 0) {
+                coarse.push(evictedTimestamp, evictedPrice, evictedTimestamp, evictedPrice);
+            }
+        }
     }
-    
-    // Each asset type might have unique analysis methods
-    virtual std::string getAnalysis() const {
-        std::string analysis = "Analysis for " + name + " (" + symbol + "):\n";
-        
-        if (priceHistory.size() >= 2) {
-            double oldestPrice = priceHistory.front().second;
-            double latestPrice = priceHistory.back().second;
-            double priceChange = Utils::percentChange(oldestPrice, latestPrice);
-            
-            analysis += "  Price change since tracking: " + std::to_string(priceChange) + "%\n";
-            
-            if (priceChange > 0) {
-                analysis += "  The price has increased since tracking began.\n";
-            } else if (priceChange < 0) {
-                analysis += "  The price has decreased since tracking began.\n";
-            } else {
-                analysis += "  The price remains stable since tracking began.\n";
+
+    // Change retention. Full-resolution points that no longer fit are
+    // thinned into the coarse tier; points already in the coarse tier
+    // move across as they are, so nothing is thinned twice
+    void setRetention(const RetentionPolicy& policy) {
+        Tier oldRecent = std::move(recent);
+        Tier oldCoarse = std::move(coarse);
+        size_t appended = appendedCount;
+        std::int64_t inceptionTimestamp = firstTimestamp;
+        double inceptionPrice = firstPrice;
+
+        applyPolicy(policy);
+        std::int64_t evictedTimestamp;
+        double evictedPrice;
+        if (coarse.capacity > 0) {
+            for (size_t i = 0; i < oldCoarse.size(); ++i) {
+                size_t j = oldCoarse.physical(i);
+                coarse.push(oldCoarse.timestamps[j], oldCoarse.prices[j], evictedTimestamp, evictedPrice);
             }
         }
-        
-        if (volatility < 5.0) {
-            analysis += "  Low volatility: This asset has been stable recently.\n";
-        } else if (volatility < 15.0) {
-            analysis += "  Medium volatility: This asset shows moderate price movements.\n";
-        } else {
-            analysis += "  High volatility: This asset has significant price fluctuations.\n";
+        size_t kept = recent.capacity == 0 ? oldRecent.size() : std::min(recent.capacity, oldRecent.size());
+        size_t overflow = oldRecent.size() - kept;
+        for (size_t i = 0; i < oldRecent.size(); ++i) {
+            size_t j = oldRecent.physical(i);
+            if (i >= overflow) {
+                recent.push(oldRecent.timestamps[j], oldRecent.prices[j], evictedTimestamp, evictedPrice);
+            } else if (coarse.capacity > 0 && evictedCount++ % coarseStride == 0) {
+                coarse.push(oldRecent.timestamps[j], oldRecent.prices[j], evictedTimestamp, evictedPrice);
+            }
         }
-        
-        return analysis;
+
+        appendedCount = appended;
+        firstTimestamp = inceptionTimestamp;
+        firstPrice = inceptionPrice;
     }
-};
 
-// SIP (Systematic Investment Plan) - Mutual Funds or Index funds
-class SIP : public Asset {
-private:
-    double expectedAnnualReturn;
-    std::string fundType; // Index, Equity, Debt, etc.
-    double expenseRatio;
+    // Full-resolution tier, index 0 = oldest retained point
+    size_t size() const { return recent.size(); }
+    bool empty() const { return recent.size() == 0; }
+    std::int64_t timestampAt(size_t i) const { return recent.timestamps[recent.physical(i)]; }
+    double priceAt(size_t i) const { return recent.prices[recent.physical(i)]; }
 
-public:
-    SIP(const std::string& name, const std::string& symbol, double currentPrice, 
-        double quantity = 0.0, double expectedAnnualReturn = 12.0, 
-        const std::string& fundType = "Index", double expenseRatio = 0.5)
-        : Asset(name, symbol, currentPrice, quantity),
-          expectedAnnualReturn(expectedAnnualReturn), fundType(fundType), expenseRatio(expenseRatio) {}
+    // Tail access, k = 0 is the latest point
+    double tailPrice(size_t k) const { return priceAt(recent.size() - 1 - k); }
+    double lastPrice() const { return tailPrice(0); }
+    std::int64_t lastTimestamp() const { return timestampAt(recent.size() - 1); }
+
+    // Thinned tier holding older evicted points, index 0 = oldest
+    size_t coarseSize() const { return coarse.size(); }
+    std::int64_t coarseTimestampAt(size_t i) const { return coarse.timestamps[coarse.physical(i)]; }
+    double coarsePriceAt(size_t i) const { return coarse.prices[coarse.physical(i)]; }
+
+    // First point ever appended, kept even after it has been evicted
+    size_t totalAppended() const { return appendedCount; }
+    std::int64_t inceptionTimestamp() const { return firstTimestamp; }
+    double inceptionPrice() const { return firstPrice; }
     
-    // Getters
-    double getExpectedAnnualReturn() const { return expectedAnnualReturn; }
-    std::string getFundType() const { return fundType; }
-    double getExpenseRatio() const { return expenseRatio; }
+    // Override the inception point when older history lives elsewhere (e.g. an archive)
+    void setInception(std::int64_t timestamp, double price, size_t totalPoints) {
+        firstTimestamp = timestamp;
+        firstPrice = price;
+        appendedCount = std::max(appendedCount, totalPoints);
+    }
     
-    // Project growth over years
-    double projectGrowth(int years, double monthlyContribution = 0.0) const {
-        double monthlyRate = (expectedAnnualReturn / 100.0) / 12.0;
-        double totalMonths = years * 12.0;
-        double currentValue = getCurrentValue();
-        
-        // Formula for future value with regular contributions
-        double futureValue = currentValue * std::pow(1 + monthlyRate, totalMonths);
-        
-        if (monthlyContribution > 0) {
-            futureValue += monthlyContribution * ((std::pow(1 + monthlyRate, totalMonths) - 1) / monthlyRate);
+    size_t recentCapacity() const { return recent.capacity; }
+    
+    void clear() {
+        recent.clear();
+        coarse.clear();
+        evictedCount = 0;
+        appendedCount = 0;
+    }
+
+    // Visit the full-resolution tier oldest first as (timestamp, price)
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < recent.size(); ++i) {
+            size_t j = recent.physical(i);
+            fn(recent.timestamps[j], recent.prices[j]);
         }
-        
-        return futureValue;
     }
     
-    // Override display to include SIP-specific details
-    void display() const override {
-        Asset::display();
-        std::cout << "  Fund Type: " << fundType << std::endl;
-        std::cout << "  Expected Annual Return: " << expectedAnnualReturn << "%" << std::endl;
-        std::cout << "  Expense Ratio: " << expenseRatio << "%" << std::endl;
-        
-        // Show projected growth
-        std::cout << "  Projected Value (3 years): " << Utils::formatCurrency(projectGrowth(3, 0)) << std::endl;
-        std::cout << "  Projected Value (5 years): " << Utils::formatCurrency(projectGrowth(5, 0)) << std::endl;
-        std::cout << "  Projected Value (10 years): " << Utils::formatCurrency(projectGrowth(10, 0)) << std::endl;
-        std::cout << std::endl;
+    // Saved state: retention, counters, then each tier unrolled oldest first
+    // so a load is two bulk copies per tier rather than a replay of appends
+    void save(BinaryWriter& out) const {
+        out.put<std::uint64_t>(recent.capacity);
+        out.put<std::uint64_t>(coarse.capacity);
+        out.put<std::uint64_t>(coarseStride);
+        out.put<std::uint64_t>(evictedCount);
+        out.put<std::uint64_t>(appendedCount);
+        out.put(firstTimestamp);
+        out.put(firstPrice);
+        for (const Tier* tier : {&recent, &coarse}) {
+            if (tier->head == 0) {
+                out.putArray(tier->timestamps);
+                out.putArray(tier->prices);
+                continue;
+            }
+            std::vector<std::int64_t> timestamps;
+            std::vector<double> prices;
+            timestamps.reserve(tier->size());
+            prices.reserve(tier->size());
+            for (size_t i = 0; i < tier->size(); ++i) {
+                timestamps.push_back(tier->timestamps[tier->physical(i)]);
+                prices.push_back(tier->prices[tier->physical(i)]);
+            }
+            out.putArray(timestamps);
+            out.putArray(prices);
+        }
     }
     
-    // Override get analysis to include SIP-specific analysis
-    std::string getAnalysis() const override {
-        std::string analysis = Asset::getAnalysis();
-        
-        analysis += "  This is a " + fundType + " fund with an expense ratio of " + 
-                    std::to_string(expenseRatio) + "%.\n";
-        
-        if (expenseRatio > 1.0) {
-            analysis += "  The expense ratio is relatively high. Consider lower-cost alternatives.\n";
-        } else {
-            analysis += "  The expense ratio is reasonable for this type of fund.\n";
+    void load(BinaryReader& in) {
+        RetentionPolicy policy;
+        policy.recentCapacity = static_cast<size_t>(in.get<std::uint64_t>());
+        policy.coarseCapacity = static_cast<size_t>(in.get<std::uint64_t>());
+        policy.coarseStride = static_cast<size_t>(in.get<std::uint64_t>());
+        size_t evicted = static_cast<size_t>(in.get<std::uint64_t>());
+        size_t appended = static_cast<size_t>(in.get<std::uint64_t>());
+        std::int64_t inceptionTimestamp = in.get<std::int64_t>();
+        double inceptionPrice = in.get<double>();
+        
+        applyPolicy(policy);
+        for (Tier* tier : {&recent, &coarse}) {
+            tier->timestamps = in.getArray<std::int64_t>();
+            tier->prices = in.getArray<double>();
+            if (tier->timestamps.size() != tier->prices.size() ||
+                (tier->capacity > 0 && tier->prices.size() > tier->capacity)) {
+                in.fail();
+            }
         }
-        
-        if (expectedAnnualReturn > 15.0) {
-            analysis += "  The expected return seems optimistic. Be prepared for potential underperformance.\n";
+        if (!in.ok()) {
+            applyPolicy(policy);
+            return;
         }
-        
-        return analysis;
+        evictedCount = evicted;
+        appendedCount = appended;
+        firstTimestamp = inceptionTimestamp;
+        firstPrice = inceptionPrice;
+    }
+
+private:
+    void applyPolicy(const RetentionPolicy& policy) {
+        recent.clear();
+        coarse.clear();
+        recent.capacity = policy.recentCapacity;
+        coarse.capacity = policy.coarseCapacity;
+        coarseStride = std::max<size_t>(1, policy.coarseStride);
+        evictedCount = 0;
+        appendedCount = 0;
     }
 };
 
-// Forex trading asset
-class Forex : public Asset {
+// Append-only on-disk price archive for one symbol: a fixed 64-byte header
+// followed by fixed-size (timestamp, price) records in timestamp order.
+// The file is memory-mapped for reads, so ranges are served straight from
+// the mapping without parsing. A Range stays valid until the next append.
+// Appends are buffered and the header is rewritten lazily, so a tick costs
+// no system call; sync() (also run on close) makes everything durable.
+class PriceArchive {
+public:
+    struct Record {
+        std::int64_t timestamp;
+        double price;
+    };
+    
+    struct Range {
+        const Record* first = nullptr;
+        const Record* last = nullptr;
+        
+        const Record* begin() const { return first; }
+        const Record* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+    };
+
 private:
-    std::string baseCurrency;
-    std::string quoteCurrency;
-    double spreadPercentage;
-    std::string trend; // "Bullish", "Bearish", "Neutral"
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t recordSize;
+        std::uint64_t count;
+        std::int64_t firstTimestamp;
+        std::int64_t lastTimestamp;
+        std::uint8_t reserved[24];
+    };
+    static_assert(sizeof(Header) == 64, "PriceArchive header must stay 64 bytes");
+    static_assert(sizeof(Record) == 16, "PriceArchive records must stay 16 bytes");
+    
+    static constexpr char kMagic[8] = {'F', 'A', 'P', 'H', 'I', 'S', 'T', '\0'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr size_t kBufferedRecords = 256;          // Records per write
+    static constexpr std::uint64_t kHeaderEveryRecords = 8192; // Records between header rewrites
+    static constexpr std::int64_t kHeaderEveryMs = 1000;     // ...or at most this long
+    
+    std::string path;
+    int fd;
+    Header header;                      // Counts every appended record, buffered or not
+    mutable std::vector<Record> buffered; // Appended but not yet written
+    mutable std::uint64_t writtenCount; // Records in the file
+    mutable std::uint64_t headerCount;  // Count the on-disk header holds
+    mutable std::int64_t headerWrittenMs;
+    std::uint64_t outOfOrder = 0;       // Points older than the last record, never archived
+    mutable const char* mapping;
+    mutable size_t mappedBytes;
+    mutable std::uint64_t mappedCount;
+    
+    PriceArchive(const std::string& path, int fd, const Header& header)
+        : path(path), fd(fd), header(header), writtenCount(header.count), headerCount(header.count),
+          headerWrittenMs(Clock::nowMillis()), mapping(nullptr), mappedBytes(0), mappedCount(0) {
+        buffered.reserve(kBufferedRecords);
+    }
 
 public:
-    Forex(const std::string& name, const std::string& symbol, double currentPrice, 
-          const std::string& baseCurrency, const std::string& quoteCurrency,
-          double quantity = 0.0, double spreadPercentage = 0.1)
-        : Asset(name, symbol, currentPrice, quantity),
-          baseCurrency(baseCurrency), quoteCurrency(quoteCurrency),
-          spreadPercentage(spreadPercentage), trend("Neutral") {}
+    PriceArchive(const PriceArchive&) = delete;
+    PriceArchive& operator=(const PriceArchive&) = delete;
     
-    // Getters
-    std::string getBaseCurrency() const { return baseCurrency; }
-    std::string getQuoteCurrency() const { return quoteCurrency; }
-    double getSpreadPercentage() const { return spreadPercentage; }
-    std::string getTrend() const { return trend; }
+    ~PriceArchive() {
+#ifndef _WIN32
+        sync();
+        if (outOfOrder > 0) {
+            std::cerr << "Skipped " << outOfOrder << " out-of-order points for price archive: " << path << std::endl;
+        }
+        if (mapping) munmap(const_cast<char*>(mapping), mappedBytes);
+        if (fd >= 0) close(fd);
+#endif
+    }
     
-    // Set trend based on price movement
-    void updateTrend() {
-        if (priceHistory.size() < 5) {
-            trend = "Neutral";
-            return;
+    // Open (or create) the archive at `path`; returns nullptr on failure
+    static std::shared_ptr<PriceArchive> open(const std::string& path) {
+#ifdef _WIN32
+        std::cerr << "Price archive not supported on this platform: " << path << std::endl;
+        return nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            std::cerr << "Failed to open price archive: " << path << std::endl;
+            return nullptr;
         }
         
-        // Calculate average price over last 5 data points
-        double sum = 0.0;
-        for (int i = priceHistory.size() - 5; i < priceHistory.size(); ++i) {
-            sum += priceHistory[i].second;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return nullptr;
         }
-        double avg = sum / 5.0;
         
-        // Compare with current price
-        if (currentPrice > avg * 1.02) {
-            trend = "Bullish";
-        } else if (currentPrice < avg * 0.98) {
-            trend = "Bearish";
+        Header header{};
+        if (st.st_size == 0) {
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = kVersion;
+            header.recordSize = sizeof(Record);
+            if (pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+                std::cerr << "Failed to initialize price archive: " << path << std::endl;
+                close(fd);
+                return nullptr;
+            }
         } else {
-            trend = "Neutral";
+            if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+                header.version != kVersion || header.recordSize != sizeof(Record)) {
+                std::cerr << "Invalid price archive: " << path << std::endl;
+                close(fd);
+                return nullptr;
+            }
+            
+            std::uint64_t onDisk = (static_cast<std::uint64_t>(st.st_size) - sizeof(Header)) / sizeof(Record);
+            header.count = std::min(header.count, onDisk);
+            
+            // Records written after the last header update (the header is
+            // rewritten lazily) are recovered while they stay in order;
+            // anything after the first bad record is overwritten later
+            Record record;
+            while (header.count < onDisk) {
+                off_t offset = static_cast<off_t>(sizeof(Header) + header.count * sizeof(Record));
+                if (pread(fd, &record, sizeof(record), offset) != static_cast<ssize_t>(sizeof(record)) ||
+                    !(record.price > 0.0) || !std::isfinite(record.price) ||
+                    (header.count > 0 && record.timestamp < header.lastTimestamp)) {
+                    break;
+                }
+                if (header.count == 0) header.firstTimestamp = record.timestamp;
+                header.lastTimestamp = record.timestamp;
+                ++header.count;
+            }
         }
+        
+        return std::shared_ptr<PriceArchive>(new PriceArchive(path, fd, header));
+#endif
     }
     
-    // Override price update to also update trend
-    void updateCurrentPrice(double newPrice) {
-        Asset::updateCurrentPrice(newPrice);
-        updateTrend();
+    // Append one record. Points older than the last record are skipped
+    // (counted, and reported on close) so the file stays sorted without
+    // ever storing a point under the wrong time
+    bool append(std::int64_t timestamp, double price) {
+#ifdef _WIN32
+        return false;
+#else
+        if (header.count > 0 && timestamp < header.lastTimestamp) {
+            ++outOfOrder;
+            return false;
+        }
+        
+        buffered.push_back({timestamp, price});
+        if (header.count == 0) header.firstTimestamp = timestamp;
+        header.lastTimestamp = timestamp;
+        ++header.count;
+        
+        if (buffered.size() >= kBufferedRecords && !writeBuffered()) {
+            return false;
+        }
+        if (header.count - headerCount >= kHeaderEveryRecords ||
+            Clock::nowMillis() - headerWrittenMs >= kHeaderEveryMs) {
+            return sync();
+        }
+        return true;
+#endif
     }
     
-    // Override display for Forex-specific details
-    void display() const override {
-        Asset::display();
-        std::cout << "  Pair: " << baseCurrency << "/" << quoteCurrency << std::endl;
-        std::cout << "  Spread: " << spreadPercentage << "%" << std::endl;
-        std::cout << "  Current Trend: " << trend << std::endl;
-        std::cout << std::endl;
+    // Write buffered records, then publish them in the header
+    bool sync() const {
+#ifdef _WIN32
+        return false;
+#else
+        if (!writeBuffered()) return false;
+        headerWrittenMs = Clock::nowMillis();
+        if (headerCount == writtenCount) return true;
+        
+        Header onDisk = header;
+        onDisk.count = writtenCount;
+        if (pwrite(fd, &onDisk, sizeof(onDisk), 0) != static_cast<ssize_t>(sizeof(onDisk))) {
+            std::cerr << "Failed to update price archive header: " << path << std::endl;
+            return false;
+        }
+        headerCount = writtenCount;
+        return true;
+#endif
     }
     
-    // Override get analysis for Forex-specific analysis
-    std::string getAnalysis() const override {
-        std::string analysis = Asset::getAnalysis();
-        
-        analysis += "  This forex pair (" + baseCurrency + "/" + quoteCurrency + ") ";
-        
-        if (trend == "Bullish") {
-            analysis += "is in an uptrend. Consider taking profit or trailing stops.\n";
-        } else if (trend == "Bearish") {
-            analysis += "is in a downtrend. Consider hedging or reducing exposure.\n";
-        } else {
-            analysis += "is in a neutral trend. Monitor for breakout opportunities.\n";
+    // Getters
+    const std::string& getPath() const { return path; }
+    size_t size() const { return static_cast<size_t>(header.count); }
+    bool empty() const { return header.count == 0; }
+    std::int64_t getFirstTimestamp() const { return header.firstTimestamp; }
+    std::int64_t getLastTimestamp() const { return header.lastTimestamp; }
+    std::uint64_t getOutOfOrderCount() const { return outOfOrder; }
+    
+    // All archived records
+    Range records() const {
+        const Record* base = data();
+        return base ? Range{base, base + header.count} : Range{};
+    }
+    
+    // Records with from <= timestamp <= to, found by binary search
+    Range range(std::int64_t from, std::int64_t to) const {
+        Range all = records();
+        auto lower = std::lower_bound(all.first, all.last, from,
+            [](const Record& r, std::int64_t ts) { return r.timestamp < ts; });
+        auto upper = std::upper_bound(lower, all.last, to,
+            [](std::int64_t ts, const Record& r) { return ts < r.timestamp; });
+        return Range{lower, upper};
+    }
+    
+    // Whole days, fromDate/toDate given as YYYY-MM-DD (inclusive)
+    Range range(const std::string& fromDate, const std::string& toDate) const {
+        return range(Utils::parseDate(fromDate), Utils::parseDate(toDate) + 86399);
+    }
+
+private:
+    // Write buffered records in one call after the ones already in the file
+    bool writeBuffered() const {
+#ifdef _WIN32
+        return false;
+#else
+        if (buffered.empty()) return true;
+        
+        size_t bytes = buffered.size() * sizeof(Record);
+        off_t offset = static_cast<off_t>(sizeof(Header) + writtenCount * sizeof(Record));
+        if (pwrite(fd, buffered.data(), bytes, offset) != static_cast<ssize_t>(bytes)) {
+            std::cerr << "Failed to append to price archive: " << path << std::endl;
+            return false;
         }
-        
-        if (volatility > 10.0) {
-            analysis += "  High volatility in this pair suggests caution with position sizing.\n";
+        writtenCount += buffered.size();
+        buffered.clear();
+        return true;
+#endif
+    }
+    
+    // Map (or remap) the file so it covers every appended record
+    const Record* data() const {
+#ifdef _WIN32
+        return nullptr;
+#else
+        if (header.count == 0 || !writeBuffered()) return nullptr;
+        
+        if (mappedCount != writtenCount) {
+            if (mapping) munmap(const_cast<char*>(mapping), mappedBytes);
+            mappedBytes = sizeof(Header) + writtenCount * sizeof(Record);
+            void* addr = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                std::cerr << "Failed to map price archive: " << path << std::endl;
+                mapping = nullptr;
+                mappedBytes = 0;
+                mappedCount = 0;
+                return nullptr;
+            }
+            mapping = static_cast<const char*>(addr);
+            mappedCount = writtenCount;
         }
         
-        return analysis;
+        return reinterpret_cast<const Record*>(mapping + sizeof(Header));
+#endif
     }
 };
 
-// Cryptocurrency asset
-class Cryptocurrency : public Asset {
+// Streaming technical indicator: updated once per price tick in O(1) time
+// with fixed memory, so no indicator ever rescans price history
+class Indicator {
+public:
+    virtual ~Indicator() = default;
+    virtual void update(double price) = 0;
+    virtual void reset() = 0;  // Back to the freshly constructed state
+    virtual bool isReady() const = 0;
+    virtual double value() const = 0;
+    virtual std::string getName() const = 0;
+};
+
+// Simple moving average over the last `period` prices
+class SMAIndicator : public Indicator {
 private:
-    double marketCap;
-    std::string networkStatus; // "Healthy", "Congested", etc.
-    bool isStaking;
-    double stakingYield;
+    size_t period;
+    std::vector<double> window;
+    size_t head;
+    size_t count;
+    double sum;
 
 public:
-    Cryptocurrency(const std::string& name, const std::string& symbol, double currentPrice, 
-                  double marketCap, double quantity = 0.0, bool isStaking = false, 
-                  double stakingYield = 0.0)
-        : Asset(name, symbol, currentPrice, quantity),
-          marketCap(marketCap), networkStatus("Healthy"),
-          isStaking(isStaking), stakingYield(stakingYield) {}
+    explicit SMAIndicator(size_t period)
+        : period(std::max<size_t>(1, period)), window(this->period, 0.0), head(0), count(0), sum(0.0) {}
     
-    // Getters
-    double getMarketCap() const { return marketCap; }
-    std::string getNetworkStatus() const { return networkStatus; }
-    bool getIsStaking() const { return isStaking; }
-    double getStakingYield() const { return stakingYield; }
-    
-    // Update market cap based on new price
-    void updateMarketCap() {
-        // Simplified - in reality would need to know total supply
-        double ratio = currentPrice / priceHistory.front().second;
-        marketCap *= ratio;
-    }
-    
-    // Enable staking
-    void enableStaking(double yield) {
-        isStaking = true;
-        stakingYield = yield;
+    void update(double price) override {
+        if (count == period) {
+            sum -= window[head];
+        } else {
+            ++count;
+        }
+        window[head] = price;
+        sum += price;
+        head = (head + 1) % period;
     }
     
-    // Disable staking
-    void disableStaking() {
-        isStaking = false;
-        stakingYield = 0.0;
+    void reset() override {
+        std::fill(window.begin(), window.end(), 0.0);
+        head = count = 0;
+        sum = 0.0;
     }
     
-    // Calculate staking rewards
-    double calculateStakingRewards(int days) const {
-        if (!isStaking || stakingYield <= 0) return 0.0;
-        
-        double dailyRate = stakingYield / 365.0;
-        return getCurrentValue() * (std::pow(1 + dailyRate / 100.0, days) - 1);
-    }
+    bool isReady() const override { return count == period; }
+    double value() const override { return count > 0 ? sum / count : 0.0; }
+    std::string getName() const override { return "SMA(" + std::to_string(period) + ")"; }
+};
+
+// Exponential moving average, seeded with the SMA of the first `period` prices
+class EMAIndicator : public Indicator {
+private:
+    size_t period;
+    double alpha;
+    size_t count;
+    double ema;
+
+public:
+    explicit EMAIndicator(size_t period)
+        : period(std::max<size_t>(1, period)), alpha(2.0 / (this->period + 1.0)), count(0), ema(0.0) {}
     
-    // Override display for crypto-specific details
-    void display() const override {
-        Asset::display();
-        std::cout << "  Market Cap: " << Utils::formatCurrency(marketCap) << std::endl;
-        std::cout << "  Network Status: " << networkStatus << std::endl;
-        
-        if (isStaking) {
-            std::cout << "  Staking Enabled: Yes" << std::endl;
-            std::cout << "  Staking Yield: " << stakingYield << "% APY" << std::endl;
-            std::cout << "  Projected Staking Reward (30 days): " 
-                      << Utils::formatCurrency(calculateStakingRewards(30)) << std::endl;
+    void update(double price) override {
+        if (count < period) {
+            ++count;
+            ema += (price - ema) / count;  // Running mean until seeded
         } else {
-            std::cout << "  Staking Enabled: No" << std::endl;
+            ema += alpha * (price - ema);
         }
-        
-        std::cout << std::endl;
+    }
+    
+    void reset() override {
+        count = 0;
+        ema = 0.0;
+    }
+    
+    bool isReady() const override { return count >= period; }
+    double value() const override { return ema; }
+    std::string getName() const override { return "EMA(" + std::to_string(period) + ")"; }
+};
+
+// Wilder-smoothed average of a non-negative per-tick quantity
+class WilderAverage {
+private:
+    size_t period;
+    size_t count;
+    double average;
+
+public:
+    explicit WilderAverage(size_t period) : period(std::max<size_t>(1, period)), count(0), average(0.0) {}
+    
+    void update(double x) {
+        if (count < period) {
+            ++count;
+            average += (x - average) / count;
+        } else {
+            average = (average * (period - 1) + x) / period;
+        }
+    }
+    
+    void reset() {
+        count = 0;
+        average = 0.0;
+    }
+    
+    bool isReady() const { return count >= period; }
+    double value() const { return average; }
+};
+
+// Relative Strength Index (0-100) with Wilder smoothing
+class RSIIndicator : public Indicator {
+private:
+    size_t period;
+    WilderAverage gains;
+    WilderAverage losses;
+    double lastPrice;
+    bool hasLast;
+
+public:
+    explicit RSIIndicator(size_t period = 14)
+        : period(period), gains(period), losses(period), lastPrice(0.0), hasLast(false) {}
+    
+    void update(double price) override {
+        if (hasLast) {
+            double change = price - lastPrice;
+            gains.update(change > 0 ? change : 0.0);
+            losses.update(change < 0 ? -change : 0.0);
+        }
+        lastPrice = price;
+        hasLast = true;
+    }
+    
+    void reset() override {
+        gains.reset();
+        losses.reset();
+        lastPrice = 0.0;
+        hasLast = false;
+    }
+    
+    bool isReady() const override { return gains.isReady(); }
+    
+    double value() const override {
+        if (losses.value() <= 0.0) {
+            return gains.value() > 0.0 ? 100.0 : 50.0;
+        }
+        double rs = gains.value() / losses.value();
+        return 100.0 - 100.0 / (1.0 + rs);
+    }
+    
+    std::string getName() const override { return "RSI(" + std::to_string(period) + ")"; }
+};
+
+// MACD line (fast EMA - slow EMA) with its signal line and histogram
+class MACDIndicator : public Indicator {
+private:
+    EMAIndicator fast;
+    EMAIndicator slow;
+    EMAIndicator signal;
+    std::string name;
+
+public:
+    MACDIndicator(size_t fastPeriod = 12, size_t slowPeriod = 26, size_t signalPeriod = 9)
+        : fast(fastPeriod), slow(slowPeriod), signal(signalPeriod),
+          name("MACD(" + std::to_string(fastPeriod) + "," + std::to_string(slowPeriod) + "," +
+               std::to_string(signalPeriod) + ")") {}
+    
+    void update(double price) override {
+        fast.update(price);
+        slow.update(price);
+        if (slow.isReady()) {
+            signal.update(value());
+        }
+    }
+    
+    void reset() override {
+        fast.reset();
+        slow.reset();
+        signal.reset();
+    }
+    
+    bool isReady() const override { return signal.isReady(); }
+    double value() const override { return fast.value() - slow.value(); }
+    std::string getName() const override { return name; }
+    
+    double getSignal() const { return signal.value(); }
+    double getHistogram() const { return value() - signal.value(); }
+};
+
+// Bollinger bands: SMA of the last `period` prices +/- k standard deviations
+class BollingerIndicator : public Indicator {
+private:
+    size_t period;
+    double k;
+    ReturnStats moments;  // Windowed mean/variance, fed prices rather than returns
+
+public:
+    explicit BollingerIndicator(size_t period = 20, double k = 2.0)
+        : period(period), k(k), moments(std::max<size_t>(1, period)) {}
+    
+    void update(double price) override { moments.addReturn(price); }
+    void reset() override { moments.reset(); }
+    
+    bool isReady() const override { return moments.getCount() >= period; }
+    double value() const override { return moments.getMean(); }
+    std::string getName() const override { return "Bollinger(" + std::to_string(period) + ")"; }
+    
+    double getUpper() const { return moments.getMean() + k * moments.getStdDev(); }
+    double getLower() const { return moments.getMean() - k * moments.getStdDev(); }
+    
+    // Position of a price within the bands: 0 = lower band, 1 = upper band
+    double percentB(double price) const {
+        double width = getUpper() - getLower();
+        return width > 0.0 ? (price - getLower()) / width : 0.5;
+    }
+};
+
+// ATR-style range from close-only ticks: Wilder average of |price change|
+class ATRIndicator : public Indicator {
+private:
+    size_t period;
+    WilderAverage range;
+    double lastPrice;
+    bool hasLast;
+
+public:
+    explicit ATRIndicator(size_t period = 14)
+        : period(period), range(period), lastPrice(0.0), hasLast(false) {}
+    
+    void update(double price) override {
+        if (hasLast) {
+            range.update(std::abs(price - lastPrice));
+        }
+        lastPrice = price;
+        hasLast = true;
+    }
+    
+    void reset() override {
+        range.reset();
+        lastPrice = 0.0;
+        hasLast = false;
+    }
+    
+    bool isReady() const override { return range.isReady(); }
+    double value() const override { return range.value(); }
+    std::string getName() const override { return "ATR(" + std::to_string(period) + ")"; }
+    
+    // Range as a percentage of the latest price
+    double getPercent() const { return lastPrice > 0.0 ? range.value() / lastPrice * 100.0 : 0.0; }
+};
+
+// Indicators attached to one asset; all are updated together on each tick
+class IndicatorSet {
+private:
+    std::vector<std::unique_ptr<Indicator>> indicators;
+
+public:
+    // Attach an indicator, warmed up from existing history; the returned
+    // reference stays valid for the lifetime of the set
+    template <typename T, typename... Args>
+    T& add(const PriceSeries& history, Args&&... args) {
+        auto indicator = std::make_unique<T>(std::forward<Args>(args)...);
+        T& ref = *indicator;
+        history.forEach([&](std::int64_t, double price) { ref.update(price); });
+        indicators.push_back(std::move(indicator));
+        return ref;
+    }
+    
+    void update(double price) {
+        for (auto& indicator : indicators) {
+            indicator->update(price);
+        }
+    }
+    
+    // Forget every price seen, keeping the indicators attached
+    void reset() {
+        for (auto& indicator : indicators) {
+            indicator->reset();
+        }
+    }
+    
+    size_t size() const { return indicators.size(); }
+    const Indicator& at(size_t i) const { return *indicators[i]; }
+};
+
+// Per-acquisition ledger behind one position. Each buy opens a lot
+// (acquisition time, quantity, unit cost); a sell relieves lots FIFO, LIFO,
+// highest cost first or from one named lot. Lots live in parallel arrays;
+// a lot's id is its index plus the number of closed lots compacted away
+// in front of it, so ids stay stable. A Fenwick tree over "lot is open"
+// flags finds the oldest or newest open lot, and a max-heap on unit cost
+// finds the costliest, so each relieved lot costs O(log n) however many
+// SIP lots have accumulated. Closed lots leave stale heap entries, which
+// are dropped when they surface and swept out once they are half the
+// heap. Open quantity, open cost and realised gains are running totals, so
+// P&L queries never rescan. Saved state starts at the oldest open lot.
+class LotLedger {
+public:
+    enum class Relief : std::uint8_t { FIFO = 0, LIFO = 1, HighestCost = 2, Specific = 3 };
+    
+    struct Lot {
+        std::int64_t acquired;  // Epoch seconds
+        double quantity;        // Still held
+        double unitCost;
+    };
+    
+    // Outcome of one sell
+    struct Relieved {
+        double quantity = 0.0;
+        double cost = 0.0;            // Cost basis of the quantity sold
+        double shortTermGain = 0.0;   // Lots held under a year
+        double longTermGain = 0.0;
+        size_t lotsClosed = 0;
+    };
+    
+    static constexpr std::int64_t kLongTermSeconds = 365 * 86400;
+    
+    static std::string reliefName(Relief method) {
+        switch (method) {
+            case Relief::FIFO: return "FIFO";
+            case Relief::LIFO: return "LIFO";
+            case Relief::HighestCost: return "highest cost";
+            case Relief::Specific: return "specific lot";
+            default: return "Unknown";
+        }
+    }
+
+private:
+    std::vector<std::int64_t> acquired;
+    std::vector<double> quantities;
+    std::vector<double> unitCosts;
+    std::vector<std::int32_t> openTree;  // Fenwick tree, 1-based, over open flags
+    std::vector<std::pair<double, std::uint32_t>> costHeap;  // (unit cost, index), max-heap
+    size_t staleCosts = 0;      // Heap entries of closed lots
+    std::uint32_t firstId = 0;  // Id of index 0; lower ids were closed and compacted away
+    size_t openLots = 0;
+    double openQuantity = 0.0;
+    double openCost = 0.0;
+    double realizedShortTerm = 0.0;
+    double realizedLongTerm = 0.0;
+    
+    // Fenwick point update at 0-based lot index
+    void updateOpen(size_t lot, std::int32_t delta) {
+        for (size_t i = lot + 1; i <= openTree.size(); i += i & (~i + 1)) {
+            openTree[i - 1] += delta;
+        }
+    }
+    
+    std::int32_t openBefore(size_t end) const {
+        std::int32_t sum = 0;
+        for (size_t i = end; i > 0; i -= i & (~i + 1)) {
+            sum += openTree[i - 1];
+        }
+        return sum;
+    }
+    
+    // 0-based index of the k-th open lot (1-based k), by binary lifting
+    size_t kthOpen(std::int32_t k) const {
+        size_t position = 0;
+        size_t step = 1;
+        while (step * 2 <= openTree.size()) step *= 2;
+        for (; step > 0; step /= 2) {
+            if (position + step <= openTree.size() && openTree[position + step - 1] < k) {
+                position += step;
+                k -= openTree[position - 1];
+            }
+        }
+        return position;
+    }
+    
+    static constexpr size_t kNoLot = std::numeric_limits<size_t>::max();
+    
+    // Next lot to relieve under `method`, or kNoLot when none is open
+    size_t nextLot(Relief method) {
+        if (openLots == 0) return kNoLot;
+        switch (method) {
+            case Relief::LIFO:
+                return kthOpen(static_cast<std::int32_t>(openLots));
+            case Relief::HighestCost:
+                while (!costHeap.empty() && quantities[costHeap.front().second] <= 0.0) {
+                    std::pop_heap(costHeap.begin(), costHeap.end());
+                    costHeap.pop_back();
+                    --staleCosts;
+                }
+                return costHeap.empty() ? kNoLot : costHeap.front().second;
+            default:
+                return kthOpen(1);
+        }
+    }
+    
+    // Take up to `wanted` from one lot; closes it when (nearly) exhausted
+    double take(size_t lot, double wanted, double price, std::int64_t when, Relieved& result) {
+        double held = quantities[lot];
+        double taken = std::min(wanted, held);
+        if (held - taken <= held * 1e-12) taken = held;
+        
+        double cost = taken * unitCosts[lot];
+        double gain = taken * price - cost;
+        if (when - acquired[lot] >= kLongTermSeconds) {
+            result.longTermGain += gain;
+        } else {
+            result.shortTermGain += gain;
+        }
+        result.quantity += taken;
+        result.cost += cost;
+        
+        quantities[lot] = held - taken;
+        if (taken == held) {
+            quantities[lot] = 0.0;
+            updateOpen(lot, -1);
+            --openLots;
+            ++result.lotsClosed;
+            ++staleCosts;
+        }
+        return taken;
+    }
+    
+    // Drop closed lots' heap entries once they make up half the heap
+    void pruneCostHeap() {
+        if (staleCosts < 64 || staleCosts * 2 < costHeap.size()) return;
+        costHeap.erase(std::remove_if(costHeap.begin(), costHeap.end(),
+                                      [this](const auto& entry) { return quantities[entry.second] <= 0.0; }),
+                       costHeap.end());
+        std::make_heap(costHeap.begin(), costHeap.end());
+        staleCosts = 0;
+    }
+    
+    // Index of the oldest open lot; everything before it is closed
+    size_t firstOpenIndex() const {
+        return openLots > 0 ? kthOpen(1) : quantities.size();
+    }
+    
+    // Rebuild the open-lot index and cost heap from the lot arrays
+    void rebuildIndex() {
+        openTree.assign(quantities.size(), 0);
+        costHeap.clear();
+        staleCosts = 0;
+        openLots = 0;
+        // O(n) Fenwick build: each node passes its sum to its parent
+        for (size_t i = 0; i < quantities.size(); ++i) {
+            if (quantities[i] > 0.0) {
+                ++openTree[i];
+                ++openLots;
+                costHeap.emplace_back(unitCosts[i], static_cast<std::uint32_t>(i));
+            }
+            size_t parent = (i + 1) + ((i + 1) & (~(i + 1) + 1));
+            if (parent <= openTree.size()) openTree[parent - 1] += openTree[i];
+        }
+        std::make_heap(costHeap.begin(), costHeap.end());
+    }
+
+public:
+    // Open a lot; returns its id
+    std::uint32_t add(std::int64_t timestamp, double quantity, double unitCost) {
+        std::uint32_t lot = static_cast<std::uint32_t>(quantities.size());
+        std::uint32_t id = firstId + lot;
+        acquired.push_back(timestamp);
+        quantities.push_back(quantity);
+        unitCosts.push_back(unitCost);
+        
+        // Fenwick append: the new node covers (n + 1 - lowbit, n + 1]
+        size_t node = quantities.size();
+        size_t low = node - (node & (~node + 1));
+        openTree.push_back(1 + openBefore(node - 1) - openBefore(low));
+        
+        costHeap.emplace_back(unitCost, lot);
+        std::push_heap(costHeap.begin(), costHeap.end());
+        ++openLots;
+        openQuantity += quantity;
+        openCost += quantity * unitCost;
+        return id;
+    }
+    
+    // Sell `quantity` at `price` at time `when`; Specific relieves only `lot`
+    Relieved relieve(double quantity, double price, std::int64_t when, Relief method, std::uint32_t lot = 0) {
+        Relieved result;
+        if (method == Relief::Specific) {
+            if (isOpen(lot)) {
+                take(lot - firstId, quantity, price, when, result);
+            }
+        } else {
+            double remaining = quantity;
+            while (remaining > 0.0) {
+                size_t next = nextLot(method);
+                if (next == kNoLot) break;
+                remaining -= take(next, remaining, price, when, result);
+                if (remaining <= quantity * 1e-12) break;
+            }
+        }
+        pruneCostHeap();
+        
+        openQuantity -= result.quantity;
+        openCost -= result.cost;
+        if (openLots == 0) {
+            openQuantity = 0.0;
+            openCost = 0.0;
+        }
+        realizedShortTerm += result.shortTermGain;
+        realizedLongTerm += result.longTermGain;
+        return result;
+    }
+    
+    // Getters
+    size_t size() const { return quantities.size(); }  // Lots held in memory, open or closed
+    size_t openLotCount() const { return openLots; }
+    Lot lot(std::uint32_t id) const {
+        size_t i = id - firstId;
+        return {acquired[i], quantities[i], unitCosts[i]};
+    }
+    bool isOpen(std::uint32_t id) const {
+        return id >= firstId && id - firstId < quantities.size() && quantities[id - firstId] > 0.0;
+    }
+    double getOpenQuantity() const { return openQuantity; }
+    double getOpenCost() const { return openCost; }
+    double averageCost() const { return openQuantity > 0.0 ? openCost / openQuantity : 0.0; }
+    double getRealizedShortTerm() const { return realizedShortTerm; }
+    double getRealizedLongTerm() const { return realizedLongTerm; }
+    double getRealizedGain() const { return realizedShortTerm + realizedLongTerm; }
+    double unrealizedGain(double price) const { return openQuantity * price - openCost; }
+    
+    // Visit open lots oldest first as (lot id, lot)
+    template <typename Fn>
+    void forEachOpen(Fn&& fn) const {
+        for (size_t i = firstOpenIndex(); i < quantities.size(); ++i) {
+            if (quantities[i] > 0.0) fn(static_cast<std::uint32_t>(firstId + i), Lot{acquired[i], quantities[i], unitCosts[i]});
+        }
+    }
+    
+    void clear() {
+        acquired.clear();
+        quantities.clear();
+        unitCosts.clear();
+        openTree.clear();
+        costHeap.clear();
+        staleCosts = 0;
+        firstId = 0;
+        openLots = 0;
+        openQuantity = openCost = realizedShortTerm = realizedLongTerm = 0.0;
+    }
+    
+    // Saved state: the lots from the oldest open one on, the id it has and
+    // the running totals; the index is rebuilt
+    void save(BinaryWriter& out) const {
+        size_t first = firstOpenIndex();
+        out.put<std::uint32_t>(static_cast<std::uint32_t>(firstId + first));
+        out.putArray(std::vector<std::int64_t>(acquired.begin() + first, acquired.end()));
+        out.putArray(std::vector<double>(quantities.begin() + first, quantities.end()));
+        out.putArray(std::vector<double>(unitCosts.begin() + first, unitCosts.end()));
+        out.put(openQuantity);
+        out.put(openCost);
+        out.put(realizedShortTerm);
+        out.put(realizedLongTerm);
+    }
+    
+    void load(BinaryReader& in) {
+        clear();
+        // States before version 3 kept every lot from id 0
+        std::uint32_t savedFirstId = in.getVersion() >= 3 ? in.get<std::uint32_t>() : 0;
+        acquired = in.getArray<std::int64_t>();
+        quantities = in.getArray<double>();
+        unitCosts = in.getArray<double>();
+        double savedQuantity = in.get<double>();
+        double savedCost = in.get<double>();
+        realizedShortTerm = in.get<double>();
+        realizedLongTerm = in.get<double>();
+        if (!in.ok() || acquired.size() != quantities.size() || unitCosts.size() != quantities.size()) {
+            in.fail();
+            clear();
+            return;
+        }
+        
+        // Older states may still start with closed lots
+        size_t first = 0;
+        while (first < quantities.size() && quantities[first] <= 0.0) ++first;
+        acquired.erase(acquired.begin(), acquired.begin() + first);
+        quantities.erase(quantities.begin(), quantities.begin() + first);
+        unitCosts.erase(unitCosts.begin(), unitCosts.begin() + first);
+        firstId = savedFirstId + static_cast<std::uint32_t>(first);
+        
+        rebuildIndex();
+        openQuantity = savedQuantity;
+        openCost = savedCost;
+    }
+};
+
+// Base class for all assets
+class Asset {
+protected:
+    std::string name;
+    std::string symbol;
+    double currentPrice;
+    double quantity;
+    double initialInvestment;
+    PriceSeries priceHistory;  // Epoch timestamp, Price
+    std::shared_ptr<PriceArchive> archive;  // Optional on-disk history
+    ReturnStats returnStats;
+    IndicatorSet indicators;
+    double volatility;  // Measured as standard deviation of returns
+    LotLedger lots;     // One lot per purchase; quantity and initialInvestment are its totals
+    LotLedger::Relief lotRelief = LotLedger::Relief::FIFO;  // Lots sold first by sell()
+    
+    // Relieve lots and shrink the aggregate position; returns the proceeds
+    double relieve(double quantityToSell, double price, std::int64_t timestamp,
+                   LotLedger::Relief method, std::uint32_t lot = 0) {
+        LotLedger::Relieved relieved = lots.relieve(quantityToSell, price, timestamp, method, lot);
+        quantity -= relieved.quantity;
+        initialInvestment -= relieved.cost;
+        if (lots.openLotCount() == 0) {
+            quantity = 0.0;
+            initialInvestment = 0.0;
+        }
+        return relieved.quantity * price;
+    }
+
+public:
+    Asset(const std::string& name, const std::string& symbol, double currentPrice, double quantity = 0.0)
+        : name(name), symbol(symbol), currentPrice(currentPrice), quantity(quantity), 
+          initialInvestment(currentPrice * quantity), priceHistory(defaultRetention()), volatility(0.0) {
+        
+        // Add initial price to history
+        if (currentPrice > 0) {
+            priceHistory.append(Clock::now(), currentPrice);
+            returnStats.addPrice(currentPrice);
+        }
+        
+        // An opening position is the first lot
+        if (quantity > 0 && currentPrice > 0) {
+            lots.add(Clock::now(), quantity, currentPrice);
+        }
+    }
+    
+    virtual ~Asset() = default;
+    
+    // Getters
+    std::string getName() const { return name; }
+    std::string getSymbol() const { return symbol; }
+    double getCurrentPrice() const { return currentPrice; }
+    double getQuantity() const { return quantity; }
+    double getCurrentValue() const { return currentPrice * quantity; }
+    double getInitialInvestment() const { return initialInvestment; }
+    double getVolatility() const { return volatility; }
+    const ReturnStats& getReturnStats() const { return returnStats; }
+    const PriceSeries& getPriceHistory() const { return priceHistory; }
+    std::shared_ptr<const PriceArchive> getArchive() const { return archive; }
+    const IndicatorSet& getIndicators() const { return indicators; }
+    const LotLedger& getLots() const { return lots; }
+    LotLedger::Relief getLotRelief() const { return lotRelief; }
+    double getRealizedGain() const { return lots.getRealizedGain(); }
+    double getUnrealizedGain() const { return lots.unrealizedGain(currentPrice); }
+    
+    // Which lots sell() relieves first (Specific is only used by sellLot)
+    void setLotRelief(LotLedger::Relief method) {
+        if (method != LotLedger::Relief::Specific) lotRelief = method;
+    }
+    
+    // Attach a streaming indicator, e.g. asset.attachIndicator<EMAIndicator>(20)
+    template <typename T, typename... Args>
+    T& attachIndicator(Args&&... args) {
+        return indicators.add<T>(priceHistory, std::forward<Args>(args)...);
+    }
+    
+    // Default bound on in-memory history: ~8k full-resolution ticks plus
+    // every 32nd older tick
+    static PriceSeries::RetentionPolicy defaultRetention() {
+        return {8192, 8192, 32};
+    }
+    
+    // Price history operations
+    void addPricePoint(std::int64_t timestamp, double price) {
+        if (archive) {
+            archive->append(timestamp, price);
+        }
+        priceHistory.append(timestamp, price);
+        returnStats.addPrice(price);
+        indicators.update(price);
+        updateVolatility();
+        onPriceUpdate();
+    }
+    
+    void addPricePoint(const std::string& date, double price) {
+        addPricePoint(Utils::parseDate(date), price);
+    }
+    
+    void setHistoryRetention(const PriceSeries::RetentionPolicy& policy) {
+        priceHistory.setRetention(policy);
+    }
+    
+    // Attach an on-disk archive: archived history is loaded from the mapping
+    // first, then points seen so far in this session are appended to it.
+    // Points the archive already covers (e.g. restored from a saved state)
+    // are not appended twice.
+    void attachArchive(std::shared_ptr<PriceArchive> newArchive) {
+        if (!newArchive) return;
+        
+        std::vector<PriceArchive::Record> sessionPoints;
+        bool covered = !newArchive->empty();
+        std::int64_t archivedUntil = newArchive->getLastTimestamp();
+        priceHistory.forEach([&](std::int64_t timestamp, double price) {
+            if (!covered || timestamp > archivedUntil) {
+                sessionPoints.push_back({timestamp, price});
+            }
+        });
+        
+        archive = std::move(newArchive);
+        PriceArchive::Range records = archive->records();
+        size_t count = records.size();
+        
+        // History restored from saved state that ends where the archive ends
+        // is already in sync; only the inception point comes from the archive
+        if (covered && sessionPoints.empty() && !priceHistory.empty() && count > 0 &&
+            priceHistory.lastTimestamp() == archivedUntil) {
+            priceHistory.setInception(records.first->timestamp, records.first->price, count);
+            return;
+        }
+        
+        priceHistory.clear();
+        returnStats.reset();
+        indicators.reset();
+        
+        size_t window = returnStats.getWindow();
+        size_t statsStart = (window > 0 && count > window + 1) ? count - (window + 1) : 0;
+        size_t capacity = priceHistory.recentCapacity();
+        size_t seriesStart = (capacity > 0 && count > capacity) ? count - capacity : 0;
+        
+        for (size_t i = std::min(statsStart, seriesStart); i < count; ++i) {
+            const PriceArchive::Record& record = records.first[i];
+            if (i >= statsStart) returnStats.addPrice(record.price);
+            if (i >= seriesStart) {
+                priceHistory.append(record.timestamp, record.price);
+                indicators.update(record.price);
+            }
+        }
+        if (count > 0) {
+            priceHistory.setInception(records.first->timestamp, records.first->price, count);
+        }
+        
+        for (const auto& point : sessionPoints) {
+            addPricePoint(point.timestamp, point.price);
+        }
+        updateVolatility();
+    }
+
+    // Restrict volatility to the last `window` returns (0 = all history)
+    void setVolatilityWindow(size_t window) {
+        returnStats.setWindow(window);
+
+        size_t start = 0;
+        if (window > 0 && priceHistory.size() > window + 1) {
+            start = priceHistory.size() - (window + 1);
+        }
+        for (size_t i = start; i < priceHistory.size(); ++i) {
+            returnStats.addPrice(priceHistory.priceAt(i));
+        }
+
+        updateVolatility();
+    }
+    
+    void updateCurrentPrice(double newPrice) {
+        updateCurrentPrice(newPrice, Clock::now());
+    }
+    
+    // Price observed at `timestamp` (epoch seconds), e.g. a replayed tick
+    void updateCurrentPrice(double newPrice, std::int64_t timestamp) {
+        currentPrice = newPrice;
+        addPricePoint(timestamp, newPrice);
+    }
+    
+    double getReturnPercentage() const {
+        if (initialInvestment == 0) return 0.0;
+        return ((getCurrentValue() - initialInvestment) / initialInvestment) * 100.0;
+    }
+    
+    // Buy more of this asset; each purchase opens a lot
+    void buy(double investmentAmount) {
+        buy(investmentAmount, currentPrice, Clock::now());
+    }
+    
+    // Buy at a given execution price and time, e.g. one replayed from the journal
+    void buy(double investmentAmount, double price, std::int64_t timestamp) {
+        double additionalQuantity = investmentAmount / price;
+        quantity += additionalQuantity;
+        initialInvestment += investmentAmount;
+        lots.add(timestamp, additionalQuantity, price);
+    }
+    
+    // Sell some of this asset; the cost basis sold is that of the lots
+    // relieved under the asset's relief method
+    double sell(double percentageToSell) {
+        return sell(percentageToSell, currentPrice, Clock::now(), lotRelief);
+    }
+    
+    double sell(double percentageToSell, double price, std::int64_t timestamp, LotLedger::Relief method) {
+        if (percentageToSell <= 0 || percentageToSell > 100 || method == LotLedger::Relief::Specific) {
+            return 0.0;
+        }
+        return relieve(quantity * (percentageToSell / 100.0), price, timestamp, method);
+    }
+    
+    // Sell up to `quantityToSell` from one lot
+    double sellLot(std::uint32_t lot, double quantityToSell, double price, std::int64_t timestamp) {
+        if (quantityToSell <= 0) return 0.0;
+        return relieve(quantityToSell, price, timestamp, LotLedger::Relief::Specific, lot);
+    }
+    
+    // Hook for subclasses to refresh derived state after each price point
+    virtual void onPriceUpdate() {}
+    
+    // Saved position and history; subclass parameters are written by AssetCodec
+    void saveState(BinaryWriter& out) const {
+        out.put(currentPrice);
+        out.put(quantity);
+        out.put(initialInvestment);
+        priceHistory.save(out);
+        returnStats.save(out);
+        out.put<std::uint8_t>(static_cast<std::uint8_t>(lotRelief));
+        lots.save(out);
+    }
+    
+    // Restore onto a freshly constructed asset. History and return statistics
+    // are copied back as saved, so volatility is correct immediately; the
+    // indicators are rebuilt from the retained history.
+    void restoreState(BinaryReader& in) {
+        currentPrice = in.get<double>();
+        quantity = in.get<double>();
+        initialInvestment = in.get<double>();
+        priceHistory.load(in);
+        returnStats.load(in);
+        if (in.getVersion() >= 2) {
+            std::uint8_t relief = in.get<std::uint8_t>();
+            if (relief > static_cast<std::uint8_t>(LotLedger::Relief::HighestCost)) in.fail();
+            lotRelief = static_cast<LotLedger::Relief>(relief);
+            lots.load(in);
+        } else if (quantity > 0 && currentPrice > 0) {
+            // States saved before lots were tracked hold one lot at average cost
+            lots.clear();
+            lots.add(priceHistory.inceptionTimestamp(), quantity, initialInvestment / quantity);
+        }
+        if (!in.ok()) return;
+        
+        priceHistory.forEach([&](std::int64_t, double price) { indicators.update(price); });
+        updateVolatility();
+        onPriceUpdate();
+    }
+    
+    // Volatility as standard deviation of returns, read from the streaming stats
+    void updateVolatility() {
+        volatility = returnStats.getStdDev() * 100.0; // As percentage
+    }
+    
+    // Display asset details
+    virtual void display() const {
+        std::cout << name << " (" << symbol << "):" << std::endl;
+        std::cout << "  Price: " << Utils::formatCurrency(currentPrice) << std::endl;
+        std::cout << "  Quantity: " << std::fixed << std::setprecision(6) << quantity << std::endl;
+        std::cout << "  Current Value: " << Utils::formatCurrency(getCurrentValue()) << std::endl;
+        std::cout << "  Initial Investment: " << Utils::formatCurrency(initialInvestment) << std::endl;
+        std::cout << "  Return: " << std::fixed << std::setprecision(2) << getReturnPercentage() << "%" << std::endl;
+        std::cout << "  Volatility: " << std::fixed << std::setprecision(2) << volatility << "%" << std::endl;
+        std::cout << "  Open Lots: " << lots.openLotCount() << " (" << LotLedger::reliefName(lotRelief)
+                  << " relief), average cost " << Utils::formatCurrency(lots.averageCost()) << std::endl;
+        std::cout << "  Unrealized Gain: " << Utils::formatCurrency(getUnrealizedGain()) << std::endl;
+        std::cout << "  Realized Gain: " << Utils::formatCurrency(getRealizedGain()) << " (short term "
+                  << Utils::formatCurrency(lots.getRealizedShortTerm()) << ", long term "
+                  << Utils::formatCurrency(lots.getRealizedLongTerm()) << ")" << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // Each asset type might have unique analysis methods
+    virtual std::string getAnalysis() const {
+        std::string analysis = "Analysis for " + name + " (" + symbol + "):\n";
+        
+        if (priceHistory.totalAppended() >= 2) {
+            double oldestPrice = priceHistory.inceptionPrice();
+            double latestPrice = priceHistory.lastPrice();
+            double priceChange = Utils::percentChange(oldestPrice, latestPrice);
+            
+            analysis += "  Price change since tracking: " + std::to_string(priceChange) + "%\n";
+            
+            if (priceChange > 0) {
+                analysis += "  The price has increased since tracking began.\n";
+            } else if (priceChange < 0) {
+                analysis += "  The price has decreased since tracking began.\n";
+            } else {
+                analysis += "  The price remains stable since tracking began.\n";
+            }
+        }
+        
+        if (volatility < 5.0) {
+            analysis += "  Low volatility: This asset has been stable recently.\n";
+        } else if (volatility < 15.0) {
+            analysis += "  Medium volatility: This asset shows moderate price movements.\n";
+        } else {
+            analysis += "  High volatility: This asset has significant price fluctuations.\n";
+        }
+        
+        return analysis;
+    }
+};
+
+// When level monthly contributions are made relative to compounding
+enum class ContributionTiming {
+    StartOfMonth,   // Annuity due: each contribution earns the month's return
+    EndOfMonth      // Ordinary annuity
+};
+
+// Future values over a (horizon, rate, contribution) grid, indexed
+// values[(horizon * rates + rate) * contributions + contribution]
+struct ProjectionMatrix {
+    size_t horizons = 0;
+    size_t rates = 0;
+    size_t contributions = 0;
+    std::vector<double> values;
+    
+    double at(size_t horizon, size_t rate, size_t contribution) const {
+        return values[(horizon * rates + rate) * contributions + contribution];
+    }
+};
+
+// Closed-form future value of a lump sum plus level monthly contributions:
+//   FV = PV * g^n + C * (g^n - 1) / r [* g when contributions come first]
+// with g = 1 + r and r the monthly rate (FV = PV + C * n when r = 0).
+// The lump-sum growth g^n and annuity factor depend only on (n, r), so a
+// grid computes them once per (horizon, rate) and applies them to every
+// contribution; horizons are walked in ascending order so each g^n is built
+// from the previous one. Single values go through the same kernel.
+class GrowthProjector {
+private:
+    static constexpr size_t kParallelThreshold = 1 << 16;   // Grid cells before going multithreaded
+    
+    // Fill the (horizon, contribution) plane for one annual rate. `order`
+    // lists horizon indices by ascending month count; `out` points at the
+    // first cell of this rate and rows are `rowStride` apart.
+    static void projectRate(const int* months, const size_t* order, size_t horizonCount,
+                            double annualRatePercent, const double* contributions, size_t contributionCount,
+                            double presentValue, ContributionTiming timing,
+                            double* out, size_t rowStride) {
+        double monthlyRate = annualRatePercent / 100.0 / 12.0;
+        double base = 1.0 + monthlyRate;
+        double due = timing == ContributionTiming::StartOfMonth ? base : 1.0;
+        
+        double growth = 1.0;
+        int reached = 0;
+        int lastStep = -1;
+        double stepFactor = 1.0;
+        
+        for (size_t k = 0; k < horizonCount; ++k) {
+            size_t h = order[k];
+            int n = std::max(0, months[h]);
+            int step = n - reached;
+            if (step > 0) {
+                if (step != lastStep) {
+                    stepFactor = std::pow(base, step);
+                    lastStep = step;
+                }
+                growth *= stepFactor;
+                reached = n;
+            }
+            
+            double annuity = monthlyRate != 0.0 ? (growth - 1.0) / monthlyRate * due : static_cast<double>(n);
+            double lumpSum = presentValue * growth;
+            double* row = out + h * rowStride;
+            for (size_t c = 0; c < contributionCount; ++c) {
+                row[c] = lumpSum + contributions[c] * annuity;
+            }
+        }
+    }
+
+public:
+    static double futureValue(int months, double annualRatePercent, double monthlyContribution,
+                              double presentValue = 0.0,
+                              ContributionTiming timing = ContributionTiming::EndOfMonth) {
+        size_t order = 0;
+        double value = 0.0;
+        projectRate(&months, &order, 1, annualRatePercent, &monthlyContribution, 1,
+                    presentValue, timing, &value, 1);
+        return value;
+    }
+    
+    static ProjectionMatrix grid(const std::vector<int>& months, const std::vector<double>& annualRatesPercent,
+                                 const std::vector<double>& contributions, double presentValue = 0.0,
+                                 ContributionTiming timing = ContributionTiming::EndOfMonth) {
+        ProjectionMatrix result;
+        result.horizons = months.size();
+        result.rates = annualRatesPercent.size();
+        result.contributions = contributions.size();
+        result.values.resize(result.horizons * result.rates * result.contributions);
+        if (result.values.empty()) return result;
+        
+        std::vector<size_t> order(months.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return months[a] < months[b]; });
+        
+        size_t rowStride = result.rates * result.contributions;
+        auto projectRates = [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r) {
+                projectRate(months.data(), order.data(), months.size(), annualRatesPercent[r],
+                            contributions.data(), contributions.size(), presentValue, timing,
+                            result.values.data() + r * result.contributions, rowStride);
+            }
+        };
+        
+        if (result.values.size() >= kParallelThreshold && result.rates > 1) {
+            size_t cellsPerRate = result.horizons * result.contributions;
+            size_t grain = std::max<size_t>(1, kParallelThreshold / std::max<size_t>(1, cellsPerRate));
+            ThreadPool::global().parallelFor(0, result.rates, grain, projectRates);
+        } else {
+            projectRates(0, result.rates);
+        }
+        return result;
+    }
+};
+
+// SIP (Systematic Investment Plan) - Mutual Funds or Index funds
+class SIP : public Asset {
+private:
+    double expectedAnnualReturn;
+    std::string fundType; // Index, Equity, Debt, etc.
+    double expenseRatio;
+
+public:
+    SIP(const std::string& name, const std::string& symbol, double currentPrice, 
+        double quantity = 0.0, double expectedAnnualReturn = 12.0, 
+        const std::string& fundType = "Index", double expenseRatio = 0.5)
+        : Asset(name, symbol, currentPrice, quantity),
+          expectedAnnualReturn(expectedAnnualReturn), fundType(fundType), expenseRatio(expenseRatio) {}
+    
+    // Getters
+    double getExpectedAnnualReturn() const { return expectedAnnualReturn; }
+    std::string getFundType() const { return fundType; }
+    double getExpenseRatio() const { return expenseRatio; }
+    
+    // Project growth over years, contributions at the end of each month
+    double projectGrowth(int years, double monthlyContribution = 0.0) const {
+        return GrowthProjector::futureValue(years * 12, expectedAnnualReturn, monthlyContribution,
+                                            getCurrentValue(), ContributionTiming::EndOfMonth);
+    }
+    
+    // Projected values for several horizons (years) and contribution levels
+    // in one pass: result.at(horizon, 0, contribution)
+    ProjectionMatrix projectGrowthGrid(const std::vector<int>& years,
+                                       const std::vector<double>& monthlyContributions) const {
+        std::vector<int> months(years.size());
+        std::transform(years.begin(), years.end(), months.begin(), [](int y) { return y * 12; });
+        return GrowthProjector::grid(months, {expectedAnnualReturn}, monthlyContributions,
+                                     getCurrentValue(), ContributionTiming::EndOfMonth);
+    }
+    
+    // Override display to include SIP-specific details
+    void display() const override {
+        Asset::display();
+        std::cout << "  Fund Type: " << fundType << std::endl;
+        std::cout << "  Expected Annual Return: " << expectedAnnualReturn << "%" << std::endl;
+        std::cout << "  Expense Ratio: " << expenseRatio << "%" << std::endl;
+        
+        // Show projected growth
+        ProjectionMatrix projection = projectGrowthGrid({3, 5, 10}, {0.0});
+        std::cout << "  Projected Value (3 years): " << Utils::formatCurrency(projection.at(0, 0, 0)) << std::endl;
+        std::cout << "  Projected Value (5 years): " << Utils::formatCurrency(projection.at(1, 0, 0)) << std::endl;
+        std::cout << "  Projected Value (10 years): " << Utils::formatCurrency(projection.at(2, 0, 0)) << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // Override get analysis to include SIP-specific analysis
+    std::string getAnalysis() const override {
+        std::string analysis = Asset::getAnalysis();
+        
+        analysis += "  This is a " + fundType + " fund with an expense ratio of " + 
+                    std::to_string(expenseRatio) + "%.\n";
+        
+        if (expenseRatio > 1.0) {
+            analysis += "  The expense ratio is relatively high. Consider lower-cost alternatives.\n";
+        } else {
+            analysis += "  The expense ratio is reasonable for this type of fund.\n";
+        }
+        
+        if (expectedAnnualReturn > 15.0) {
+            analysis += "  The expected return seems optimistic. Be prepared for potential underperformance.\n";
+        }
+        
+        return analysis;
+    }
+};
+
+// Forex trading asset
+class Forex : public Asset {
+private:
+    std::string baseCurrency;
+    std::string quoteCurrency;
+    double spreadPercentage;
+    std::string trend; // "Bullish", "Bearish", "Neutral"
+    const SMAIndicator& trendAverage;
+
+public:
+    Forex(const std::string& name, const std::string& symbol, double currentPrice, 
+          const std::string& baseCurrency, const std::string& quoteCurrency,
+          double quantity = 0.0, double spreadPercentage = 0.1)
+        : Asset(name, symbol, currentPrice, quantity),
+          baseCurrency(baseCurrency), quoteCurrency(quoteCurrency),
+          spreadPercentage(spreadPercentage), trend("Neutral"),
+          trendAverage(attachIndicator<SMAIndicator>(5)) {
+        updateTrend();
+    }
+    
+    // Getters
+    std::string getBaseCurrency() const { return baseCurrency; }
+    std::string getQuoteCurrency() const { return quoteCurrency; }
+    double getSpreadPercentage() const { return spreadPercentage; }
+    std::string getTrend() const { return trend; }
+    
+    // Set trend based on price movement
+    void updateTrend() {
+        if (!trendAverage.isReady()) {
+            trend = "Neutral";
+            return;
+        }
+        
+        // Average price over last 5 data points
+        double avg = trendAverage.value();
+        
+        // Compare with current price
+        if (currentPrice > avg * 1.02) {
+            trend = "Bullish";
+        } else if (currentPrice < avg * 0.98) {
+            trend = "Bearish";
+        } else {
+            trend = "Neutral";
+        }
+    }
+    
+    // Refresh trend on every price point
+    void onPriceUpdate() override {
+        updateTrend();
+    }
+    
+    // Override display for Forex-specific details
+    void display() const override {
+        Asset::display();
+        std::cout << "  Pair: " << baseCurrency << "/" << quoteCurrency << std::endl;
+        std::cout << "  Spread: " << spreadPercentage << "%" << std::endl;
+        std::cout << "  Current Trend: " << trend << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // Override get analysis for Forex-specific analysis
+    std::string getAnalysis() const override {
+        std::string analysis = Asset::getAnalysis();
+        
+        analysis += "  This forex pair (" + baseCurrency + "/" + quoteCurrency + ") ";
+        
+        if (trend == "Bullish") {
+            analysis += "is in an uptrend. Consider taking profit or trailing stops.\n";
+        } else if (trend == "Bearish") {
+            analysis += "is in a downtrend. Consider hedging or reducing exposure.\n";
+        } else {
+            analysis += "is in a neutral trend. Monitor for breakout opportunities.\n";
+        }
+        
+        if (volatility > 10.0) {
+            analysis += "  High volatility in this pair suggests caution with position sizing.\n";
+        }
+        
+        return analysis;
+    }
+};
+
+// Cryptocurrency asset
+class Cryptocurrency : public Asset {
+private:
+    double marketCap;
+    std::string networkStatus; // "Healthy", "Congested", etc.
+    bool isStaking;
+    double stakingYield;
+    std::string trend; // "Bullish", "Bearish", "Neutral", "Overbought", "Oversold"
+    const RSIIndicator& rsi;
+    const EMAIndicator& trendAverage;
+    const ATRIndicator& range;
+
+public:
+    Cryptocurrency(const std::string& name, const std::string& symbol, double currentPrice, 
+                  double marketCap, double quantity = 0.0, bool isStaking = false, 
+                  double stakingYield = 0.0)
+        : Asset(name, symbol, currentPrice, quantity),
+          marketCap(marketCap), networkStatus("Healthy"),
+          isStaking(isStaking), stakingYield(stakingYield), trend("Neutral"),
+          rsi(attachIndicator<RSIIndicator>(14)),
+          trendAverage(attachIndicator<EMAIndicator>(20)),
+          range(attachIndicator<ATRIndicator>(14)) {
+        updateTrend();
+    }
+    
+    // Getters
+    double getMarketCap() const { return marketCap; }
+    std::string getNetworkStatus() const { return networkStatus; }
+    bool getIsStaking() const { return isStaking; }
+    double getStakingYield() const { return stakingYield; }
+    std::string getTrend() const { return trend; }
+    const RSIIndicator& getRSI() const { return rsi; }
+    const ATRIndicator& getRange() const { return range; }
+    
+    // RSI extremes take precedence over the EMA trend
+    void updateTrend() {
+        if (rsi.isReady() && rsi.value() > 70.0) {
+            trend = "Overbought";
+        } else if (rsi.isReady() && rsi.value() < 30.0) {
+            trend = "Oversold";
+        } else if (!trendAverage.isReady()) {
+            trend = "Neutral";
+        } else if (currentPrice > trendAverage.value() * 1.02) {
+            trend = "Bullish";
+        } else if (currentPrice < trendAverage.value() * 0.98) {
+            trend = "Bearish";
+        } else {
+            trend = "Neutral";
+        }
+    }
+    
+    void onPriceUpdate() override {
+        updateTrend();
+    }
+    
+    // Update market cap based on new price
+    void updateMarketCap() {
+        // Simplified - in reality would need to know total supply
+        double ratio = currentPrice / priceHistory.inceptionPrice();
+        marketCap *= ratio;
+    }
+    
+    // Enable staking
+    void enableStaking(double yield) {
+        isStaking = true;
+        stakingYield = yield;
+    }
+    
+    // Disable staking
+    void disableStaking() {
+        isStaking = false;
+        stakingYield = 0.0;
+    }
+    
+    // Calculate staking rewards
+    double calculateStakingRewards(int days) const {
+        if (!isStaking || stakingYield <= 0) return 0.0;
+        
+        double dailyRate = stakingYield / 365.0;
+        return getCurrentValue() * (std::pow(1 + dailyRate / 100.0, days) - 1);
+    }
+    
+    // Override display for crypto-specific details
+    void display() const override {
+        Asset::display();
+        std::cout << "  Market Cap: " << Utils::formatCurrency(marketCap) << std::endl;
+        std::cout << "  Network Status: " << networkStatus << std::endl;
+        std::cout << "  Current Trend: " << trend << std::endl;
+        
+        if (rsi.isReady()) {
+            std::cout << "  " << rsi.getName() << ": " << std::fixed << std::setprecision(1) 
+                      << rsi.value() << std::endl;
+        }
+        if (range.isReady()) {
+            std::cout << "  Average Range: " << std::fixed << std::setprecision(2) 
+                      << range.getPercent() << "%" << std::endl;
+        }
+        
+        if (isStaking) {
+            std::cout << "  Staking Enabled: Yes" << std::endl;
+            std::cout << "  Staking Yield: " << stakingYield << "% APY" << std::endl;
+            std::cout << "  Projected Staking Reward (30 days): " 
+                      << Utils::formatCurrency(calculateStakingRewards(30)) << std::endl;
+        } else {
+            std::cout << "  Staking Enabled: No" << std::endl;
+        }
+        
+        std::cout << std::endl;
     }
     
     // Override get analysis for crypto-specific analysis
     std::string getAnalysis() const override {
         std::string analysis = Asset::getAnalysis();
         
-        analysis += "  " + name + " has a market cap of " + Utils::formatCurrency(marketCap) + ".\n";
+        analysis += "  " + name + " has a market cap of " + Utils::formatCurrency(marketCap) + ".\n";
+        
+        if (volatility > 20.0) {
+            analysis += "  This cryptocurrency shows extreme volatility. Consider reducing exposure.\n";
+        }
+        
+        if (trend == "Overbought") {
+            analysis += "  RSI indicates overbought conditions; a pullback is more likely.\n";
+        } else if (trend == "Oversold") {
+            analysis += "  RSI indicates oversold conditions; watch for a rebound.\n";
+        }
+        
+        if (isStaking) {
+            analysis += "  You are earning " + std::to_string(stakingYield) + 
+                       "% APY through staking, which helps offset volatility.\n";
+        } else {
+            analysis += "  Consider staking options to earn passive income from your holdings.\n";
+        }
+        
+        return analysis;
+    }
+};
+
+// Commodity (Gold) asset
+class Commodity : public Asset {
+private:
+    std::string grade; // e.g., "24K", "22K" for gold
+    bool isPhysical;   // physical gold vs paper gold (ETF)
+    std::string trend; // "Bullish", "Bearish", "Neutral"
+    const MACDIndicator& macd;
+    const BollingerIndicator& bands;
+
+public:
+    Commodity(const std::string& name, const std::string& symbol, double currentPrice,
+             const std::string& grade = "24K", bool isPhysical = false, double quantity = 0.0)
+        : Asset(name, symbol, currentPrice, quantity),
+          grade(grade), isPhysical(isPhysical), trend("Neutral"),
+          macd(attachIndicator<MACDIndicator>(12, 26, 9)),
+          bands(attachIndicator<BollingerIndicator>(20, 2.0)) {
+        updateTrend();
+    }
+    
+    // Getters
+    std::string getGrade() const { return grade; }
+    bool getIsPhysical() const { return isPhysical; }
+    std::string getTrend() const { return trend; }
+    const MACDIndicator& getMACD() const { return macd; }
+    const BollingerIndicator& getBands() const { return bands; }
+    
+    // Trend from the MACD histogram
+    void updateTrend() {
+        if (!macd.isReady()) {
+            trend = "Neutral";
+        } else if (macd.getHistogram() > 0.0) {
+            trend = "Bullish";
+        } else if (macd.getHistogram() < 0.0) {
+            trend = "Bearish";
+        } else {
+            trend = "Neutral";
+        }
+    }
+    
+    void onPriceUpdate() override {
+        updateTrend();
+    }
+    
+    // Inflation hedge calculation
+    double calculateInflationHedge(double inflationRate, int years) const {
+        double annualLossToInflation = inflationRate / 100.0;
+        double valueWithoutHedge = getCurrentValue() * std::pow(1 - annualLossToInflation, years);
+        return getCurrentValue() - valueWithoutHedge;
+    }
+    
+    // Override display for commodity-specific details
+    void display() const override {
+        Asset::display();
+        std::cout << "  Grade: " << grade << std::endl;
+        std::cout << "  Physical Holding: " << (isPhysical ? "Yes" : "No") << std::endl;
+        std::cout << "  Current Trend: " << trend << std::endl;
+        if (bands.isReady()) {
+            std::cout << "  Bollinger Bands: " << Utils::formatCurrency(bands.getLower()) << " - " 
+                      << Utils::formatCurrency(bands.getUpper()) << std::endl;
+        }
+        std::cout << "  Inflation Hedge (5% inflation, 5 years): " 
+                  << Utils::formatCurrency(calculateInflationHedge(5.0, 5)) << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // Override get analysis for commodity-specific analysis
+    std::string getAnalysis() const override {
+        std::string analysis = Asset::getAnalysis();
+        
+        analysis += "  This " + grade + " gold is held as " + 
+                   (isPhysical ? "physical metal" : "a paper investment") + ".\n";
+        
+        if (volatility < 10.0) {
+            analysis += "  Gold is currently showing relative stability, providing a good hedge.\n";
+        } else {
+            analysis += "  Gold is showing higher than usual volatility. Monitor global macro events.\n";
+        }
+        
+        if (bands.isReady() && currentPrice > bands.getUpper()) {
+            analysis += "  Price is above the upper Bollinger band; the move may be overextended.\n";
+        } else if (bands.isReady() && currentPrice < bands.getLower()) {
+            analysis += "  Price is below the lower Bollinger band; a mean reversion is possible.\n";
+        }
+        
+        return analysis;
+    }
+};
+
+// Fiat Currency asset (e.g., USD)
+class FiatCurrency : public Asset {
+private:
+    std::string country;
+    double interestRate;     // Current interest rate in the country
+    double inflationRate;    // Current inflation rate
+
+public:
+    FiatCurrency(const std::string& name, const std::string& symbol, double currentPrice,
+                const std::string& country, double interestRate = 0.0, double inflationRate = 0.0,
+                double quantity = 0.0)
+        : Asset(name, symbol, currentPrice, quantity),
+          country(country), interestRate(interestRate), inflationRate(inflationRate) {}
+    
+    // Getters
+    std::string getCountry() const { return country; }
+    double getInterestRate() const { return interestRate; }
+    double getInflationRate() const { return inflationRate; }
+    
+    // Calculate real return (accounting for inflation)
+    double getRealReturn() const {
+        return interestRate - inflationRate;
+    }
+    
+    // Calculate purchasing power after a period
+    double calculatePurchasingPower(int years) const {
+        double realReturnRate = getRealReturn() / 100.0;
+        return getCurrentValue() * std::pow(1 + realReturnRate, years);
+    }
+    
+    // Override display for fiat-specific details
+    void display() const override {
+        Asset::display();
+        std::cout << "  Country: " << country << std::endl;
+        std::cout << "  Interest Rate: " << interestRate << "%" << std::endl;
+        std::cout << "  Inflation Rate: " << inflationRate << "%" << std::endl;
+        std::cout << "  Real Return: " << getRealReturn() << "%" << std::endl;
+        std::cout << "  Purchasing Power (5 years): " 
+                  << Utils::formatCurrency(calculatePurchasingPower(5)) << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // Override get analysis for fiat-specific analysis
+    std::string getAnalysis() const override {
+        std::string analysis = Asset::getAnalysis();
+        
+        analysis += "  " + name + " has an interest rate of " + std::to_string(interestRate) + 
+                   "% and inflation of " + std::to_string(inflationRate) + "%.\n";
+        
+        double realReturn = getRealReturn();
+        if (realReturn < 0) {
+            analysis += "  This currency has a negative real return, losing purchasing power over time.\n";
+            analysis += "  Consider alternatives for long-term holdings.\n";
+        } else if (realReturn < 1.0) {
+            analysis += "  This currency is barely maintaining purchasing power.\n";
+        } else {
+            analysis += "  This currency has a positive real return, which is favorable.\n";
+        }
+        
+        return analysis;
+    }
+};
+
+// Saves and rebuilds assets of any concrete type: a kind tag, the
+// constructor parameters, then the shared Asset state
+class AssetCodec {
+private:
+    enum Kind : std::uint8_t { KindSIP = 1, KindForex, KindCrypto, KindCommodity, KindFiat, KindGeneric };
+
+public:
+    static void save(BinaryWriter& out, const Asset& asset) {
+        if (auto sip = dynamic_cast<const SIP*>(&asset)) {
+            out.put<std::uint8_t>(KindSIP);
+            writeNames(out, asset);
+            out.put(sip->getExpectedAnnualReturn());
+            out.putString(sip->getFundType());
+            out.put(sip->getExpenseRatio());
+        } else if (auto forex = dynamic_cast<const Forex*>(&asset)) {
+            out.put<std::uint8_t>(KindForex);
+            writeNames(out, asset);
+            out.putString(forex->getBaseCurrency());
+            out.putString(forex->getQuoteCurrency());
+            out.put(forex->getSpreadPercentage());
+        } else if (auto crypto = dynamic_cast<const Cryptocurrency*>(&asset)) {
+            out.put<std::uint8_t>(KindCrypto);
+            writeNames(out, asset);
+            out.put(crypto->getMarketCap());
+            out.put<std::uint8_t>(crypto->getIsStaking() ? 1 : 0);
+            out.put(crypto->getStakingYield());
+        } else if (auto commodity = dynamic_cast<const Commodity*>(&asset)) {
+            out.put<std::uint8_t>(KindCommodity);
+            writeNames(out, asset);
+            out.putString(commodity->getGrade());
+            out.put<std::uint8_t>(commodity->getIsPhysical() ? 1 : 0);
+        } else if (auto fiat = dynamic_cast<const FiatCurrency*>(&asset)) {
+            out.put<std::uint8_t>(KindFiat);
+            writeNames(out, asset);
+            out.putString(fiat->getCountry());
+            out.put(fiat->getInterestRate());
+            out.put(fiat->getInflationRate());
+        } else {
+            // Plain assets, and any other type, keep their shared state
+            out.put<std::uint8_t>(KindGeneric);
+            writeNames(out, asset);
+        }
+        asset.saveState(out);
+    }
+    
+    // Returns nullptr (and fails the reader) on an unknown or truncated record
+    static std::shared_ptr<Asset> load(BinaryReader& in) {
+        std::uint8_t kind = in.get<std::uint8_t>();
+        std::string name = in.getString();
+        std::string symbol = in.getString();
+        
+        std::shared_ptr<Asset> asset;
+        switch (kind) {
+            case KindSIP: {
+                double expectedReturn = in.get<double>();
+                std::string fundType = in.getString();
+                double expenseRatio = in.get<double>();
+                asset = std::make_shared<SIP>(name, symbol, 0.0, 0.0, expectedReturn, fundType, expenseRatio);
+                break;
+            }
+            case KindForex: {
+                std::string base = in.getString();
+                std::string quote = in.getString();
+                double spread = in.get<double>();
+                asset = std::make_shared<Forex>(name, symbol, 0.0, base, quote, 0.0, spread);
+                break;
+            }
+            case KindCrypto: {
+                double marketCap = in.get<double>();
+                bool staking = in.get<std::uint8_t>() != 0;
+                double stakingYield = in.get<double>();
+                asset = std::make_shared<Cryptocurrency>(name, symbol, 0.0, marketCap, 0.0, staking, stakingYield);
+                break;
+            }
+            case KindCommodity: {
+                std::string grade = in.getString();
+                bool physical = in.get<std::uint8_t>() != 0;
+                asset = std::make_shared<Commodity>(name, symbol, 0.0, grade, physical);
+                break;
+            }
+            case KindFiat: {
+                std::string country = in.getString();
+                double interest = in.get<double>();
+                double inflation = in.get<double>();
+                asset = std::make_shared<FiatCurrency>(name, symbol, 0.0, country, interest, inflation);
+                break;
+            }
+            case KindGeneric:
+                asset = std::make_shared<Asset>(name, symbol, 0.0);
+                break;
+            default:
+                in.fail();
+                return nullptr;
+        }
+        
+        asset->restoreState(in);
+        return in.ok() ? asset : nullptr;
+    }
+
+private:
+    static void writeNames(BinaryWriter& out, const Asset& asset) {
+        out.putString(asset.getName());
+        out.putString(asset.getSymbol());
+    }
+};
+
+// Portfolio holdings keyed by interned symbol
+using AssetMap = SymbolMap<std::shared_ptr<Asset>>;
+
+// Struct-of-arrays mirror of the portfolio's Asset objects: price, quantity,
+// cost basis and volatility in parallel contiguous arrays, so valuation is a
+// single vectorizable pass instead of a pointer chase per holding
+class HoldingsTable {
+public:
+    struct Totals {
+        double totalValue;
+        double totalCost;
+        double weightedReturn;      // Value-weighted return percentage
+        double weightedVolatility;  // Value-weighted volatility percentage
+    };
+
+private:
+    std::vector<SymbolId> ids;
+    std::vector<double> prices;
+    std::vector<double> quantities;
+    std::vector<double> costBases;
+    std::vector<double> volatilities;
+    std::vector<std::uint32_t> rows;  // SymbolId -> row + 1 (0 = absent)
+    std::uint64_t version = 0;        // Bumped on every change, for caches keyed on the table
+
+public:
+    // Insert or refresh the row mirroring `asset`
+    void upsert(SymbolId id, const Asset& asset) {
+        if (id >= rows.size()) {
+            rows.resize(id + 1, 0);
+        }
+        
+        if (rows[id] == 0) {
+            ids.push_back(id);
+            prices.push_back(0.0);
+            quantities.push_back(0.0);
+            costBases.push_back(0.0);
+            volatilities.push_back(0.0);
+            rows[id] = static_cast<std::uint32_t>(ids.size());
+        }
+        
+        size_t row = rows[id] - 1;
+        prices[row] = asset.getCurrentPrice();
+        quantities[row] = asset.getQuantity();
+        costBases[row] = asset.getInitialInvestment();
+        volatilities[row] = asset.getVolatility();
+        ++version;
+    }
+    
+    // Swap-remove a row
+    bool remove(SymbolId id) {
+        if (!contains(id)) return false;
+        
+        size_t row = rows[id] - 1;
+        size_t last = ids.size() - 1;
+        if (row != last) {
+            ids[row] = ids[last];
+            prices[row] = prices[last];
+            quantities[row] = quantities[last];
+            costBases[row] = costBases[last];
+            volatilities[row] = volatilities[last];
+            rows[ids[row]] = static_cast<std::uint32_t>(row + 1);
+        }
+        
+        ids.pop_back();
+        prices.pop_back();
+        quantities.pop_back();
+        costBases.pop_back();
+        volatilities.pop_back();
+        ++version;
+        rows[id] = 0;
+        return true;
+    }
+    
+    // Rebuild every row from the asset objects
+    void syncAll(const AssetMap& assets) {
+        for (const auto& [id, asset] : assets) {
+            upsert(id, *asset);
+        }
+    }
+    
+    bool contains(SymbolId id) const { return id < rows.size() && rows[id] != 0; }
+    size_t size() const { return ids.size(); }
+    size_t rowOf(SymbolId id) const { return rows[id] - 1; }
+    std::uint64_t getVersion() const { return version; }
+    
+    // Column access
+    const std::vector<SymbolId>& getIds() const { return ids; }
+    const std::vector<double>& getPrices() const { return prices; }
+    const std::vector<double>& getQuantities() const { return quantities; }
+    const std::vector<double>& getCostBases() const { return costBases; }
+    const std::vector<double>& getVolatilities() const { return volatilities; }
+    
+    // Totals, weighted return and weighted volatility in one pass; four
+    // independent accumulators per sum let the compiler vectorize the loop
+    Totals computeTotals() const {
+        const size_t n = ids.size();
+        const double* price = prices.data();
+        const double* quantity = quantities.data();
+        const double* cost = costBases.data();
+        const double* vol = volatilities.data();
+        
+        double value[4] = {0.0, 0.0, 0.0, 0.0};
+        double basis[4] = {0.0, 0.0, 0.0, 0.0};
+        double returnSum[4] = {0.0, 0.0, 0.0, 0.0};
+        double volSum[4] = {0.0, 0.0, 0.0, 0.0};
+        
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                double v = price[i + lane] * quantity[i + lane];
+                double c = cost[i + lane];
+                value[lane] += v;
+                basis[lane] += c;
+                returnSum[lane] += c > 0.0 ? v * (v - c) / c : 0.0;
+                volSum[lane] += v * vol[i + lane];
+            }
+        }
+        for (; i < n; ++i) {
+            double v = price[i] * quantity[i];
+            double c = cost[i];
+            value[0] += v;
+            basis[0] += c;
+            returnSum[0] += c > 0.0 ? v * (v - c) / c : 0.0;
+            volSum[0] += v * vol[i];
+        }
+        
+        Totals totals{};
+        totals.totalValue = (value[0] + value[1]) + (value[2] + value[3]);
+        totals.totalCost = (basis[0] + basis[1]) + (basis[2] + basis[3]);
+        if (totals.totalValue > 0.0) {
+            totals.weightedReturn = ((returnSum[0] + returnSum[1]) + (returnSum[2] + returnSum[3])) 
+                                    / totals.totalValue * 100.0;
+            totals.weightedVolatility = ((volSum[0] + volSum[1]) + (volSum[2] + volSum[3])) 
+                                        / totals.totalValue;
+        }
+        return totals;
+    }
+    
+    // Total market value only
+    double totalValue() const {
+        const size_t n = ids.size();
+        const double* price = prices.data();
+        const double* quantity = quantities.data();
+        double value[4] = {0.0, 0.0, 0.0, 0.0};
+        
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                value[lane] += price[i + lane] * quantity[i + lane];
+            }
+        }
+        for (; i < n; ++i) {
+            value[0] += price[i] * quantity[i];
+        }
+        return (value[0] + value[1]) + (value[2] + value[3]);
+    }
+    
+    // Per-row weights as percentages of `total`, written row-aligned into `out`
+    void computeWeights(double total, std::vector<double>& out) const {
+        const size_t n = ids.size();
+        out.resize(n);
+        if (total <= 0.0) {
+            std::fill(out.begin(), out.end(), 0.0);
+            return;
+        }
+        
+        const double scale = 100.0 / total;
+        const double* price = prices.data();
+        const double* quantity = quantities.data();
+        double* weight = out.data();
+        for (size_t i = 0; i < n; ++i) {
+            weight[i] = price[i] * quantity[i] * scale;
+        }
+    }
+};
+
+// Immutable view of the portfolio at one moment, built in one pass over
+// the holdings table: per-position values, weights, returns and
+// volatilities plus the portfolio totals. Analyzers and reports share one
+// snapshot rather than each re-deriving the same figures.
+class PortfolioSnapshot {
+private:
+    std::vector<SymbolId> ids;
+    std::vector<double> values;
+    std::vector<double> weights;        // Percent of total value
+    std::vector<double> returns;        // Percent gain over cost basis
+    std::vector<double> volatilities;   // Percent
+    std::vector<std::uint32_t> rows;    // SymbolId -> row + 1 (0 = absent)
+    HoldingsTable::Totals totals{};
+    double initialInvestment = 0.0;
+    std::uint64_t version = 0;          // Holdings version it was taken at
+
+public:
+    PortfolioSnapshot() = default;
+    
+    PortfolioSnapshot(const HoldingsTable& holdings, double initialInvestment)
+        : ids(holdings.getIds()), initialInvestment(initialInvestment), version(holdings.getVersion()) {
+        const size_t n = ids.size();
+        const double* price = holdings.getPrices().data();
+        const double* quantity = holdings.getQuantities().data();
+        const double* cost = holdings.getCostBases().data();
+        const double* vol = holdings.getVolatilities().data();
+        values.resize(n);
+        weights.resize(n);
+        returns.resize(n);
+        volatilities.assign(vol, vol + n);
+        
+        double returnSum = 0.0;
+        double volSum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double v = price[i] * quantity[i];
+            double c = cost[i];
+            values[i] = v;
+            returns[i] = c > 0.0 ? (v - c) / c * 100.0 : 0.0;
+            totals.totalValue += v;
+            totals.totalCost += c;
+            returnSum += v * returns[i];
+            volSum += v * vol[i];
+        }
+        
+        if (totals.totalValue > 0.0) {
+            double scale = 100.0 / totals.totalValue;
+            for (size_t i = 0; i < n; ++i) weights[i] = values[i] * scale;
+            totals.weightedReturn = returnSum / totals.totalValue;
+            totals.weightedVolatility = volSum / totals.totalValue;
+        }
+        
+        SymbolId largest = n ? *std::max_element(ids.begin(), ids.end()) : 0;
+        rows.assign(n ? largest + 1 : 0, 0);
+        for (size_t i = 0; i < n; ++i) rows[ids[i]] = static_cast<std::uint32_t>(i + 1);
+    }
+    
+    size_t size() const { return ids.size(); }
+    bool contains(SymbolId id) const { return id < rows.size() && rows[id] != 0; }
+    size_t rowOf(SymbolId id) const { return rows[id] - 1; }
+    std::uint64_t getVersion() const { return version; }
+    
+    // Row-aligned columns
+    const std::vector<SymbolId>& getIds() const { return ids; }
+    const std::vector<double>& getValues() const { return values; }
+    const std::vector<double>& getWeights() const { return weights; }
+    const std::vector<double>& getReturns() const { return returns; }
+    const std::vector<double>& getVolatilities() const { return volatilities; }
+    
+    const HoldingsTable::Totals& getTotals() const { return totals; }
+    double getTotalValue() const { return totals.totalValue; }
+    double getInitialInvestment() const { return initialInvestment; }
+    
+    // Return on the capital the portfolio was started with
+    double getTotalReturnPercentage() const {
+        if (initialInvestment <= 0) return 0.0;
+        return ((totals.totalValue - initialInvestment) / initialInvestment) * 100.0;
+    }
+    
+    // Weight of one instrument in percent, 0 if not held
+    double weightOf(SymbolId id) const {
+        return contains(id) ? weights[rowOf(id)] : 0.0;
+    }
+    
+    // Weights keyed by instrument; empty while the portfolio has no value
+    SymbolMap<double> composition() const {
+        SymbolMap<double> result;
+        if (totals.totalValue <= 0.0) return result;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            result[ids[i]] = weights[i];
+        }
+        return result;
+    }
+};
+
+// Rolling covariance of per-tick returns across instruments. The last
+// `window` cross-sectional return vectors are kept in a ring; running sums
+// and the full cross-product matrix are updated by one rank-1 add (and one
+// rank-1 remove once the window is full) per tick, so an update is O(n^2)
+// and never rescans history. The sums are rebuilt from the ring every few
+// windows to stop rounding drift.
+class CovarianceEngine {
+private:
+    static constexpr size_t kBlock = 64;   // Tile edge for the quadratic form
+    
+    size_t window;
+    std::vector<SymbolId> ids;                  // Instrument order
+    std::vector<std::uint32_t> slots;           // SymbolId -> index + 1 (0 = absent)
+    std::vector<double> lastPrices;             // Per instrument, 0 = no price yet
+    std::vector<double> ring;                   // window x n returns, row-major
+    size_t head = 0;
+    size_t count = 0;
+    size_t updatesSinceResync = 0;
+    std::uint64_t version = 0;                  // Bumped on every sample or layout change
+    std::uint64_t layoutVersion = 0;            // Bumped when instruments or samples are replaced
+    std::uint64_t appended = 0;                 // Samples added since the last layout change
+    std::vector<double> sums;                   // Sum of returns per instrument
+    std::vector<double> cross;                  // n x n sum of r_i * r_j, full symmetric
+    std::vector<double> scratch;
+    
+    size_t dimension() const { return ids.size(); }
+    
+    void resync() {
+        size_t n = dimension();
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(cross.begin(), cross.end(), 0.0);
+        std::vector<double> none(n, 0.0);
+        for (size_t k = 0; k < count; ++k) {
+            size_t row = (head + window - count + k) % window;
+            rankUpdate(&ring[row * n], none.data());
+        }
+        updatesSinceResync = 0;
+    }
+    
+    // sums += added - removed; cross += added added^T - removed removed^T
+    void rankUpdate(const double* added, const double* removed) {
+        size_t n = dimension();
+        for (size_t i = 0; i < n; ++i) {
+            sums[i] += added[i] - removed[i];
+            double a = added[i], r = removed[i];
+            if (a == 0.0 && r == 0.0) continue;
+            double* row = &cross[i * n];
+            for (size_t j = 0; j < n; ++j) {
+                row[j] += a * added[j] - r * removed[j];
+            }
+        }
+    }
+    
+    // Re-lay the ring and matrices for a new instrument order; `source[k]`
+    // is the old index of new instrument k, or -1 for a new one
+    void relayout(const std::vector<long>& source) {
+        size_t oldN = lastPrices.size();
+        size_t n = source.size();
+        std::vector<double> newRing(window * n, 0.0), newPrices(n, 0.0);
+        for (size_t k = 0; k < n; ++k) {
+            if (source[k] < 0) continue;
+            newPrices[k] = lastPrices[source[k]];
+            for (size_t row = 0; row < window; ++row) {
+                newRing[row * n + k] = ring[row * oldN + source[k]];
+            }
+        }
+        ring = std::move(newRing);
+        lastPrices = std::move(newPrices);
+        ++version;
+        ++layoutVersion;
+        appended = 0;
+        sums.assign(n, 0.0);
+        cross.assign(n * n, 0.0);
+        scratch.assign(n, 0.0);
+        resync();
+    }
+
+public:
+    explicit CovarianceEngine(size_t window = 90) : window(std::max<size_t>(2, window)) {}
+    
+    size_t getWindow() const { return window; }
+    size_t getCount() const { return count; }
+    size_t size() const { return ids.size(); }
+    const std::vector<SymbolId>& getIds() const { return ids; }
+    bool contains(SymbolId id) const { return id < slots.size() && slots[id] != 0; }
+    size_t indexOf(SymbolId id) const { return slots[id] - 1; }
+    std::uint64_t getVersion() const { return version; }
+    std::uint64_t getLayoutVersion() const { return layoutVersion; }
+    std::uint64_t getAppendedCount() const { return appended; }
+    
+    // Return vector of sample k in the window, k = 0 is the oldest
+    const double* sample(size_t k) const {
+        return &ring[((head + window - count + k) % window) * dimension()];
+    }
+    
+    double mean(size_t i) const {
+        return count ? sums[i] / static_cast<double>(count) : 0.0;
+    }
+    
+    // True once there are enough samples for a sample covariance
+    bool isReady() const { return count >= 2 && !ids.empty(); }
+    
+    // Track a new instrument; its returns count as zero for ticks before it
+    // was added
+    void addInstrument(SymbolId id) {
+        if (contains(id)) return;
+        if (id >= slots.size()) slots.resize(id + 1, 0);
+        std::vector<long> source(ids.size() + 1);
+        std::iota(source.begin(), source.end() - 1, 0L);
+        source.back() = -1;
+        ids.push_back(id);
+        slots[id] = static_cast<std::uint32_t>(ids.size());
+        relayout(source);
+    }
+    
+    void removeInstrument(SymbolId id) {
+        if (!contains(id)) return;
+        size_t removed = indexOf(id);
+        std::vector<long> source;
+        std::vector<SymbolId> kept;
+        for (size_t k = 0; k < ids.size(); ++k) {
+            if (k == removed) continue;
+            source.push_back(static_cast<long>(k));
+            kept.push_back(ids[k]);
+        }
+        slots[id] = 0;
+        ids = std::move(kept);
+        for (size_t k = 0; k < ids.size(); ++k) {
+            slots[ids[k]] = static_cast<std::uint32_t>(k + 1);
+        }
+        relayout(source);
+    }
+    
+    // Drop all samples but keep the instruments
+    void reset() {
+        std::fill(ring.begin(), ring.end(), 0.0);
+        std::fill(lastPrices.begin(), lastPrices.end(), 0.0);
+        head = count = 0;
+        ++version;
+        ++layoutVersion;
+        appended = 0;
+        resync();
+    }
+    
+    // One tick of returns, in instrument order
+    void addReturns(const double* returns) {
+        size_t n = dimension();
+        double* slot = &ring[head * n];
+        if (count == window) {
+            scratch.assign(slot, slot + n);
+        } else {
+            std::fill(scratch.begin(), scratch.end(), 0.0);
+        }
+        std::copy_n(returns, n, slot);
+        rankUpdate(slot, scratch.data());
+        
+        head = (head + 1) % window;
+        count = std::min(count + 1, window);
+        ++version;
+        ++appended;
+        if (++updatesSinceResync >= 4 * window) {
+            resync();
+        }
+    }
+    
+    // One tick of prices; instruments missing from `prices` or seen for
+    // the first time contribute a zero return
+    void update(const SymbolMap<double>& prices) {
+        size_t n = dimension();
+        if (n == 0) return;
+        std::vector<double> returns(n, 0.0);
+        bool any = false;
+        for (size_t k = 0; k < n; ++k) {
+            const double* price = prices.find(ids[k]);
+            if (!price || *price <= 0.0) continue;
+            if (lastPrices[k] > 0.0) {
+                returns[k] = *price / lastPrices[k] - 1.0;
+                any = true;
+            }
+            lastPrices[k] = *price;
+        }
+        if (any) addReturns(returns.data());
+    }
+    
+    // Rebuild from price history: aligned returns over the common tail of
+    // the series, one series per instrument in getIds() order
+    void seed(const std::vector<const PriceSeries*>& series) {
+        if (series.size() != dimension()) return;
+        reset();
+        std::vector<double> history = jointReturns(series);
+        size_t n = dimension();
+        size_t samples = n ? history.size() / n : 0;
+        size_t first = samples > window ? samples - window : 0;
+        for (size_t s = first; s < samples; ++s) {
+            addReturns(&history[s * n]);
+        }
+        for (size_t k = 0; k < n; ++k) {
+            if (!series[k]->empty()) lastPrices[k] = series[k]->lastPrice();
+        }
+    }
+    
+    double covariance(size_t i, size_t j) const {
+        if (count < 2) return 0.0;
+        size_t n = dimension();
+        double m = static_cast<double>(count);
+        return (cross[i * n + j] - sums[i] * sums[j] / m) / (m - 1.0);
+    }
+    
+    double correlation(size_t i, size_t j) const {
+        double denom = std::sqrt(covariance(i, i) * covariance(j, j));
+        return denom > 0.0 ? covariance(i, j) / denom : 0.0;
+    }
+    
+    // Portfolio variance w^T Sigma w for weights in instrument order,
+    // evaluated straight from the running sums as
+    //   (w^T C w - (w^T s)^2 / m) / (m - 1).
+    // The quadratic form walks only upper-triangle tiles and doubles the
+    // off-diagonal ones; rows inside a tile are contiguous, with four
+    // accumulators so the inner loop vectorises.
+    double portfolioVariance(const double* weights) const {
+        if (count < 2) return 0.0;
+        size_t n = dimension();
+        double quadratic = 0.0;
+        
+        for (size_t ib = 0; ib < n; ib += kBlock) {
+            size_t iEnd = std::min(n, ib + kBlock);
+            for (size_t jb = ib; jb < n; jb += kBlock) {
+                size_t jEnd = std::min(n, jb + kBlock);
+                double tile = 0.0;
+                for (size_t i = ib; i < iEnd; ++i) {
+                    double wi = weights[i];
+                    if (wi == 0.0) continue;
+                    const double* row = &cross[i * n];
+                    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+                    size_t j = jb;
+                    for (; j + 4 <= jEnd; j += 4) {
+                        for (size_t lane = 0; lane < 4; ++lane) {
+                            acc[lane] += row[j + lane] * weights[j + lane];
+                        }
+                    }
+                    for (; j < jEnd; ++j) {
+                        acc[0] += row[j] * weights[j];
+                    }
+                    tile += wi * ((acc[0] + acc[1]) + (acc[2] + acc[3]));
+                }
+                quadratic += jb == ib ? tile : 2.0 * tile;
+            }
+        }
+        
+        double linear = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            linear += weights[i] * sums[i];
+        }
+        double m = static_cast<double>(count);
+        return std::max(0.0, (quadratic - linear * linear / m) / (m - 1.0));
+    }
+    
+    // out = Sigma * w, the gradient of w^T Sigma w / 2
+    void covarianceTimes(const double* weights, double* out) const {
+        size_t n = dimension();
+        std::fill_n(out, n, 0.0);
+        if (count < 2) return;
+        
+        double linear = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            linear += weights[i] * sums[i];
+        }
+        double m = static_cast<double>(count);
+        for (size_t i = 0; i < n; ++i) {
+            const double* row = &cross[i * n];
+            double acc[4] = {0.0, 0.0, 0.0, 0.0};
+            size_t j = 0;
+            for (; j + 4 <= n; j += 4) {
+                for (size_t lane = 0; lane < 4; ++lane) {
+                    acc[lane] += row[j + lane] * weights[j + lane];
+                }
+            }
+            for (; j < n; ++j) {
+                acc[0] += row[j] * weights[j];
+            }
+            double product = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+            out[i] = (product - sums[i] * linear / m) / (m - 1.0);
+        }
+    }
+    
+    // Value weights of the holdings in instrument order; instruments not
+    // held get zero weight and holdings not tracked are ignored
+    std::vector<double> weightsFor(const PortfolioSnapshot& snapshot) const {
+        std::vector<double> weights(dimension(), 0.0);
+        if (snapshot.getTotalValue() <= 0.0) return weights;
+        const auto& percentages = snapshot.getWeights();
+        for (size_t k = 0; k < ids.size(); ++k) {
+            if (snapshot.contains(ids[k])) {
+                weights[k] = percentages[snapshot.rowOf(ids[k])] / 100.0;
+            }
+        }
+        return weights;
+    }
+    
+    // Portfolio volatility in percent per tick, the same unit as
+    // Asset::getVolatility()
+    double portfolioVolatility(const PortfolioSnapshot& snapshot) const {
+        std::vector<double> weights = weightsFor(snapshot);
+        return std::sqrt(portfolioVariance(weights.data())) * 100.0;
+    }
+    
+    // Aligned simple returns over the common tail of several price series,
+    // row-major with one row per observation; empty if fewer than 2 points
+    static std::vector<double> jointReturns(const std::vector<const PriceSeries*>& series) {
+        if (series.empty()) return {};
+        size_t common = std::numeric_limits<size_t>::max();
+        for (const PriceSeries* s : series) {
+            common = std::min(common, s->size());
+        }
+        if (common < 2) return {};
+        
+        size_t n = series.size();
+        std::vector<double> returns((common - 1) * n);
+        for (size_t t = 0; t + 1 < common; ++t) {
+            size_t k = common - 2 - t;   // Oldest observation first
+            for (size_t a = 0; a < n; ++a) {
+                double previous = series[a]->tailPrice(k + 1);
+                returns[t * n + a] = previous != 0.0 ? series[a]->tailPrice(k) / previous - 1.0 : 0.0;
+            }
+        }
+        return returns;
+    }
+};
+
+// Close-to-close daily returns per instrument, on UTC calendar days (the
+// day boundary Utils::parseDate and PriceTable use). A day's close is the
+// last price seen that day, and the day becomes one return sample when a
+// price for a later day arrives; instruments without a price that day
+// contribute a zero return. Samples go into a CovarianceEngine, so the
+// daily mean and covariance move by one rank-1 update per closed day.
+class DailyReturns {
+private:
+    struct Track {
+        double close = 0.0;          // Last price in the open day, 0 = none yet
+        double previousClose = 0.0;  // Close of the last day with a price
+    };
+    
+    static constexpr std::int32_t kNoDay = std::numeric_limits<std::int32_t>::min();
+    
+    CovarianceEngine engine;
+    SymbolMap<Track> tracks;
+    std::int32_t openDay = kNoDay;   // Day whose closes are still moving
+    std::int32_t lastClosedDay = kNoDay;
+    std::vector<double> returns;     // Scratch for one sample
+    
+    static std::int32_t dayOf(std::int64_t timestamp) {
+        std::int64_t day = timestamp / 86400;
+        if (timestamp % 86400 < 0) --day;
+        return static_cast<std::int32_t>(day);
+    }
+    
+    // Close the open day and move on to `day`
+    void rollTo(std::int32_t day) {
+        const std::vector<SymbolId>& ids = engine.getIds();
+        returns.assign(ids.size(), 0.0);
+        bool any = false;
+        for (size_t k = 0; k < ids.size(); ++k) {
+            Track& track = tracks[ids[k]];
+            if (track.close <= 0.0) continue;
+            if (track.previousClose > 0.0) {
+                returns[k] = track.close / track.previousClose - 1.0;
+                any = true;
+            }
+            track.previousClose = track.close;
+            track.close = 0.0;
+        }
+        if (any) {
+            engine.addReturns(returns.data());
+            lastClosedDay = openDay;
+        }
+        openDay = day;
+    }
+    
+    void observe(SymbolId id, std::int32_t day, double price) {
+        if (price <= 0.0) return;
+        if (openDay == kNoDay) openDay = day;
+        if (day < openDay) return;   // Late price for a day already closed
+        if (day > openDay) rollTo(day);
+        if (Track* track = tracks.find(id)) track->close = price;
+    }
+
+public:
+    explicit DailyReturns(size_t windowDays = 250) : engine(windowDays) {}
+    
+    const CovarianceEngine& getCovariance() const { return engine; }
+    size_t getWindowDays() const { return engine.getWindow(); }
+    size_t getDayCount() const { return engine.getCount(); }
+    
+    // Last day whose returns are in the window, as a Date; nullopt if none
+    std::optional<Date> getLastClosedDay() const {
+        if (lastClosedDay == kNoDay) return std::nullopt;
+        return Date{lastClosedDay};
+    }
+    
+    void addInstrument(SymbolId id) {
+        if (engine.contains(id)) return;
+        engine.addInstrument(id);
+        tracks[id] = Track{};
+    }
+    
+    void removeInstrument(SymbolId id) {
+        engine.removeInstrument(id);
+        tracks.erase(id);
+    }
+    
+    // One round of prices, all stamped `timestamp` (epoch seconds)
+    void update(const SymbolMap<double>& prices, std::int64_t timestamp) {
+        std::int32_t day = dayOf(timestamp);
+        for (const auto& [id, price] : prices) {
+            observe(id, day, price);
+        }
+    }
+    
+    // Rebuild from recorded history, `assets[k]` being instrument k in
+    // getIds() order: the full archive when one is attached, otherwise the
+    // in-memory series. The last day stays open for the prices to come.
+    void seed(const std::vector<const Asset*>& assets) {
+        const std::vector<SymbolId>& ids = engine.getIds();
+        if (assets.size() != ids.size()) return;
+        engine.reset();
+        for (SymbolId id : ids) tracks[id] = Track{};
+        openDay = lastClosedDay = kNoDay;
+        
+        // Each instrument's daily closes, oldest first
+        std::vector<std::vector<std::pair<std::int32_t, double>>> closes(ids.size());
+        for (size_t k = 0; k < ids.size(); ++k) {
+            auto& days = closes[k];
+            auto add = [&days](std::int64_t timestamp, double price) {
+                if (price <= 0.0) return;
+                std::int32_t day = dayOf(timestamp);
+                if (!days.empty() && days.back().first == day) {
+                    days.back().second = price;
+                } else if (days.empty() || days.back().first < day) {
+                    days.push_back({day, price});
+                }
+            };
+            std::shared_ptr<const PriceArchive> archive = assets[k]->getArchive();
+            if (archive && !archive->empty()) {
+                for (const PriceArchive::Record& record : archive->records()) {
+                    add(record.timestamp, record.price);
+                }
+            } else {
+                // Thinned older points still mark their day's close
+                const PriceSeries& series = assets[k]->getPriceHistory();
+                for (size_t i = 0; i < series.coarseSize(); ++i) {
+                    add(series.coarseTimestampAt(i), series.coarsePriceAt(i));
+                }
+                series.forEach(add);
+            }
+        }
+        
+        // Replay the closes day by day across instruments
+        std::vector<size_t> next(ids.size(), 0);
+        while (true) {
+            std::int32_t day = std::numeric_limits<std::int32_t>::max();
+            for (size_t k = 0; k < ids.size(); ++k) {
+                if (next[k] < closes[k].size()) day = std::min(day, closes[k][next[k]].first);
+            }
+            if (day == std::numeric_limits<std::int32_t>::max()) break;
+            for (size_t k = 0; k < ids.size(); ++k) {
+                if (next[k] < closes[k].size() && closes[k][next[k]].first == day) {
+                    observe(ids[k], day, closes[k][next[k]++].second);
+                }
+            }
+        }
+    }
+};
+
+// Value-at-Risk method
+enum class VaRMethod { Historical = 0, Parametric = 1, MonteCarlo = 2 };
+
+// Loss figures in currency, positive = loss
+struct VaRFigure {
+    double valueAtRisk = 0.0;
+    double expectedShortfall = 0.0;
+};
+
+// VaR and Expected Shortfall at one confidence level, by method
+struct RiskReport {
+    struct HoldingRisk {
+        SymbolId id;
+        double exposure;        // Market value
+        double marginalVaR;     // d VaR / d exposure (parametric, 1-day)
+        double componentVaR;    // exposure * marginal; components sum to the VaR
+    };
+    
+    double confidence = 0.95;
+    double portfolioValue = 0.0;
+    size_t samples = 0;                         // Daily returns behind the figures
+    std::array<VaRFigure, 3> oneDay{};          // Indexed by VaRMethod
+    std::array<VaRFigure, 3> horizon{};         // Over VaREngine::getHorizonDays()
+    std::vector<HoldingRisk> holdings;
+    
+    const VaRFigure& get(VaRMethod method, bool overHorizon = false) const {
+        return (overHorizon ? horizon : oneDay)[static_cast<size_t>(method)];
+    }
+};
+
+// VaR and Expected Shortfall over DailyReturns' window of daily returns:
+//  - historical: current exposures revalued under each stored day's
+//    returns; the horizon figure is scaled by sqrt(days)
+//  - parametric: normal with the daily mean and covariance, plus marginal
+//    and component VaR per holding
+//  - Monte Carlo: correlated normal daily returns compounded over the
+//    horizon, drawn through the window's centred returns as factors (so a
+//    step costs window x n, not a Cholesky of Sigma)
+// Recalculation is incremental. Historical and simulated losses are linear
+// in the exposures, so the engine keeps one loss per day and per path and
+// adjusts them by the change in each exposure. A closed day adds one loss
+// and drops the one leaving the window; only then are the simulated paths
+// redrawn. Parametric figures come straight from the daily covariance
+// engine's running sums.
+class VaREngine {
+private:
+    static constexpr size_t kMinSamples = 10;     // Fewer daily returns give no report
+    static constexpr size_t kResyncEvery = 256;   // Incremental updates between full rebuilds
+    
+    std::vector<double> confidenceLevels;
+    int horizonDays;
+    size_t monteCarloPaths;
+    
+    std::uint64_t cachedHoldingsVersion = ~0ull;
+    std::uint64_t cachedLayoutVersion = ~0ull;
+    std::uint64_t cachedAppended = 0;
+    size_t updatesSinceResync = 0;
+    std::vector<RiskReport> cachedReports;
+    
+    std::vector<double> exposure;             // Exposures the losses below reflect, instrument order
+    std::deque<double> historical;            // Loss per daily sample, oldest first
+    std::vector<double> pathDay, pathHorizon; // Per path x instrument: day-one and horizon return
+    std::vector<double> simulatedDay, simulatedHorizon; // Loss per path
+    std::vector<double> scratch;
+    
+    // Loss quantile and mean of the tail beyond it; `losses` is reordered
+    static VaRFigure tailOf(std::vector<double>& losses, double confidence) {
+        VaRFigure figure;
+        if (losses.empty()) return figure;
+        size_t index = std::min(losses.size() - 1,
+                                static_cast<size_t>(std::ceil(confidence * losses.size())) - 1);
+        std::nth_element(losses.begin(), losses.begin() + index, losses.end());
+        figure.valueAtRisk = std::max(0.0, losses[index]);
+        
+        double tail = 0.0;
+        size_t tailCount = 0;
+        for (size_t i = index; i < losses.size(); ++i) {
+            tail += losses[i];
+            ++tailCount;
+        }
+        figure.expectedShortfall = std::max(figure.valueAtRisk, tail / tailCount);
+        return figure;
+    }
+    
+    // Tail figures of a loss vector that must keep its order
+    template <typename Losses>
+    VaRFigure tailOfCopy(const Losses& losses, double confidence) {
+        scratch.assign(losses.begin(), losses.end());
+        return tailOf(scratch, confidence);
+    }
+    
+    double lossOf(const double* returns) const {
+        double pnl = 0.0;
+        for (size_t a = 0; a < exposure.size(); ++a) {
+            pnl += exposure[a] * returns[a];
+        }
+        return -pnl;
+    }
+    
+    void rebuildHistorical(const CovarianceEngine& covariance) {
+        historical.clear();
+        for (size_t k = 0; k < covariance.getCount(); ++k) {
+            historical.push_back(lossOf(covariance.sample(k)));
+        }
+    }
+    
+    void rebuildSimulatedLosses() {
+        size_t n = exposure.size();
+        size_t paths = n ? pathDay.size() / n : 0;
+        simulatedDay.assign(paths, 0.0);
+        simulatedHorizon.assign(paths, 0.0);
+        for (size_t p = 0; p < paths; ++p) {
+            simulatedDay[p] = lossOf(&pathDay[p * n]);
+            simulatedHorizon[p] = lossOf(&pathHorizon[p * n]);
+        }
+    }
+    
+    // Draw every path's day-one and horizon returns per instrument
+    void simulatePaths(const CovarianceEngine& covariance) {
+        size_t n = covariance.size();
+        size_t m = covariance.getCount();
+        std::vector<double> means(n), factors(m * n);
+        for (size_t a = 0; a < n; ++a) {
+            means[a] = covariance.mean(a);
+        }
+        double scale = 1.0 / std::sqrt(static_cast<double>(m - 1));
+        for (size_t k = 0; k < m; ++k) {
+            const double* r = covariance.sample(k);
+            for (size_t a = 0; a < n; ++a) {
+                factors[k * n + a] = (r[a] - means[a]) * scale;
+            }
+        }
+        
+        size_t paths = monteCarloPaths;
+        pathDay.assign(paths * n, 0.0);
+        pathHorizon.assign(paths * n, 0.0);
+        const size_t block = 256;
+        size_t blocks = (paths + block - 1) / block;
+        const RandomService& service = RandomService::global();
+        
+        ThreadPool::global().parallelFor(0, blocks, 1, [&](size_t begin, size_t end) {
+            std::vector<double> z(m), growth(n), step(n);
+            for (size_t b = begin; b < end; ++b) {
+                RandomStream rng = service.stream(RandomService::Domain::Risk, static_cast<std::uint32_t>(b));
+                for (size_t p = b * block; p < std::min(paths, (b + 1) * block); ++p) {
+                    std::fill(growth.begin(), growth.end(), 1.0);
+                    for (int day = 0; day < horizonDays; ++day) {
+                        rng.fillNormal(z.data(), m);
+                        std::copy(means.begin(), means.end(), step.begin());
+                        for (size_t k = 0; k < m; ++k) {
+                            const double* f = &factors[k * n];
+                            double zk = z[k];
+                            for (size_t a = 0; a < n; ++a) {
+                                step[a] += zk * f[a];
+                            }
+                        }
+                        for (size_t a = 0; a < n; ++a) {
+                            growth[a] *= 1.0 + step[a];
+                        }
+                        if (day == 0) std::copy(step.begin(), step.end(), &pathDay[p * n]);
+                    }
+                    for (size_t a = 0; a < n; ++a) {
+                        pathHorizon[p * n + a] = growth[a] - 1.0;
+                    }
+                }
+            }
+        });
+    }
+    
+    // Bring the loss vectors up to date with `target` exposures; false if
+    // they have to be rebuilt instead
+    bool updateIncrementally(const CovarianceEngine& covariance, const std::vector<double>& target) {
+        size_t n = target.size();
+        size_t count = covariance.getCount();
+        if (covariance.getLayoutVersion() != cachedLayoutVersion || exposure.size() != n ||
+            ++updatesSinceResync >= kResyncEvery) {
+            return false;
+        }
+        std::uint64_t added = covariance.getAppendedCount() - cachedAppended;
+        if (added >= count) return false;
+        
+        // Days that left the window, then the change in each exposure over
+        // the days still held, then the new days at the new exposures
+        size_t kept = count - static_cast<size_t>(added);
+        while (historical.size() > kept) historical.pop_front();
+        size_t paths = simulatedDay.size();
+        for (size_t a = 0; a < n; ++a) {
+            double delta = target[a] - exposure[a];
+            if (delta == 0.0) continue;
+            for (size_t k = 0; k < kept; ++k) {
+                historical[k] -= delta * covariance.sample(k)[a];
+            }
+            if (added == 0) {
+                for (size_t p = 0; p < paths; ++p) {
+                    simulatedDay[p] -= delta * pathDay[p * n + a];
+                    simulatedHorizon[p] -= delta * pathHorizon[p * n + a];
+                }
+            }
+        }
+        exposure = target;
+        for (size_t k = kept; k < count; ++k) {
+            historical.push_back(lossOf(covariance.sample(k)));
+        }
+        
+        // A new day changes the factors behind every path
+        if (added > 0) {
+            simulatePaths(covariance);
+            rebuildSimulatedLosses();
+        }
+        return true;
+    }
+
+public:
+    VaREngine(std::vector<double> confidenceLevels = {0.95, 0.99}, int horizonDays = 10,
+              size_t monteCarloPaths = 10000)
+        : confidenceLevels(std::move(confidenceLevels)), horizonDays(std::max(1, horizonDays)),
+          monteCarloPaths(std::max<size_t>(100, monteCarloPaths)) {}
+    
+    void setConfidenceLevels(const std::vector<double>& levels) {
+        confidenceLevels = levels;
+        invalidate();
+    }
+    
+    void setHorizonDays(int days) {
+        horizonDays = std::max(1, days);
+        invalidate();
+    }
+    
+    void setMonteCarloPaths(size_t paths) {
+        monteCarloPaths = std::max<size_t>(100, paths);
+        invalidate();
+    }
+    
+    const std::vector<double>& getConfidenceLevels() const { return confidenceLevels; }
+    int getHorizonDays() const { return horizonDays; }
+    
+    void invalidate() {
+        cachedHoldingsVersion = cachedLayoutVersion = ~0ull;
+        exposure.clear();
+    }
+    
+    // One report per confidence level; empty until the window holds enough days
+    const std::vector<RiskReport>& evaluate(const PortfolioSnapshot& snapshot, const DailyReturns& daily) {
+        const CovarianceEngine& covariance = daily.getCovariance();
+        if (snapshot.getVersion() == cachedHoldingsVersion &&
+            covariance.getLayoutVersion() == cachedLayoutVersion &&
+            covariance.getAppendedCount() == cachedAppended) {
+            return cachedReports;
+        }
+        cachedHoldingsVersion = snapshot.getVersion();
+        cachedReports.clear();
+        if (covariance.getCount() < kMinSamples || covariance.size() == 0) {
+            invalidate();
+            cachedHoldingsVersion = snapshot.getVersion();
+            return cachedReports;
+        }
+        
+        double total = snapshot.getTotalValue();
+        std::vector<double> target = covariance.weightsFor(snapshot);
+        for (double& e : target) e *= total;
+        if (!updateIncrementally(covariance, target)) {
+            exposure = std::move(target);
+            rebuildHistorical(covariance);
+            simulatePaths(covariance);
+            rebuildSimulatedLosses();
+            updatesSinceResync = 0;
+        }
+        cachedLayoutVersion = covariance.getLayoutVersion();
+        cachedAppended = covariance.getAppendedCount();
+        
+        size_t n = exposure.size();
+        double sqrtHorizon = std::sqrt(static_cast<double>(horizonDays));
+        
+        // Parametric moments and the gradient for marginal VaR
+        double mu = 0.0;
+        for (size_t a = 0; a < n; ++a) {
+            mu += exposure[a] * covariance.mean(a);
+        }
+        std::vector<double> sigmaTimesExposure(n);
+        covariance.covarianceTimes(exposure.data(), sigmaTimesExposure.data());
+        double sigma = std::sqrt(std::max(0.0, covariance.portfolioVariance(exposure.data())));
+        
+        for (double confidence : confidenceLevels) {
+            RiskReport report;
+            report.confidence = confidence;
+            report.portfolioValue = total;
+            report.samples = covariance.getCount();
+            
+            VaRFigure& historicalDay = report.oneDay[static_cast<size_t>(VaRMethod::Historical)];
+            historicalDay = tailOfCopy(historical, confidence);
+            report.horizon[static_cast<size_t>(VaRMethod::Historical)] = {
+                historicalDay.valueAtRisk * sqrtHorizon, historicalDay.expectedShortfall * sqrtHorizon};
+            
+            double z = Utils::inverseNormalCDF(confidence);
+            double tailDensity = Utils::normalPDF(z) / (1.0 - confidence);
+            report.oneDay[static_cast<size_t>(VaRMethod::Parametric)] = {
+                std::max(0.0, z * sigma - mu), std::max(0.0, tailDensity * sigma - mu)};
+            report.horizon[static_cast<size_t>(VaRMethod::Parametric)] = {
+                std::max(0.0, z * sigma * sqrtHorizon - mu * horizonDays),
+                std::max(0.0, tailDensity * sigma * sqrtHorizon - mu * horizonDays)};
+            
+            report.oneDay[static_cast<size_t>(VaRMethod::MonteCarlo)] = tailOfCopy(simulatedDay, confidence);
+            report.horizon[static_cast<size_t>(VaRMethod::MonteCarlo)] = tailOfCopy(simulatedHorizon, confidence);
+            
+            // Euler allocation of parametric VaR: components sum to z * sigma - mu
+            const auto& ids = covariance.getIds();
+            for (size_t a = 0; a < n; ++a) {
+                if (exposure[a] == 0.0) continue;
+                double marginal = (sigma > 0.0 ? z * sigmaTimesExposure[a] / sigma : 0.0) - covariance.mean(a);
+                report.holdings.push_back({ids[a], exposure[a], marginal, exposure[a] * marginal});
+            }
+            cachedReports.push_back(std::move(report));
+        }
+        return cachedReports;
+    }
+};
+
+// Response to one HTTP GET; status 0 means the transfer itself failed
+struct HttpResponse {
+    long status = 0;
+    std::string body;
+    std::string error;
+    
+    bool ok() const { return status == 200; }
+};
+
+struct HttpClientConfig {
+    long connectTimeoutMs = 3000;
+    long timeoutMs = 10000;
+    long maxConnectionsPerHost = 8;      // Only matters for HTTP/1.1; HTTP/2 multiplexes
+    long maxTotalConnections = 32;
+    bool http2 = true;                  // Negotiated over TLS; plain http stays on 1.1
+    bool verifyPeer = false;
+};
+
+// HTTP client on the curl multi interface. All requests of a batch are in
+// flight together, so a batch takes as long as its slowest response. The
+// multi handle owns the connection cache, so connections stay alive across
+// batches and HTTP/2 streams to one host share a single connection; easy
+// handles go back to a pool instead of being destroyed.
+class HttpClient {
+private:
+    HttpClientConfig config;
+    CURLM* multi = nullptr;
+    std::vector<CURL*> idle;
+    std::mutex mutex;                   // One batch at a time on the shared multi handle
+    
+    CURL* acquire() {
+        if (!idle.empty()) {
+            CURL* easy = idle.back();
+            idle.pop_back();
+            curl_easy_reset(easy);
+            return easy;
+        }
+        return curl_easy_init();
+    }
+    
+    void configure(CURL* easy, const std::string& url, HttpResponse* response) {
+        curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, Utils::WriteCallback);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response->body);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, response);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, config.timeoutMs);
+        curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, config.connectTimeoutMs);
+        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, config.verifyPeer ? 1L : 0L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (config.http2) {
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+            // Over TLS, wait for an existing connection to offer multiplexing
+            // rather than opening a parallel one
+            if (url.compare(0, 8, "https://") == 0) {
+                curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+            }
+        }
+    }
+    
+    // Record every finished transfer and return its handle to the pool
+    void collect(std::vector<CURL*>& active) {
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            CURL* easy = message->easy_handle;
+            char* privateData = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &privateData);
+            HttpResponse* response = reinterpret_cast<HttpResponse*>(privateData);
+            if (message->data.result == CURLE_OK) {
+                curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response->status);
+            } else {
+                response->error = curl_easy_strerror(message->data.result);
+            }
+            curl_multi_remove_handle(multi, easy);
+            active.erase(std::find(active.begin(), active.end(), easy));
+            idle.push_back(easy);
+        }
+    }
+
+public:
+    explicit HttpClient(const HttpClientConfig& config = {}) : config(config) {
+        // Reference-counted by libcurl, so each client can pair its own
+        // init with a cleanup
+        curl_global_init(CURL_GLOBAL_ALL);
+        multi = curl_multi_init();
+        if (multi) {
+            curl_multi_setopt(multi, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX));
+            curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, config.maxConnectionsPerHost);
+            curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, config.maxTotalConnections);
+        }
+    }
+    
+    ~HttpClient() {
+        for (CURL* easy : idle) {
+            curl_easy_cleanup(easy);
+        }
+        if (multi) {
+            curl_multi_cleanup(multi);
+        }
+        curl_global_cleanup();
+    }
+    
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+    
+    // GET every URL concurrently; responses are in the order of `urls`
+    std::vector<HttpResponse> getAll(const std::vector<std::string>& urls) {
+        std::vector<HttpResponse> responses(urls.size());
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!multi) {
+            for (HttpResponse& response : responses) response.error = "cURL multi handle unavailable";
+            return responses;
+        }
+        
+        std::vector<CURL*> active;
+        for (size_t i = 0; i < urls.size(); ++i) {
+            CURL* easy = acquire();
+            if (!easy) {
+                responses[i].error = "Failed to initialize cURL";
+                continue;
+            }
+            configure(easy, urls[i], &responses[i]);
+            curl_multi_add_handle(multi, easy);
+            active.push_back(easy);
+        }
+        
+        int running = static_cast<int>(active.size());
+        while (running > 0) {
+            CURLMcode code = curl_multi_perform(multi, &running);
+            if (code == CURLM_OK && running > 0) {
+                code = curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+            }
+            if (code != CURLM_OK) {
+                for (CURL* easy : active) {
+                    char* privateData = nullptr;
+                    curl_easy_getinfo(easy, CURLINFO_PRIVATE, &privateData);
+                    reinterpret_cast<HttpResponse*>(privateData)->error = curl_multi_strerror(code);
+                }
+                break;
+            }
+            collect(active);
+        }
+        collect(active);
+        
+        // Anything still attached was abandoned by a multi-level error
+        for (CURL* easy : active) {
+            curl_multi_remove_handle(multi, easy);
+            idle.push_back(easy);
+        }
+        return responses;
+    }
+    
+    HttpResponse get(const std::string& url) {
+        return std::move(getAll({url}).front());
+    }
+};
+
+// Base URLs of the quote providers
+struct MarketDataEndpoints {
+    std::string crypto = "https://api.coingecko.com/api/v3";
+    std::string forex = "https://api.exchangerate-api.com/v4";
+    std::string metals = "https://forex-data-feed.swissquote.com/public-quotes/bboquotes/instrument";
+    std::string stocks = "https://finnhub.io/api/v1";
+    
+    // Every provider served from one base URL, e.g. a local stand-in server
+    // at "http://127.0.0.1:8080" answering /simple/price, /latest/<BASE>,
+    // /<METAL>/<QUOTE> and /quote, like the one --benchmark starts
+    static MarketDataEndpoints local(const std::string& base) {
+        return {base, base, base, base};
+    }
+    
+    // Endpoints new fetchers start with
+    static MarketDataEndpoints& defaults() {
+        static MarketDataEndpoints endpoints;
+        return endpoints;
+    }
+};
+
+// Path to a value in a JSON document: object keys, with "*" standing for
+// any element of an array, e.g. {"rates", "USD"} or {"*", "bid"}
+using JsonPath = std::vector<std::string>;
+
+// Pulls numbers at chosen paths out of a JSON document in one forward
+// scan, without building a DOM. Members and elements that no target path
+// runs through are skipped by bracket matching, never tokenized, and the
+// scan stops as soon as every target group is settled, so most of a
+// large response is never looked at. A group is a set of alternative
+// paths for one value; found(group) returns the first alternative, in
+// the order added, that matched. A group is settled once its first
+// alternative matches; until then the scan goes on, since a preferred
+// path may still appear later in the document. Skipped regions are not
+// validated.
+class JsonFieldExtractor {
+private:
+    struct Target {
+        JsonPath path;
+        size_t group;
+        bool preferred;                 // First alternative added for its group
+        double value = 0.0;
+        bool found = false;
+    };
+    
+    std::vector<Target> targets;
+    std::vector<char> groupSettled;
+    size_t groupsRemaining = 0;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    std::string error;
+    
+    bool fail(const char* message) {
+        if (error.empty()) error = message;
+        return false;
+    }
+    
+    void skipWhitespace() {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')) {
+            ++cursor;
+        }
+    }
+    
+    // Cursor on the opening quote; leaves it past the closing one. Keys
+    // without escapes (nearly all) are returned as views into the text.
+    bool readString(std::string_view& out, std::string& decoded) {
+        const char* start = ++cursor;
+        bool escaped = false;
+        while (cursor < end && *cursor != '"') {
+            if (*cursor == '\\') {
+                escaped = true;
+                ++cursor;
+            }
+            ++cursor;
+        }
+        if (cursor >= end) return fail("unterminated string");
+        out = std::string_view(start, static_cast<size_t>(cursor - start));
+        ++cursor;
+        if (escaped) {
+            // Simple escapes only; keys we look for are plain ASCII
+            decoded.clear();
+            for (size_t i = 0; i < out.size(); ++i) {
+                if (out[i] == '\\' && i + 1 < out.size()) ++i;
+                decoded += out[i];
+            }
+            out = decoded;
+        }
+        return true;
+    }
+    
+    // Skip one value of any type without interpreting it
+    bool skipValue() {
+        skipWhitespace();
+        if (cursor >= end) return fail("unexpected end of input");
+        if (*cursor == '"') {
+            std::string_view ignored;
+            std::string scratch;
+            return readString(ignored, scratch);
+        }
+        if (*cursor != '{' && *cursor != '[') {
+            while (cursor < end && *cursor != ',' && *cursor != '}' && *cursor != ']' &&
+                   *cursor != ' ' && *cursor != '\n' && *cursor != '\r' && *cursor != '\t') {
+                ++cursor;
+            }
+            return true;
+        }
+        int depth = 0;
+        while (cursor < end) {
+            char c = *cursor++;
+            if (c == '"') {
+                while (cursor < end && *cursor != '"') {
+                    if (*cursor == '\\') ++cursor;
+                    ++cursor;
+                }
+                ++cursor;
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return true;
+            }
+        }
+        return fail("unexpected end of input");
+    }
+    
+    // Parse the value at depth `depth`; `candidates` are the unfound
+    // targets whose first `depth` components match the path so far
+    bool parseValue(const std::vector<size_t>& candidates, size_t depth) {
+        skipWhitespace();
+        if (cursor >= end) return fail("unexpected end of input");
+        
+        char c = *cursor;
+        if (c == '{' || c == '[') {
+            bool isObject = c == '{';
+            char close = isObject ? '}' : ']';
+            ++cursor;
+            skipWhitespace();
+            if (cursor < end && *cursor == close) {
+                ++cursor;
+                return true;
+            }
+            
+            std::vector<size_t> next;
+            std::string decoded;
+            while (groupsRemaining > 0) {
+                std::string_view component = "*";
+                if (isObject) {
+                    skipWhitespace();
+                    if (cursor >= end || *cursor != '"') return fail("expected object key");
+                    if (!readString(component, decoded)) return false;
+                    skipWhitespace();
+                    if (cursor >= end || *cursor != ':') return fail("expected ':'");
+                    ++cursor;
+                }
+                
+                next.clear();
+                for (size_t t : candidates) {
+                    const Target& target = targets[t];
+                    if (!target.found && !groupSettled[target.group] &&
+                        target.path.size() > depth && target.path[depth] == component) {
+                        next.push_back(t);
+                    }
+                }
+                if (!(next.empty() ? skipValue() : parseValue(next, depth + 1))) return false;
+                if (groupsRemaining == 0) return true;
+                
+                skipWhitespace();
+                if (cursor >= end) return fail("unexpected end of input");
+                if (*cursor == ',') {
+                    ++cursor;
+                } else if (*cursor == close) {
+                    ++cursor;
+                    return true;
+                } else {
+                    return fail(isObject ? "expected ',' or '}'" : "expected ',' or ']'");
+                }
+            }
+            return true;
+        }
+        
+        // Scalar: only numbers at a target's full path are converted
+        bool wanted = false;
+        for (size_t t : candidates) {
+            if (targets[t].path.size() == depth) wanted = true;
+        }
+        if (!wanted || (c != '-' && (c < '0' || c > '9'))) {
+            return skipValue();
+        }
+        char* numberEnd = nullptr;
+        double number = std::strtod(cursor, &numberEnd);
+        if (numberEnd == cursor) return fail("malformed number");
+        cursor = numberEnd;
+        for (size_t t : candidates) {
+            Target& target = targets[t];
+            if (target.path.size() != depth || target.found) continue;
+            target.value = number;
+            target.found = true;
+            if (target.preferred && !groupSettled[target.group]) {
+                groupSettled[target.group] = 1;
+                --groupsRemaining;
+            }
+        }
+        return true;
+    }
+
+public:
+    // Register an alternative path for value group `group`, after (and
+    // so less preferred than) those already added for it
+    void addTarget(JsonPath path, size_t group) {
+        bool preferred = std::none_of(targets.begin(), targets.end(),
+                                      [group](const Target& target) { return target.group == group; });
+        targets.push_back({std::move(path), group, preferred});
+        if (group >= groupSettled.size()) {
+            groupsRemaining += group + 1 - groupSettled.size();
+            groupSettled.resize(group + 1, 0);
+        }
+    }
+    
+    // Scan `text` (which must stay alive and NUL-terminated, as any
+    // std::string is); false if it was malformed before every group was
+    // settled, with the reason in getError()
+    bool extract(const std::string& text) {
+        if (targets.empty()) return true;
+        cursor = text.c_str();
+        end = cursor + text.size();
+        std::vector<size_t> all(targets.size());
+        std::iota(all.begin(), all.end(), size_t{0});
+        return parseValue(all, 0) || groupsRemaining == 0;
+    }
+    
+    const double* found(size_t group) const {
+        for (const Target& target : targets) {
+            if (target.group == group && target.found) return &target.value;
+        }
+        return nullptr;
+    }
+    
+    const std::string& getError() const { return error; }
+};
+
+// Quote providers the fetcher knows how to address
+enum class QuoteProvider { CoinGecko, ExchangeRate, Metals, Stocks };
+
+// One HTTP request of a refresh and the symbols its response prices.
+// `paths` says where each symbol's price sits in the response, as
+// alternative JSON paths in order of preference.
+struct QuoteRequest {
+    QuoteProvider provider;
+    std::string url;
+    std::vector<SymbolId> symbols;
+    std::vector<std::vector<JsonPath>> paths;
+};
+
+// Groups the symbols of a refresh by provider and base so that each
+// response is fetched once: every coin in one CoinGecko call and one rates
+// call per base currency. Metals and stocks have no batch endpoint and
+// keep one request per symbol.
+class FetchPlanner {
+private:
+    // Shapes of single-quote responses: Swissquote's per-platform spread
+    // prices, Finnhub's current price, then generic ticker layouts
+    static std::vector<JsonPath> singleQuotePaths(QuoteProvider provider) {
+        std::vector<JsonPath> paths;
+        if (provider == QuoteProvider::Metals) {
+            paths.push_back({"*", "spreadProfilePrices", "*", "bid"});
+        } else {
+            paths.push_back({"c"});
+        }
+        paths.push_back({"price"});
+        paths.push_back({"data", "last"});
+        paths.push_back({"ticker", "price"});
+        return paths;
+    }
+
+public:
+    // CoinGecko id of a crypto symbol, empty if the symbol is not a coin
+    static std::string coinId(const std::string& symbol) {
+        static const std::map<std::string, std::string> ids = {
+            {"BTC", "bitcoin"},
+            {"ETH", "ethereum"}
+        };
+        auto it = ids.find(symbol);
+        return it != ids.end() ? it->second : std::string();
+    }
+    
+    static bool isMetal(const std::string& symbol) {
+        std::string base = symbol.substr(0, 3);
+        return symbol.size() > 3 && symbol[3] == '/' &&
+               (base == "XAU" || base == "XAG" || base == "XPT" || base == "XPD");
+    }
+    
+    static std::vector<QuoteRequest> plan(const std::vector<SymbolId>& symbols, const MarketDataEndpoints& endpoints,
+                                          const std::string& apiKey) {
+        std::vector<QuoteRequest> requests;
+        QuoteRequest coins{QuoteProvider::CoinGecko, "", {}, {}};
+        std::string coinIds;
+        std::map<std::string, size_t> ratesByBase;   // Base currency -> index in requests
+        SymbolMap<char> planned;                    // Symbols already assigned to a request
+        
+        for (SymbolId id : symbols) {
+            if (planned.contains(id)) continue;
+            planned[id] = 1;
+            const std::string& symbol = SymbolTable::global().name(id);
+            
+            std::string coin = coinId(symbol);
+            if (!coin.empty()) {
+                // {"bitcoin": {"usd": 43000.0}, ...}
+                coins.symbols.push_back(id);
+                coins.paths.push_back({{coin, "usd"}});
+                coinIds += (coinIds.empty() ? "" : ",") + coin;
+            } else if (isMetal(symbol)) {
+                requests.push_back({QuoteProvider::Metals, endpoints.metals + "/" + symbol, {id},
+                                    {singleQuotePaths(QuoteProvider::Metals)}});
+            } else if (symbol.find('/') != std::string::npos) {
+                // {"base": "EUR", "rates": {"USD": 1.09, ...}}
+                std::string base = symbol.substr(0, symbol.find('/'));
+                auto [it, added] = ratesByBase.emplace(base, requests.size());
+                if (added) {
+                    requests.push_back({QuoteProvider::ExchangeRate, endpoints.forex + "/latest/" + base, {}, {}});
+                }
+                requests[it->second].symbols.push_back(id);
+                requests[it->second].paths.push_back({{"rates", symbol.substr(symbol.find('/') + 1)}});
+            } else {
+                requests.push_back({QuoteProvider::Stocks,
+                                    endpoints.stocks + "/quote?symbol=" + symbol + "&token=" + apiKey, {id},
+                                    {singleQuotePaths(QuoteProvider::Stocks)}});
+            }
+        }
+        
+        if (!coins.symbols.empty()) {
+            coins.url = endpoints.crypto + "/simple/price?ids=" + coinIds + "&vs_currencies=usd";
+            requests.insert(requests.begin(), std::move(coins));
+        }
+        return requests;
+    }
+};
+
+// Asset classes with their own quote freshness
+enum class QuoteClass { Crypto, Forex, Metal, Equity, Indicator };
+
+// A quote younger than `ttl` is served as is. Up to `ttl + staleWindow` it
+// is still served, while one background fetch refreshes it. Past that the
+// caller waits for a fresh fetch.
+struct QuoteFreshness {
+    std::chrono::milliseconds ttl;
+    std::chrono::milliseconds staleWindow;
+};
+
+// Per-symbol quote cache with stale-while-revalidate. Concurrent requests
+// for a symbol that has to be fetched are coalesced: the first caller runs
+// the fetch and the rest wait on its shared result, so there is at most
+// one fetch in flight per symbol. A quote put() while a fetch is in
+// flight is newer than the fetch, so the fetch's result is dropped and
+// its waiters get the put quote.
+class QuoteCache {
+public:
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t staleHits = 0;        // Served stale while a refresh ran
+        std::uint64_t fetches = 0;
+        std::uint64_t coalesced = 0;        // Waited on another caller's fetch
+    };
+
+private:
+    struct Entry {
+        double price = 0.0;
+        std::chrono::steady_clock::time_point fetchedAt;
+        bool valid = false;
+        std::uint64_t puts = 0;                 // Bumped by put(), to spot fetches it overtook
+        std::shared_future<double> inFlight;    // Valid while a fetch is running
+    };
+    
+    mutable std::mutex mutex;
+    std::condition_variable idle;
+    SymbolMap<Entry> entries;
+    std::array<QuoteFreshness, 5> freshness;
+    size_t backgroundRefreshes = 0;
+    Stats stats;
+    
+    struct Fetch {
+        std::shared_ptr<std::promise<double>> promise;
+        std::uint64_t puts;                     // Entry's put count when the fetch began
+    };
+    
+    // Start a fetch for `id` under the lock; the caller runs it
+    Fetch beginFetch(SymbolId id) {
+        auto promise = std::make_shared<std::promise<double>>();
+        Entry& entry = entries[id];
+        entry.inFlight = promise->get_future().share();
+        ++stats.fetches;
+        return {promise, entry.puts};
+    }
+    
+    // Run a started fetch and publish its result to the cache and waiters,
+    // unless a put() since it began already stored a newer quote
+    double runFetch(SymbolId id, const Fetch& started, const std::function<double()>& fetch) {
+        const std::shared_ptr<std::promise<double>>& promise = started.promise;
+        double price;
+        try {
+            price = fetch();
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                entries[id].inFlight = {};
+            }
+            promise->set_exception(std::current_exception());
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Entry& entry = entries[id];
+            if (entry.puts == started.puts) {
+                entry.price = price;
+                entry.fetchedAt = std::chrono::steady_clock::now();
+                entry.valid = true;
+            } else if (entry.valid) {
+                price = entry.price;
+            }
+            entry.inFlight = {};
+        }
+        promise->set_value(price);
+        return price;
+    }
+
+public:
+    QuoteCache() {
+        using std::chrono::seconds;
+        freshness[static_cast<size_t>(QuoteClass::Crypto)] = {seconds(15), seconds(45)};
+        freshness[static_cast<size_t>(QuoteClass::Forex)] = {seconds(60), seconds(120)};
+        freshness[static_cast<size_t>(QuoteClass::Metal)] = {seconds(60), seconds(120)};
+        freshness[static_cast<size_t>(QuoteClass::Equity)] = {seconds(60), seconds(240)};
+        freshness[static_cast<size_t>(QuoteClass::Indicator)] = {seconds(60), seconds(240)};
+    }
+    
+    // Background refreshes call back into the owner, so wait for them
+    ~QuoteCache() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return backgroundRefreshes == 0; });
+    }
+    
+    QuoteCache(const QuoteCache&) = delete;
+    QuoteCache& operator=(const QuoteCache&) = delete;
+    
+    static QuoteClass classify(const std::string& symbol) {
+        if (!FetchPlanner::coinId(symbol).empty()) return QuoteClass::Crypto;
+        if (FetchPlanner::isMetal(symbol)) return QuoteClass::Metal;
+        if (symbol.find('/') != std::string::npos) return QuoteClass::Forex;
+        if (symbol == "VIX") return QuoteClass::Indicator;
+        return QuoteClass::Equity;
+    }
+    
+    void setFreshness(QuoteClass quoteClass, QuoteFreshness window) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freshness[static_cast<size_t>(quoteClass)] = window;
+    }
+    
+    // Cached quote for `id`, calling `fetch` only when the cache cannot
+    // answer. A background refresh runs `fetch` on the global thread pool,
+    // so it must stay callable until this cache is destroyed.
+    double get(SymbolId id, QuoteClass quoteClass, const std::function<double()>& fetch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        Entry& entry = entries[id];
+        
+        if (entry.valid) {
+            const QuoteFreshness& window = freshness[static_cast<size_t>(quoteClass)];
+            auto age = std::chrono::steady_clock::now() - entry.fetchedAt;
+            if (age < window.ttl) {
+                ++stats.hits;
+                return entry.price;
+            }
+            if (age < window.ttl + window.staleWindow) {
+                ++stats.staleHits;
+                double stale = entry.price;
+                if (!entry.inFlight.valid()) {
+                    Fetch started = beginFetch(id);
+                    ++backgroundRefreshes;
+                    ThreadPool::global().submit([this, id, started, fetch]() {
+                        try {
+                            runFetch(id, started, fetch);
+                        } catch (const std::exception& e) {
+                            std::cerr << "Quote refresh failed: " << e.what() << std::endl;
+                        } catch (...) {
+                            std::cerr << "Quote refresh failed" << std::endl;
+                        }
+                        std::lock_guard<std::mutex> done(mutex);
+                        if (--backgroundRefreshes == 0) idle.notify_all();
+                    });
+                }
+                return stale;
+            }
+        }
+        
+        if (entry.inFlight.valid()) {
+            ++stats.coalesced;
+            std::shared_future<double> pending = entry.inFlight;
+            lock.unlock();
+            return pending.get();
+        }
+        
+        Fetch started = beginFetch(id);
+        lock.unlock();
+        return runFetch(id, started, fetch);
+    }
+    
+    // Store a quote obtained elsewhere, e.g. by a batched refresh
+    void put(SymbolId id, double price) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entries[id];
+        entry.price = price;
+        entry.fetchedAt = std::chrono::steady_clock::now();
+        entry.valid = true;
+        ++entry.puts;
+    }
+    
+    void invalidate(SymbolId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (Entry* entry = entries.find(id)) entry->valid = false;
+    }
+    
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+};
+
+// Latest price per instrument, shared by fetch threads, analyzers and
+// reports without a lock. Every SymbolId has a fixed cache-line slot
+// (allocated in chunks that never move) guarded by its own sequence
+// number: a writer claims the slot by moving the sequence from even to
+// odd with a CAS, so writers to different symbols never meet and readers
+// never stall a writer. read() retries, yielding after a few spins, until
+// no write overlapped its copy; a slot is held for just two stores, but a
+// writer republishing one symbol without pause can keep that symbol's
+// readers retrying, so reads are lock-free rather than wait-free. snapshot() returns all prices as of one instant: writers count
+// themselves in and out on two board-wide counters, and a snapshot is
+// kept only if no write was in flight across the copy, so a batch
+// published together is seen whole or not at all. Under continuous
+// publishing that copy is retried a bounded number of times, then the
+// board is read slot by slot and the snapshot is flagged as possibly
+// mixing batches.
+class PriceBoard {
+public:
+    struct Quote {
+        double price = 0.0;             // 0 = never published
+        std::int64_t timestampMs = 0;
+        std::uint64_t version = 0;      // Number of publishes to this slot
+        
+        bool valid() const { return price > 0.0; }
+    };
+
+private:
+    static constexpr size_t kChunkSlots = 256;
+    static constexpr size_t kMaxChunks = 1024;  // Room for 262144 symbols
+    static constexpr unsigned kSnapshotAttempts = 64;  // Whole-board copies tried before reading slot by slot
+    
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> sequence{0};  // Odd while a writer holds the slot
+        std::atomic<double> price{0.0};
+        std::atomic<std::int64_t> timestampMs{0};
+    };
+    
+    std::unique_ptr<std::atomic<Slot*>[]> chunks;
+    std::atomic<std::uint32_t> extent{0};  // One past the highest published SymbolId
+    std::atomic<std::uint64_t> writesBegun{0};
+    std::atomic<std::uint64_t> writesFinished{0};
+    
+    const Slot* find(SymbolId id) const {
+        size_t chunk = id / kChunkSlots;
+        if (chunk >= kMaxChunks) return nullptr;
+        const Slot* slots = chunks[chunk].load(std::memory_order_acquire);
+        return slots ? &slots[id % kChunkSlots] : nullptr;
+    }
+    
+    Slot& slot(SymbolId id) {
+        size_t chunk = id / kChunkSlots;
+        if (chunk >= kMaxChunks) {
+            throw std::out_of_range("PriceBoard: symbol id beyond capacity");
+        }
+        Slot* slots = chunks[chunk].load(std::memory_order_acquire);
+        if (!slots) {
+            Slot* fresh = new Slot[kChunkSlots];
+            if (chunks[chunk].compare_exchange_strong(slots, fresh, std::memory_order_acq_rel)) {
+                slots = fresh;
+            } else {
+                delete[] fresh;  // Another writer installed the chunk first
+            }
+        }
+        std::uint32_t end = extent.load(std::memory_order_relaxed);
+        while (end <= id && !extent.compare_exchange_weak(end, id + 1, std::memory_order_release)) {}
+        return slots[id % kChunkSlots];
+    }
+    
+    // Claim `target` at sequence `expected` (even), store, release
+    static bool write(Slot& target, std::uint64_t expected, double price, std::int64_t timestampMs) {
+        if (!target.sequence.compare_exchange_strong(expected, expected + 1, std::memory_order_acquire)) {
+            return false;
+        }
+        // Keep the data stores below the odd sequence (seqlock writer)
+        std::atomic_thread_fence(std::memory_order_release);
+        target.price.store(price, std::memory_order_relaxed);
+        target.timestampMs.store(timestampMs, std::memory_order_relaxed);
+        target.sequence.store(expected + 2, std::memory_order_release);
+        return true;
+    }
+    
+    static void writeWaiting(Slot& target, double price, std::int64_t timestampMs) {
+        for (unsigned spins = 0; ; ++spins) {
+            std::uint64_t sequence = target.sequence.load(std::memory_order_relaxed);
+            if (!(sequence & 1) && write(target, sequence, price, timestampMs)) return;
+            if (spins > 64) std::this_thread::yield();
+        }
+    }
+
+public:
+    PriceBoard() : chunks(new std::atomic<Slot*>[kMaxChunks]) {
+        for (size_t c = 0; c < kMaxChunks; ++c) chunks[c].store(nullptr, std::memory_order_relaxed);
+    }
+    
+    PriceBoard(const PriceBoard&) = delete;
+    PriceBoard& operator=(const PriceBoard&) = delete;
+    
+    ~PriceBoard() {
+        for (size_t c = 0; c < kMaxChunks; ++c) delete[] chunks[c].load(std::memory_order_relaxed);
+    }
+    
+    // Latest quote for one symbol; price 0 if none was ever published
+    Quote read(SymbolId id) const {
+        const Slot* source = find(id);
+        if (!source) return Quote{};
+        for (unsigned spins = 0; ; ++spins) {
+            std::uint64_t before = source->sequence.load(std::memory_order_acquire);
+            if (!(before & 1)) {
+                Quote quote{source->price.load(std::memory_order_relaxed),
+                            source->timestampMs.load(std::memory_order_relaxed), before / 2};
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (source->sequence.load(std::memory_order_relaxed) == before) return quote;
+            }
+            if (spins > 64) std::this_thread::yield();
+        }
+    }
+    
+    double price(SymbolId id) const {
+        return read(id).price;
+    }
+    
+    void publish(SymbolId id, double price, std::int64_t timestampMs) {
+        Slot& target = slot(id);
+        writesBegun.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_release);
+        writeWaiting(target, price, timestampMs);
+        writesFinished.fetch_add(1, std::memory_order_release);
+    }
+    
+    // Publish only if the slot is still at `version` (from read()); false
+    // if another writer got there first, so the caller can redo its work
+    // from the newer quote
+    bool publishIf(SymbolId id, std::uint64_t version, double price, std::int64_t timestampMs) {
+        Slot& target = slot(id);
+        writesBegun.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_release);
+        bool written = write(target, version * 2, price, timestampMs);
+        writesFinished.fetch_add(1, std::memory_order_release);
+        return written;
+    }
+    
+    // Publish several prices as one write: a snapshot sees all or none
+    void publish(const SymbolMap<double>& prices, std::int64_t timestampMs) {
+        for (const auto& [id, price] : prices) slot(id);
+        writesBegun.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (const auto& [id, price] : prices) {
+            writeWaiting(slot(id), price, timestampMs);
+        }
+        writesFinished.fetch_add(1, std::memory_order_release);
+    }
+    
+    // Every published price as of one instant. If writes kept overlapping
+    // the copy, each price is still whole but the set may mix batches;
+    // `consistent` (when given) says which one the caller got
+    SymbolMap<double> snapshot(bool* consistent = nullptr) const {
+        SymbolMap<double> prices;
+        for (unsigned attempt = 0; attempt < kSnapshotAttempts; ++attempt) {
+            std::uint64_t finished = writesFinished.load(std::memory_order_acquire);
+            std::uint64_t begun = writesBegun.load(std::memory_order_acquire);
+            if (begun == finished) {
+                prices.clear();
+                std::uint32_t end = extent.load(std::memory_order_acquire);
+                for (SymbolId id = 0; id < end; ++id) {
+                    const Slot* source = find(id);
+                    double price = source ? source->price.load(std::memory_order_relaxed) : 0.0;
+                    if (price > 0.0) prices[id] = price;
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (writesBegun.load(std::memory_order_relaxed) == begun) {
+                    if (consistent) *consistent = true;
+                    return prices;
+                }
+            }
+            if (attempt > 8) std::this_thread::yield();
+        }
+        
+        prices.clear();
+        std::uint32_t end = extent.load(std::memory_order_acquire);
+        for (SymbolId id = 0; id < end; ++id) {
+            double price = read(id).price;
+            if (price > 0.0) prices[id] = price;
+        }
+        if (consistent) *consistent = false;
+        return prices;
+    }
+};
+
+// Market Data Fetcher class to get live market data
+class MarketDataFetcher {
+private:
+    static constexpr std::uint64_t kBlocksPerStep = 16;  // Random blocks reserved per simulated step
+    
+    std::string apiKey;
+    PriceBoard board;                       // Last price seen per symbol, readable from any thread
+    MarketDataEndpoints endpoints;
+    HttpClient http;                        // Pooled, keep-alive connections shared by all fetches
+    // One cache per mode, so simulated and live quotes never answer for
+    // each other. Declared last: they wait for their background refreshes.
+    QuoteCache simulatedQuotes;
+    QuoteCache liveQuotes;
+    
+    QuoteCache& quotesFor(bool useRealAPI) {
+        return useRealAPI ? liveQuotes : simulatedQuotes;
+    }
+    
+    // Starting price for simulating a symbol never seen before
+    static double basePrice(const std::string& symbol) {
+        static const std::unordered_map<std::string, double> basePrices = {
+            {"BTC", 40000.0},
+            {"ETH", 2000.0},
+            {"EUR/USD", 1.10},
+            {"USD/INR", 75.0},
+            {"GBP/USD", 1.35},
+            {"XAU/USD", 1800.0},
+            {"USD", 1.0},
+            {"VTI", 200.0},
+            {"VOO", 380.0}
+        };
+        auto it = basePrices.find(symbol);
+        return it != basePrices.end() ? it->second : 100.0;
+    }
+
+    // Log a failed response; true if the response is usable
+    bool reportFailure(const HttpResponse& response) const {
+        if (!response.error.empty()) {
+            std::cerr << "cURL error: " << response.error << std::endl;
+            return false;
+        }
+        if (response.status != 200) {
+            std::cerr << "HTTP error: " << response.status << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Fan one provider response out to the symbols it prices; symbols it
+    // does not price are left out of `quotes`. Only the requested fields
+    // are read, and the scan stops once all of them are found.
+    void extractQuotes(const QuoteRequest& request, const std::string& body, SymbolMap<double>& quotes) {
+        JsonFieldExtractor extractor;
+        for (size_t k = 0; k < request.symbols.size(); ++k) {
+            for (const JsonPath& path : request.paths[k]) {
+                extractor.addTarget(path, k);
+            }
+        }
+        if (!extractor.extract(body)) {
+            std::cerr << "JSON parsing error: " << extractor.getError() << std::endl;
+        }
+        for (size_t k = 0; k < request.symbols.size(); ++k) {
+            if (const double* price = extractor.found(k)) {
+                quotes[request.symbols[k]] = *price;
+            }
+        }
+    }
+    
+    // Live quotes: the planned requests are all in flight at once, and any
+    // symbol left without a usable quote falls back to simulation
+    SymbolMap<double> fetchQuotes(const std::vector<SymbolId>& symbols) {
+        std::vector<QuoteRequest> requests = FetchPlanner::plan(symbols, endpoints, apiKey);
+        std::vector<std::string> urls;
+        for (const QuoteRequest& request : requests) {
+            urls.push_back(request.url);
+        }
+        std::vector<HttpResponse> responses = http.getAll(urls);
+        
+        SymbolMap<double> quotes;
+        for (size_t r = 0; r < requests.size(); ++r) {
+            if (reportFailure(responses[r])) {
+                extractQuotes(requests[r], responses[r].body, quotes);
+            }
+        }
+        for (SymbolId id : symbols) {
+            if (!quotes.contains(id)) {
+                quotes[id] = simulatePrice(id);
+            }
+        }
+        return quotes;
+    }
+    
+    // Simulate price for demonstration or when API fails: one random step
+    // from the symbol's last price (or its base price). Step n draws from
+    // the symbol's stream at a fixed offset for n, so no stream state is
+    // kept and paths are reproducible under a fixed seed; a caller that
+    // loses the slot to a concurrent writer redoes the step from the
+    // newer price.
+    double simulatePrice(SymbolId id) {
+        while (true) {
+            PriceBoard::Quote last = board.read(id);
+            double from = last.valid() ? last.price : basePrice(SymbolTable::global().name(id));
+            RandomStream rng = RandomService::global().stream(RandomService::Domain::MarketSymbol, id);
+            rng.getEngine().discardBlocks(last.version * kBlocksPerStep);
+            double newPrice = Utils::simulateVolatility(from, rng);
+            if (board.publishIf(id, last.version, newPrice, Clock::nowMillis())) {
+                return newPrice;
+            }
+        }
+    }
+    
+    double simulatePrice(const std::string& symbol) {
+        return simulatePrice(SymbolTable::global().intern(symbol));
+    }
+
+public:
+    MarketDataFetcher(const std::string& apiKey = "")
+        : apiKey(apiKey), endpoints(MarketDataEndpoints::defaults()) {}
+    
+    // Point the live fetch path at other provider URLs
+    void setEndpoints(const MarketDataEndpoints& newEndpoints) {
+        endpoints = newEndpoints;
+    }
+    
+    const MarketDataEndpoints& getEndpoints() const {
+        return endpoints;
+    }
+    
+    // Get price for a specific asset; repeated reads within the asset
+    // class's TTL are served from the quote cache for the same mode
+    double getPrice(const std::string& symbol, bool useRealAPI = false) {
+        SymbolId id = SymbolTable::global().intern(symbol);
+        return quotesFor(useRealAPI).get(id, QuoteCache::classify(symbol),
+                          [this, symbol, useRealAPI]() { return fetchPrice(symbol, useRealAPI); });
+    }
+    
+    // Fetch (or simulate) one price, bypassing the cache
+    double fetchPrice(const std::string& symbol, bool useRealAPI = false) {
+        if (useRealAPI) {
+            SymbolId id = SymbolTable::global().intern(symbol);
+            double price = *fetchQuotes({id}).find(id);
+            board.publish(id, price, Clock::nowMillis());
+            return price;
+        } else {
+            // Use simulated prices for demonstration
+            return simulatePrice(symbol);
+        }
+    }
+    
+    // Get price for an interned symbol
+    double getPrice(SymbolId id, bool useRealAPI = false) {
+        return getPrice(SymbolTable::global().name(id), useRealAPI);
+    }
+    
+    // Update multiple prices at once; live quotes come from batched
+    // provider requests that are fetched concurrently
+    SymbolMap<double> updatePrices(const std::vector<SymbolId>& symbols, bool useRealAPI = false) {
+        SymbolMap<double> updatedPrices;
+        
+        if (useRealAPI) {
+            SymbolMap<double> fetched = fetchQuotes(symbols);
+            for (SymbolId id : symbols) {
+                double price = *fetched.find(id);
+                updatedPrices[id] = price;
+                liveQuotes.put(id, price);
+            }
+            board.publish(updatedPrices, Clock::nowMillis());
+            return updatedPrices;
+        }
+        
+        // An explicit refresh always moves past the cache, then seeds it;
+        // each simulated step is published to the board as it is taken
+        for (SymbolId id : symbols) {
+            double price = simulatePrice(id);
+            updatedPrices[id] = price;
+            simulatedQuotes.put(id, price);
+        }
+        
+        return updatedPrices;
+    }
+    
+    // Get volatility index (VIX) - simulated
+    double getVIX() {
+        static const SymbolId vix = SymbolTable::global().intern("VIX");
+        return simulatedQuotes.get(vix, QuoteClass::Indicator, [this]() { return simulatePrice("VIX"); });
+    }
+    
+    QuoteCache& getQuoteCache(bool useRealAPI = false) {
+        return quotesFor(useRealAPI);
+    }
+    
+    // Last price seen per symbol, safe to read from any thread
+    PriceBoard& getPriceBoard() {
+        return board;
+    }
+    
+    const PriceBoard& getPriceBoard() const {
+        return board;
+    }
+    
+    // Get economic indicators - simulated
+    double getInflationRate(const std::string& country = "US") {
+        // Simulated inflation rates
+        std::map<std::string, double> inflationRates = {
+            {"US", 2.5},
+            {"EU", 2.0},
+            {"UK", 3.0},
+            {"IN", 5.5},
+            {"JP", 0.5}
+        };
+        
+        return inflationRates.find(country) != inflationRates.end() ? 
+               inflationRates[country] : 2.0;
+    }
+    
+    // Get interest rate - simulated
+    double getInterestRate(const std::string& country = "US") {
+        // Simulated interest rates
+        std::map<std::string, double> interestRates = {
+            {"US", 0.5},
+            {"EU", 0.0},
+            {"UK", 0.75},
+            {"IN", 4.5},
+            {"JP", -0.1}
+        };
+        
+        return interestRates.find(country) != interestRates.end() ? 
+               interestRates[country] : 0.5;
+    }
+};
+
+// One price observation; timestamps are epoch milliseconds
+struct MarketTick {
+    std::int64_t timestampMs;
+    SymbolId symbol;
+    double price;
+};
+
+// One step of market data: the prices that changed at `timestampMs`
+// (epoch milliseconds)
+struct MarketBatch {
+    std::int64_t timestampMs = 0;
+    SymbolMap<double> prices;
+};
+
+// Where PortfolioManager::updatePrices gets its prices. Each call to
+// next() yields one batch. On-demand sources (simulator, HTTP) price
+// exactly `symbols`; recorded and streamed sources deliver whatever the
+// next step holds, and the caller ignores symbols it does not track.
+// next() returns false once the source is exhausted.
+class MarketDataSource {
+public:
+    virtual ~MarketDataSource() = default;
+    virtual bool next(const std::vector<SymbolId>& symbols, MarketBatch& batch) = 0;
+    virtual std::string describe() const = 0;
+};
+
+// Simulated random-walk prices from the fetcher
+class SimulatedMarketDataSource : public MarketDataSource {
+private:
+    MarketDataFetcher& fetcher;
+
+public:
+    explicit SimulatedMarketDataSource(MarketDataFetcher& fetcher) : fetcher(fetcher) {}
+    
+    bool next(const std::vector<SymbolId>& symbols, MarketBatch& batch) override {
+        batch.timestampMs = Clock::nowMillis();
+        batch.prices = fetcher.updatePrices(symbols, false);
+        return true;
+    }
+    
+    std::string describe() const override { return "simulated prices"; }
+};
+
+// Live quotes from the HTTP vendors, batched and fetched concurrently
+class HttpMarketDataSource : public MarketDataSource {
+private:
+    MarketDataFetcher& fetcher;
+
+public:
+    explicit HttpMarketDataSource(MarketDataFetcher& fetcher) : fetcher(fetcher) {}
+    
+    bool next(const std::vector<SymbolId>& symbols, MarketBatch& batch) override {
+        batch.timestampMs = Clock::nowMillis();
+        batch.prices = fetcher.updatePrices(symbols, true);
+        return true;
+    }
+    
+    std::string describe() const override { return "live quotes from " + fetcher.getEndpoints().crypto; }
+};
+
+// Text form of ticks shared by recorded files and local feeds: one tick
+// per line as "timestampMs,SYMBOL,price"; lines starting with '#' are
+// comments. Feeds are normalised on the way in: symbols are trimmed and
+// upper-cased, and timestamps small enough to be epoch seconds are scaled
+// to milliseconds. Symbols are resolved through a local cache keyed by
+// the raw text, so parsing a known symbol neither locks the symbol table
+// nor allocates.
+class TickCodec {
+private:
+    static constexpr std::int64_t kSecondsCutoff = 100000000000LL;  // Year 5138 in seconds, 1973 in ms
+    
+    std::deque<std::string> names;  // Owns the cache keys
+    std::unordered_map<std::string_view, SymbolId> ids;
+    
+    SymbolId resolve(std::string_view symbol) {
+        auto it = ids.find(symbol);
+        if (it != ids.end()) return it->second;
+        
+        std::string normalized;
+        for (char c : symbol) {
+            if (c != ' ' && c != '\t') normalized += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        SymbolId id = SymbolTable::global().intern(normalized);
+        names.emplace_back(symbol);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+public:
+    // Parse one line (no newline); false for blank, comment or malformed lines
+    bool parse(const char* begin, const char* end, MarketTick& tick) {
+        return parse(begin, end, tick.timestampMs, tick.symbol, tick.price);
+    }
+    
+    bool parse(const char* begin, const char* end, std::int64_t& timestampMs, SymbolId& symbol, double& price) {
+        if (begin < end && end[-1] == '\r') --end;
+        if (begin == end || *begin == '#') return false;
+        
+        const char* p = begin;
+        std::int64_t timestamp = 0;
+        if (p == end || *p < '0' || *p > '9') return false;
+        while (p < end && *p >= '0' && *p <= '9') timestamp = timestamp * 10 + (*p++ - '0');
+        if (p == end || *p++ != ',') return false;
+        
+        const char* symbolBegin = p;
+        while (p < end && *p != ',') ++p;
+        if (p == end || p == symbolBegin) return false;
+        std::string_view name(symbolBegin, static_cast<size_t>(p - symbolBegin));
+        ++p;
+        
+        // strtod needs a terminator the mapped text may not have
+        char number[64];
+        size_t length = static_cast<size_t>(end - p);
+        if (length == 0 || length >= sizeof(number)) return false;
+        std::memcpy(number, p, length);
+        number[length] = '\0';
+        char* numberEnd = nullptr;
+        price = std::strtod(number, &numberEnd);
+        if (numberEnd != number + length || !(price > 0.0)) return false;
+        
+        timestampMs = timestamp < kSecondsCutoff ? timestamp * 1000 : timestamp;
+        symbol = resolve(name);
+        return true;
+    }
+    
+    // Append one tick line to `out`; prices round-trip exactly
+    static void format(std::string& out, std::int64_t timestampMs, SymbolId symbol, double price) {
+        char number[32];
+        int length = std::snprintf(number, sizeof(number), "%.17g", price);
+        out += std::to_string(timestampMs);
+        out += ',';
+        out += SymbolTable::global().name(symbol);
+        out += ',';
+        out.append(number, static_cast<size_t>(length));
+        out += '\n';
+    }
+};
+
+// Replays a recorded tick file: consecutive lines with the same timestamp
+// form one batch. The file is memory-mapped and parsed in place. Pacing
+// follows the recorded timestamps scaled by `speed` (1 = real time,
+// 60 = a minute per second, 0 = as fast as the consumer can take it), so
+// a recorded day can drive the full update pipeline offline and
+// reproducibly. Lines go through TickCodec, so a timestamp below 1e11 is
+// read as epoch seconds and scaled to milliseconds; millisecond stamps
+// before March 1973 cannot be replayed as such.
+class ReplayMarketDataSource : public MarketDataSource {
+private:
+    std::string path;
+    int fd;
+    const char* data;
+    size_t length;
+    const char* cursor;
+    double speed;
+    TickCodec codec;
+    std::optional<MarketTick> pending;  // First tick of the next batch
+    std::optional<std::int64_t> firstTimestamp;
+    std::chrono::steady_clock::time_point startedAt;
+    size_t tickCount = 0;
+    size_t skippedLines = 0;
+    
+    ReplayMarketDataSource(const std::string& path, int fd, const char* data, size_t length, double speed)
+        : path(path), fd(fd), data(data), length(length), cursor(data), speed(speed) {}
+    
+    bool readTick(MarketTick& tick) {
+        const char* end = data + length;
+        while (cursor < end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+            if (!lineEnd) lineEnd = end;
+            const char* line = cursor;
+            cursor = lineEnd < end ? lineEnd + 1 : end;
+            if (codec.parse(line, lineEnd, tick)) return true;
+            if (lineEnd > line && *line != '#' && !(lineEnd - line == 1 && *line == '\r')) ++skippedLines;
+        }
+        return false;
+    }
+    
+    // Hold the batch back until its recorded time at the chosen speed
+    void pace(std::int64_t timestampMs) {
+        if (!firstTimestamp) {
+            firstTimestamp = timestampMs;
+            startedAt = std::chrono::steady_clock::now();
+            return;
+        }
+        if (speed <= 0.0) return;
+        auto offset = std::chrono::duration<double, std::milli>((timestampMs - *firstTimestamp) / speed);
+        std::this_thread::sleep_until(startedAt + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+    }
+
+public:
+    ReplayMarketDataSource(const ReplayMarketDataSource&) = delete;
+    ReplayMarketDataSource& operator=(const ReplayMarketDataSource&) = delete;
+    
+    ~ReplayMarketDataSource() override {
+#ifndef _WIN32
+        if (data && length) munmap(const_cast<char*>(data), length);
+        if (fd >= 0) close(fd);
+#endif
+    }
+    
+    // Map the recording at `path`; returns nullptr on failure
+    static std::unique_ptr<ReplayMarketDataSource> open(const std::string& path, double speed = 0.0) {
+#ifdef _WIN32
+        std::cerr << "Market data replay not supported on this platform: " << path << std::endl;
+        return nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open market data recording: " << path << std::endl;
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return nullptr;
+        }
+        
+        size_t length = static_cast<size_t>(st.st_size);
+        const char* data = nullptr;
+        if (length > 0) {
+            void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                std::cerr << "Failed to map market data recording: " << path << std::endl;
+                close(fd);
+                return nullptr;
+            }
+            madvise(addr, length, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(addr);
+        }
+        return std::unique_ptr<ReplayMarketDataSource>(new ReplayMarketDataSource(path, fd, data, length, speed));
+#endif
+    }
+    
+    bool next(const std::vector<SymbolId>&, MarketBatch& batch) override {
+        batch.prices.clear();
+        if (!pending) {
+            MarketTick tick;
+            if (!readTick(tick)) return false;
+            pending = tick;
+        }
+        
+        // Later ticks for a symbol within the same timestamp win
+        batch.timestampMs = pending->timestampMs;
+        MarketTick tick = *pending;
+        pending.reset();
+        do {
+            batch.prices[tick.symbol] = tick.price;
+            ++tickCount;
+            if (!readTick(tick)) break;
+            if (tick.timestampMs != batch.timestampMs) {
+                pending = tick;
+                break;
+            }
+        } while (true);
+        
+        pace(batch.timestampMs);
+        return true;
+    }
+    
+    // Start again from the first tick
+    void rewind() {
+        cursor = data;
+        pending.reset();
+        firstTimestamp.reset();
+    }
+    
+    std::string describe() const override { return "replay of " + path; }
+    size_t getTickCount() const { return tickCount; }
+    size_t getSkippedLines() const { return skippedLines; }
+};
+
+// Ticks streamed by a local process over a named pipe or Unix-domain
+// socket, in the recorded-file format. next() blocks for the first tick,
+// then drains whatever else is already queued into the same batch, so a
+// consumer that falls behind sees the latest price per symbol rather than
+// a growing backlog. Returns false once the writer closes its end.
+class FeedMarketDataSource : public MarketDataSource {
+private:
+    static constexpr size_t kReadSize = 64 * 1024;
+    static constexpr int kMaxDrainReads = 16;  // Bound one batch under a flooding writer
+    
+    std::string path;
+    int fd;
+    std::string buffer;  // Unparsed bytes, at most one partial line between reads
+    TickCodec codec;
+    size_t tickCount = 0;
+    size_t skippedLines = 0;
+    
+    FeedMarketDataSource(const std::string& path, int fd) : path(path), fd(fd) {}
+    
+    // Read what is available; false on end of stream or error
+    bool fill(bool wait) {
+#ifdef _WIN32
+        (void)wait;
+        return false;
+#else
+        pollfd poller{fd, POLLIN, 0};
+        int ready;
+        do {
+            ready = poll(&poller, 1, wait ? -1 : 0);
+        } while (ready < 0 && errno == EINTR);
+        if (ready <= 0) return false;
+        
+        size_t used = buffer.size();
+        buffer.resize(used + kReadSize);
+        ssize_t bytes;
+        do {
+            bytes = read(fd, &buffer[used], kReadSize);
+        } while (bytes < 0 && errno == EINTR);
+        buffer.resize(used + static_cast<size_t>(std::max<ssize_t>(bytes, 0)));
+        return bytes > 0;
+#endif
+    }
+    
+    // Move every complete line into the batch
+    void parseLines(MarketBatch& batch) {
+        size_t start = 0;
+        size_t newline;
+        while ((newline = buffer.find('\n', start)) != std::string::npos) {
+            std::int64_t timestampMs;
+            SymbolId symbol;
+            double price;
+            const char* line = buffer.data() + start;
+            if (codec.parse(line, buffer.data() + newline, timestampMs, symbol, price)) {
+                batch.prices[symbol] = price;
+                batch.timestampMs = std::max(batch.timestampMs, timestampMs);
+                ++tickCount;
+            } else if (newline > start && *line != '#') {
+                ++skippedLines;
+            }
+            start = newline + 1;
+        }
+        buffer.erase(0, start);
+    }
+
+public:
+    FeedMarketDataSource(const FeedMarketDataSource&) = delete;
+    FeedMarketDataSource& operator=(const FeedMarketDataSource&) = delete;
+    
+    ~FeedMarketDataSource() override {
+#ifndef _WIN32
+        if (fd >= 0) close(fd);
+#endif
+    }
+    
+    // Connect to a Unix-domain socket, or open a named pipe or file, at
+    // `path` for reading; returns -1 on failure
+    static int connect(const std::string& path) {
+#ifdef _WIN32
+        std::cerr << "Local market data feeds not supported on this platform: " << path << std::endl;
+        return -1;
+#else
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            std::cerr << "Market data feed not found: " << path << std::endl;
+            return -1;
+        }
+        
+        int fd = -1;
+        if (S_ISSOCK(st.st_mode)) {
+            sockaddr_un address{};
+            if (path.size() >= sizeof(address.sun_path)) {
+                std::cerr << "Socket path too long: " << path << std::endl;
+                return -1;
+            }
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        } else {
+            fd = ::open(path.c_str(), O_RDONLY);
+        }
+        if (fd < 0) {
+            std::cerr << "Failed to connect to market data feed: " << path << std::endl;
+        }
+        return fd;
+#endif
+    }
+    
+    // Feed from the socket or pipe at `path`; returns nullptr on failure
+    static std::unique_ptr<FeedMarketDataSource> open(const std::string& path) {
+        int fd = connect(path);
+        if (fd < 0) return nullptr;
+        return std::unique_ptr<FeedMarketDataSource>(new FeedMarketDataSource(path, fd));
+    }
+    
+    bool next(const std::vector<SymbolId>&, MarketBatch& batch) override {
+        batch.prices.clear();
+        batch.timestampMs = 0;
+        while (batch.prices.empty()) {
+            if (!fill(true)) return false;
+            parseLines(batch);
+        }
+        for (int reads = 0; reads < kMaxDrainReads && fill(false); ++reads) {
+            parseLines(batch);
+        }
+        return true;
+    }
+    
+    std::string describe() const override { return "local feed " + path; }
+    size_t getTickCount() const { return tickCount; }
+    size_t getSkippedLines() const { return skippedLines; }
+};
+
+// Passes another source's batches through while appending them to a tick
+// file that ReplayMarketDataSource can play back later
+class RecordingMarketDataSource : public MarketDataSource {
+private:
+    std::unique_ptr<MarketDataSource> inner;
+    std::string path;
+    std::ofstream out;
+    std::string lines;
+    
+    RecordingMarketDataSource(std::unique_ptr<MarketDataSource> inner, const std::string& path)
+        : inner(std::move(inner)), path(path), out(path, std::ios::app | std::ios::binary) {}
+
+public:
+    // Record `inner` to `path` (appended); returns nullptr on failure
+    static std::unique_ptr<RecordingMarketDataSource> open(std::unique_ptr<MarketDataSource> inner,
+                                                           const std::string& path) {
+        std::unique_ptr<RecordingMarketDataSource> source(new RecordingMarketDataSource(std::move(inner), path));
+        if (!source->out) {
+            std::cerr << "Failed to open market data recording for writing: " << path << std::endl;
+            return nullptr;
+        }
+        return source;
+    }
+    
+    bool next(const std::vector<SymbolId>& symbols, MarketBatch& batch) override {
+        if (!inner->next(symbols, batch)) return false;
+        lines.clear();
+        for (const auto& [id, price] : batch.prices) {
+            TickCodec::format(lines, batch.timestampMs, id, price);
+        }
+        out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+        out.flush();
+        return true;
+    }
+    
+    std::string describe() const override { return inner->describe() + ", recorded to " + path; }
+};
+
+// Market data source selection, as given on the command line
+struct MarketDataSpec {
+    enum class Kind { Simulated, Http, Replay, Feed };
+    
+    Kind kind = Kind::Simulated;
+    std::string path;        // Recording (Replay) or pipe/socket (Feed)
+    double speed = 0.0;      // Replay pace: 0 = flat out, 1 = real time, N = N times faster
+    std::string recordPath;  // Also record every batch here when set
+    
+    // Build the source; nullptr if a file or feed cannot be opened
+    std::unique_ptr<MarketDataSource> create(MarketDataFetcher& fetcher) const {
+        std::unique_ptr<MarketDataSource> source;
+        switch (kind) {
+            case Kind::Simulated: source = std::make_unique<SimulatedMarketDataSource>(fetcher); break;
+            case Kind::Http: source = std::make_unique<HttpMarketDataSource>(fetcher); break;
+            case Kind::Replay: source = ReplayMarketDataSource::open(path, speed); break;
+            case Kind::Feed: source = FeedMarketDataSource::open(path); break;
+        }
+        if (source && !recordPath.empty()) {
+            source = RecordingMarketDataSource::open(std::move(source), recordPath);
+        }
+        return source;
+    }
+};
+
+// Bounded lock-free single-producer/single-consumer queue. Capacity is
+// rounded up to a power of two. The two indices live on separate cache
+// lines and each side keeps a private copy of the other's index, so the
+// shared lines are only touched when the ring looks full (producer) or
+// empty (consumer) from that copy.
+template <typename T>
+class SpscRing {
+private:
+    static constexpr size_t kCacheLine = 64;
+    
+    std::vector<T> slots;
+    size_t mask;
+    alignas(kCacheLine) std::atomic<size_t> head{0};  // Next slot to pop; written by the consumer
+    size_t cachedTail = 0;                           // Consumer's copy of `tail`
+    alignas(kCacheLine) std::atomic<size_t> tail{0};  // Next slot to fill; written by the producer
+    size_t cachedHead = 0;                           // Producer's copy of `head`
+
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+    
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    
+    // Producer side; false when the ring is full
+    bool tryPush(const T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead > mask) return false;
+        }
+        slots[position & mask] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side: hand up to `maxItems` queued items to `fn` in order,
+    // releasing their slots in one store; returns how many were taken
+    template <typename Fn>
+    size_t popBatch(Fn&& fn, size_t maxItems) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (cachedTail == position) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (cachedTail == position) return 0;
+        }
+        size_t count = std::min(cachedTail - position, maxItems);
+        for (size_t k = 0; k < count; ++k) {
+            fn(slots[(position + k) & mask]);
+        }
+        head.store(position + count, std::memory_order_release);
+        return count;
+    }
+    
+    size_t capacity() const { return mask + 1; }
+    
+    // Items queued; exact only when called by one of the two sides
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+// What the feed reader does with a tick when the ring is full
+enum class OverflowPolicy {
+    Block,       // Stop reading until the consumer catches up; the writer feels it as a full pipe or socket
+    DropNewest,  // Discard the tick and count it
+    Merge        // Hold the latest tick per symbol aside and publish it once there is room
+};
+
+// Push-based tick ingestion: a reader thread pulls ticks from a local
+// socket, pipe or file, normalises them through TickCodec and publishes
+// them on an SPSC ring; the portfolio's owner drains the ring (see
+// PortfolioManager::applyTicks). Only the reader thread pushes and only
+// one thread may drain.
+class TickIngestor {
+public:
+    struct Stats {
+        std::uint64_t received = 0;   // Well-formed ticks read from the feed
+        std::uint64_t published = 0;  // Ticks pushed onto the ring
+        std::uint64_t dropped = 0;    // DropNewest: ticks discarded on a full ring
+        std::uint64_t merged = 0;     // Merge: ticks superseded before they were published
+        std::uint64_t malformed = 0;  // Lines that did not parse
+    };
+
+private:
+    static constexpr size_t kReadSize = 64 * 1024;
+    static constexpr int kStopPollMs = 100;  // How often an idle reader checks for stop()
+    static constexpr int kHeldBackPollMs = 1; // ...and retries held-back ticks while any remain
+    
+    SpscRing<MarketTick> ring;
+    OverflowPolicy policy;
+    std::thread reader;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> readerDone{false};
+    int fd = -1;
+    
+    // Reader-thread state
+    TickCodec codec;
+    SymbolMap<MarketTick> overflow;  // Merge: latest unpublished tick per symbol
+    std::vector<SymbolId> unflushed;
+    
+    std::atomic<std::uint64_t> received{0};
+    std::atomic<std::uint64_t> published{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<std::uint64_t> merged{0};
+    std::atomic<std::uint64_t> malformed{0};
+    
+    // Counters are written only by the reader thread, so no atomic RMW
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t by = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+    
+    // Block: spin briefly, then yield, until there is room or we are stopped
+    bool pushWaiting(const MarketTick& tick) {
+        for (unsigned spins = 0; !ring.tryPush(tick); ++spins) {
+            if (stopping.load(std::memory_order_relaxed)) return false;
+            if (spins > 64) std::this_thread::yield();
+        }
+        return true;
+    }
+    
+    // Merge: publish held-back ticks in arrival order while there is room
+    bool flushOverflow() {
+        size_t sent = 0;
+        while (sent < unflushed.size() && ring.tryPush(*overflow.find(unflushed[sent]))) {
+            ++sent;
+        }
+        if (sent == unflushed.size()) {
+            overflow.clear();
+            unflushed.clear();
+            bump(published, sent);
+            return true;
+        }
+        for (size_t k = 0; k < sent; ++k) overflow.erase(unflushed[k]);
+        unflushed.erase(unflushed.begin(), unflushed.begin() + static_cast<long>(sent));
+        bump(published, sent);
+        return false;
+    }
+    
+    void publish(const MarketTick& tick) {
+        bump(received);
+        switch (policy) {
+            case OverflowPolicy::Block:
+                if (pushWaiting(tick)) bump(published);
+                return;
+            case OverflowPolicy::DropNewest:
+                if (ring.tryPush(tick)) bump(published);
+                else bump(dropped);
+                return;
+            case OverflowPolicy::Merge:
+                // Once anything is held back, newer ticks queue behind it so
+                // each symbol's ticks stay in order
+                if (unflushed.empty() || flushOverflow()) {
+                    if (ring.tryPush(tick)) {
+                        bump(published);
+                        return;
+                    }
+                }
+                if (MarketTick* held = overflow.find(tick.symbol)) {
+                    *held = tick;
+                    bump(merged);
+                } else {
+                    overflow[tick.symbol] = tick;
+                    unflushed.push_back(tick.symbol);
+                }
+                return;
+        }
+    }
+    
+    void readLoop() {
+#ifndef _WIN32
+        std::string buffer;
+        std::vector<char> chunk(kReadSize);
+        while (!stopping.load(std::memory_order_relaxed)) {
+            // Held-back ticks go out as soon as there is room, even while
+            // the feed is quiet
+            if (!unflushed.empty()) flushOverflow();
+            pollfd poller{fd, POLLIN, 0};
+            int ready = poll(&poller, 1, unflushed.empty() ? kStopPollMs : kHeldBackPollMs);
+            if (ready < 0 && errno != EINTR) break;
+            if (ready <= 0) continue;
+            ssize_t bytes = read(fd, chunk.data(), chunk.size());
+            if (bytes < 0 && errno == EINTR) continue;
+            if (bytes <= 0) break;
+            
+            // Parse straight from the chunk; only a trailing partial line is copied
+            const char* cursor = chunk.data();
+            const char* end = cursor + bytes;
+            if (!buffer.empty()) {
+                const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+                if (!newline) {
+                    buffer.append(cursor, end);
+                    continue;
+                }
+                buffer.append(cursor, newline);
+                parseLine(buffer.data(), buffer.data() + buffer.size());
+                buffer.clear();
+                cursor = newline + 1;
+            }
+            while (cursor < end) {
+                const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+                if (!newline) {
+                    buffer.assign(cursor, end);
+                    break;
+                }
+                parseLine(cursor, newline);
+                cursor = newline + 1;
+            }
+        }
+        if (!buffer.empty()) parseLine(buffer.data(), buffer.data() + buffer.size());
+        
+        // Held-back ticks are still owed to the consumer at end of stream
+        while (!unflushed.empty() && !stopping.load(std::memory_order_relaxed) && !flushOverflow()) {
+            std::this_thread::yield();
+        }
+#endif
+        readerDone.store(true, std::memory_order_release);
+    }
+    
+    void parseLine(const char* begin, const char* end) {
+        MarketTick tick;
+        if (codec.parse(begin, end, tick)) {
+            publish(tick);
+        } else if (begin < end && *begin != '#' && !(end - begin == 1 && *begin == '\r')) {
+            bump(malformed);
+        }
+    }
+    
+    TickIngestor(int fd, size_t capacity, OverflowPolicy policy) : ring(capacity), policy(policy), fd(fd) {
+        reader = std::thread([this]() { readLoop(); });
+    }
+
+public:
+    TickIngestor(const TickIngestor&) = delete;
+    TickIngestor& operator=(const TickIngestor&) = delete;
+    
+    ~TickIngestor() {
+        stop();
+    }
+    
+    // Start reading from the socket, pipe or file at `path`; nullptr if it
+    // cannot be opened
+    static std::unique_ptr<TickIngestor> open(const std::string& path, OverflowPolicy policy = OverflowPolicy::Merge,
+                                              size_t capacity = 1 << 16) {
+        int fd = FeedMarketDataSource::connect(path);
+        return fd < 0 ? nullptr : fromDescriptor(fd, policy, capacity);
+    }
+    
+    // Start reading from an open descriptor; the ingestor takes ownership
+    static std::unique_ptr<TickIngestor> fromDescriptor(int fd, OverflowPolicy policy = OverflowPolicy::Merge,
+                                                        size_t capacity = 1 << 16) {
+        return std::unique_ptr<TickIngestor>(new TickIngestor(fd, capacity, policy));
+    }
+    
+    // Stop the reader; ticks already on the ring can still be drained
+    void stop() {
+        stopping.store(true, std::memory_order_relaxed);
+        if (reader.joinable()) reader.join();
+#ifndef _WIN32
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+#endif
+    }
+    
+    // Consumer side: apply up to `maxTicks` queued ticks, oldest first
+    template <typename Fn>
+    size_t drain(Fn&& apply, size_t maxTicks = std::numeric_limits<size_t>::max()) {
+        size_t total = 0;
+        while (total < maxTicks) {
+            size_t taken = ring.popBatch(apply, std::min<size_t>(maxTicks - total, ring.capacity()));
+            if (taken == 0) break;
+            total += taken;
+        }
+        return total;
+    }
+    
+    // True once the feed has ended and every published tick was drained
+    bool finished() const {
+        return readerDone.load(std::memory_order_acquire) && ring.size() == 0;
+    }
+    
+    Stats getStats() const {
+        Stats stats;
+        stats.received = received.load(std::memory_order_relaxed);
+        stats.published = published.load(std::memory_order_relaxed);
+        stats.dropped = dropped.load(std::memory_order_relaxed);
+        stats.merged = merged.load(std::memory_order_relaxed);
+        stats.malformed = malformed.load(std::memory_order_relaxed);
+        return stats;
+    }
+    
+    OverflowPolicy getPolicy() const { return policy; }
+};
+
+// Synthetic local feed for exercising ingestion and replay: independent
+// random walks per symbol, written in the tick text format to a pipe,
+// socket or file, either flat out or at a fixed rate
+class TickGenerator {
+private:
+    std::vector<SymbolId> symbols;
+    std::vector<double> prices;
+    RandomStream rng;
+    std::int64_t timestampMs;
+    
+public:
+    explicit TickGenerator(const std::vector<std::string>& names = {"SIP", "USD", "XAU/USD", "EUR/USD", "BTC"},
+                           std::uint64_t streamId = 0)
+        : rng(RandomService::global().stream(RandomService::Domain::Simulation, 100 + streamId)),
+          timestampMs(Clock::nowMillis()) {
+        for (const std::string& name : names) {
+            static const std::map<std::string, double> basePrices = {
+                {"SIP", 200.0}, {"USD", 1.0}, {"XAU/USD", 1800.0}, {"EUR/USD", 1.10}, {"BTC", 40000.0}};
+            auto it = basePrices.find(name);
+            symbols.push_back(SymbolTable::global().intern(name));
+            prices.push_back(it != basePrices.end() ? it->second : 100.0);
+        }
+    }
+    
+    // Append the next `count` ticks, cycling through the symbols one
+    // millisecond apart
+    void generate(std::string& out, size_t count) {
+        for (size_t k = 0; k < count; ++k) {
+            size_t index = k % symbols.size();
+            prices[index] *= std::exp(0.0005 * rng.normal());
+            TickCodec::format(out, timestampMs++, symbols[index], prices[index]);
+        }
+    }
+    
+    // Write `ticks` ticks to `fd`, at `ticksPerSecond` (0 = as fast as the
+    // reader takes them); false if the reader went away
+    bool run(int fd, size_t ticks, double ticksPerSecond = 0.0) {
+        const size_t chunkTicks = ticksPerSecond > 0.0 ? std::max<size_t>(1, static_cast<size_t>(ticksPerSecond / 100)) : 4096;
+        auto start = std::chrono::steady_clock::now();
+        std::string chunk;
+        for (size_t sent = 0; sent < ticks; ) {
+            size_t count = std::min(chunkTicks, ticks - sent);
+            chunk.clear();
+            generate(chunk, count);
+            if (!Utils::writeAll(fd, chunk.data(), chunk.size())) return false;
+            sent += count;
+            if (ticksPerSecond > 0.0) {
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(sent / ticksPerSecond)));
+            }
+        }
+        return true;
+    }
+    
+    // Write to the named pipe or file at `path` (a file is created if
+    // nothing exists there, and is then a replayable recording)
+    bool run(const std::string& path, size_t ticks, double ticksPerSecond = 0.0) {
+#ifdef _WIN32
+        std::cerr << "Local feed generator not supported on this platform: " << path << std::endl;
+        return false;
+#else
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            std::cerr << "Failed to open feed output: " << path << std::endl;
+            return false;
+        }
+        bool ok = run(fd, ticks, ticksPerSecond);
+        close(fd);
+        return ok;
+#endif
+    }
+};
+
+// SIP Manager to handle systematic investment plans
+class SIPManager {
+private:
+    double monthlyAmount;
+    SymbolMap<double> allocation; // Asset symbol to percentage allocation
+    std::chrono::system_clock::time_point lastInvestmentDate;
+    bool autoInvest;
+
+public:
+    SIPManager(double monthlyAmount = 0.0, bool autoInvest = true)
+        : monthlyAmount(monthlyAmount), autoInvest(autoInvest) {
+        // Initialize last investment date to current time
+        lastInvestmentDate = std::chrono::system_clock::now();
+    }
+    
+    // Set monthly investment amount
+    void setMonthlyAmount(double amount) {
+        monthlyAmount = amount;
+    }
+    
+    // Set allocation percentages
+    void setAllocation(const SymbolMap<double>& newAllocation) {
+        // Validate that percentages add up to 100%
+        double total = 0.0;
+        for (const auto& [id, percentage] : newAllocation) {
+            total += percentage;
+        }
+        
+        if (std::abs(total - 100.0) > 0.01) {
+            std::cerr << "Warning: Allocation percentages do not add up to 100%. Adjusting..." << std::endl;
+            
+            // Adjust proportionally
+            allocation.clear();
+            for (const auto& [id, percentage] : newAllocation) {
+                allocation[id] = (percentage / total) * 100.0;
+            }
+        } else {
+            allocation = newAllocation;
+        }
+    }
+    
+    // Set allocation percentages keyed by symbol name
+    void setAllocation(const std::map<std::string, double>& newAllocation) {
+        SymbolMap<double> interned;
+        for (const auto& [symbol, percentage] : newAllocation) {
+            interned[SymbolTable::global().intern(symbol)] = percentage;
+        }
+        setAllocation(interned);
+    }
+    
+    // Check if it's time for the next investment
+    bool isTimeForInvestment() const {
+        auto now = std::chrono::system_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::hours>(now - lastInvestmentDate);
+        
+        // Simplified: Consider a month as 30 days
+        return duration.count() >= 30 * 24;
+    }
+    
+    // Execute the monthly investment
+    SymbolMap<double> executeInvestment(bool force = false) {
+        if (!force && !isTimeForInvestment()) {
+            return {};
+        }
+        
+        SymbolMap<double> investments;
+        
+        for (const auto& [id, percentage] : allocation) {
+            double amount = monthlyAmount * (percentage / 100.0);
+            investments[id] = amount;
+        }
+        
+        // Update last investment date
+        lastInvestmentDate = std::chrono::system_clock::now();
+        
+        return investments;
+    }
+    
+    // Simulate multiple months of investments
+    SymbolMap<std::vector<double>> simulateInvestments(int months) {
+        SymbolMap<std::vector<double>> simulatedInvestments;
+        
+        for (int i = 0; i < months; ++i) {
+            auto monthlyInvestments = executeInvestment(true);
+            
+            for (const auto& [id, amount] : monthlyInvestments) {
+                simulatedInvestments[id].push_back(amount);
+            }
+        }
+        
+        return simulatedInvestments;
+    }
+    
+    // Calculate projected growth of SIP over time
+    // Using SIP compound interest formula: P * ((1 + r)^n - 1) / r * (1 + r)
+    double calculateProjectedGrowth(int months, double annualReturnRate) const {
+        return GrowthProjector::futureValue(months, annualReturnRate, monthlyAmount, 0.0,
+                                            ContributionTiming::StartOfMonth);
+    }
+    
+    // Projected growth for every (horizon, annual rate) pair in one pass:
+    // result.at(horizon, rate, 0)
+    ProjectionMatrix projectGrowthGrid(const std::vector<int>& months,
+                                              const std::vector<double>& annualReturnRates) const {
+        return GrowthProjector::grid(months, annualReturnRates, {monthlyAmount}, 0.0,
+                                     ContributionTiming::StartOfMonth);
+    }
+    
+    // Get allocation
+    const SymbolMap<double>& getAllocation() const {
+        return allocation;
+    }
+    
+    // Get monthly amount
+    double getMonthlyAmount() const {
+        return monthlyAmount;
+    }
+    
+    // Toggle auto-invest
+    void toggleAutoInvest() {
+        autoInvest = !autoInvest;
+    }
+    
+    // Get auto-invest status
+    bool getAutoInvestStatus() const {
+        return autoInvest;
+    }
+    
+    std::chrono::system_clock::time_point getLastInvestmentDate() const {
+        return lastInvestmentDate;
+    }
+    
+    // Record an investment made elsewhere, e.g. replayed from the journal
+    void setLastInvestmentDate(std::chrono::system_clock::time_point date) {
+        lastInvestmentDate = date;
+    }
+    
+    // Saved state; the last investment date is kept at millisecond precision
+    void save(BinaryWriter& out) const {
+        out.put(monthlyAmount);
+        out.put<std::uint8_t>(autoInvest ? 1 : 0);
+        out.put<std::int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            lastInvestmentDate.time_since_epoch()).count());
+        out.put<std::uint32_t>(static_cast<std::uint32_t>(allocation.size()));
+        for (const auto& [id, percentage] : allocation) {
+            out.putSymbol(id);
+            out.put(percentage);
+        }
+    }
+    
+    void load(BinaryReader& in) {
+        monthlyAmount = in.get<double>();
+        autoInvest = in.get<std::uint8_t>() != 0;
+        lastInvestmentDate = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::milliseconds(in.get<std::int64_t>())));
+        std::uint32_t count = in.get<std::uint32_t>();
+        allocation.clear();
+        for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+            SymbolId id = in.getSymbol();
+            allocation[id] = in.get<double>();
+        }
+    }
+    
+    // Display SIP details
+    void display() const {
+        std::cout << "\n========== SIP MANAGER ==========\n" << std::endl;
+        std::cout << "Monthly Investment: " << Utils::formatCurrency(monthlyAmount) << std::endl;
+        std::cout << "Auto-Invest: " << (autoInvest ? "Enabled" : "Disabled") << std::endl;
+        std::cout << "Current Allocation:" << std::endl;
+        
+        for (const auto& [id, percentage] : allocation) {
+            std::cout << "  " << SymbolTable::global().name(id) << ": " << percentage << "%" << std::endl;
+        }
+        
+        ProjectionMatrix projection = projectGrowthGrid({12, 60, 120, 240}, {10.0});
+        std::cout << "\nProjected Growth (10% annual return):" << std::endl;
+        std::cout << "  1 Year: " << Utils::formatCurrency(projection.at(0, 0, 0)) << std::endl;
+        std::cout << "  5 Years: " << Utils::formatCurrency(projection.at(1, 0, 0)) << std::endl;
+        std::cout << "  10 Years: " << Utils::formatCurrency(projection.at(2, 0, 0)) << std::endl;
+        std::cout << "  20 Years: " << Utils::formatCurrency(projection.at(3, 0, 0)) << std::endl;
+        
+        std::cout << std::endl;
+    }
+};
+
+// The asset class each symbol is held as. `value` is the amount invested
+// at `price`; cash is held at 1.0 with the given rates (percent).
+class AssetFactory {
+public:
+    static std::shared_ptr<Asset> create(const std::string& symbol, double price, double value,
+                                         double interestRate, double inflationRate) {
+        double quantity = value / price;
+        if (symbol == "SIP") {
+            // Index ETF as SIP
+            return std::make_shared<SIP>("Vanguard Total Stock Market ETF", "VTI", price, quantity);
+        }
+        if (symbol == "BTC") {
+            return std::make_shared<Cryptocurrency>("Bitcoin", "BTC", price, 1000000000000.0, quantity);
+        }
+        if (symbol == "XAU/USD") {
+            return std::make_shared<Commodity>("Gold", "XAU/USD", price, "24K", false, quantity);
+        }
+        if (symbol == "USD") {
+            return std::make_shared<FiatCurrency>("US Dollar", "USD", 1.0, "United States",
+                                                  interestRate, inflationRate, value);
+        }
+        if (symbol.find('/') != std::string::npos) {
+            std::string baseCurrency = symbol.substr(0, 3);
+            std::string quoteCurrency = symbol.substr(4, 3);
+            return std::make_shared<Forex>(baseCurrency + " to " + quoteCurrency, symbol,
+                                           price, baseCurrency, quoteCurrency, quantity);
+        }
+        // Generic asset as fallback
+        return std::make_shared<Asset>(symbol, symbol, price, quantity);
+    }
+};
+
+// Long-run annual return and volatility assumptions (percent) by asset
+// class, used where there is too little history to estimate them
+struct ReturnPrior {
+    double annualReturn;
+    double annualVolatility;
+    
+    static ReturnPrior forAsset(const Asset& asset) {
+        if (auto sip = dynamic_cast<const SIP*>(&asset)) {
+            return {sip->getExpectedAnnualReturn() - sip->getExpenseRatio(), 16.0};
+        }
+        if (dynamic_cast<const Cryptocurrency*>(&asset)) {
+            return {20.0, 70.0};
+        }
+        if (dynamic_cast<const Commodity*>(&asset)) {
+            return {5.0, 15.0};
+        }
+        if (dynamic_cast<const Forex*>(&asset)) {
+            return {0.0, 8.0};
+        }
+        if (auto fiat = dynamic_cast<const FiatCurrency*>(&asset)) {
+            return {fiat->getInterestRate(), 0.0};
+        }
+        return {7.0, 15.0};
+    }
+};
+
+// Per-asset weight limits and an optional turnover cap for the optimizer.
+// Weights are fractions of the portfolio in the optimizer's asset order.
+struct OptimizerConstraints {
+    std::vector<double> minWeights;         // Empty means 0 for every asset
+    std::vector<double> maxWeights;         // Empty means 1 for every asset
+    std::vector<double> currentWeights;     // Allocation being moved away from; empty disables the cap
+    double maxTurnover = 2.0;               // Cap on sum |w - current|; 2 never binds
+};
+
+// One point on the efficient frontier; annual figures as fractions
+struct FrontierPoint {
+    std::vector<double> weights;
+    double expectedReturn = 0.0;
+    double volatility = 0.0;
+};
+
+// Long-only mean-variance optimizer. For a trade-off t >= 0 it solves
+//   minimise 1/2 w^T Sigma w - t mu^T w
+//   subject to sum w = 1, min <= w <= max
+// by accelerated projected gradient with adaptive restart. Projecting onto
+// the capped simplex is a search for the shift s with sum clamp(v - s) = 1.
+// Volatility rises monotonically with t, so a target volatility is reached
+// by a bracketed secant search on t, each solve warm-started from the last.
+class PortfolioOptimizer {
+private:
+    std::vector<double> expected;
+    std::vector<double> sigma;
+    std::vector<double> lower;
+    std::vector<double> upper;
+    std::vector<double> current;
+    double maxTurnover;
+    double step;                            // 1 / largest eigenvalue of Sigma
+    
+    static constexpr int kMaxIterations = 5000;
+    static constexpr int kMaxSearchSteps = 60;
+    
+    size_t dimension() const { return expected.size(); }
+    
+    // Largest eigenvalue of Sigma: power iteration, capped by the
+    // Gershgorin bound so the step can never be too long
+    double largestEigenvalue() const {
+        size_t n = dimension();
+        double gershgorin = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double row = 0.0;
+            for (size_t j = 0; j < n; ++j) row += std::abs(sigma[i * n + j]);
+            gershgorin = std::max(gershgorin, row);
+        }
+        
+        std::vector<double> v(n, 1.0 / std::sqrt(static_cast<double>(n))), next(n);
+        double estimate = 0.0;
+        for (int it = 0; it < 100; ++it) {
+            double norm = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                double sum = 0.0;
+                for (size_t j = 0; j < n; ++j) sum += sigma[i * n + j] * v[j];
+                next[i] = sum;
+                norm += sum * sum;
+            }
+            norm = std::sqrt(norm);
+            if (norm <= 0.0) break;
+            for (size_t i = 0; i < n; ++i) v[i] = next[i] / norm;
+            estimate = norm;
+        }
+        return std::min(gershgorin, estimate * 1.05);
+    }
+    
+    // Euclidean projection onto {sum w = 1, lower <= w <= upper}.
+    // sum clamp(w - shift) is piecewise linear in the shift with kinks at
+    // w - upper and w - lower, so a binary search over the sorted kinks
+    // finds the segment that crosses one and the shift is interpolated.
+    void project(double* w) const {
+        size_t n = dimension();
+        auto total = [&](double shift) {
+            double sum = 0.0;
+            for (size_t i = 0; i < n; ++i) sum += std::clamp(w[i] - shift, lower[i], upper[i]);
+            return sum;
+        };
+        
+        std::vector<double> kinks(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            kinks[2 * i] = w[i] - upper[i];
+            kinks[2 * i + 1] = w[i] - lower[i];
+        }
+        std::sort(kinks.begin(), kinks.end());
+        
+        // total() is sum(upper) >= 1 at the first kink, sum(lower) <= 1 at the last
+        size_t lo = 0;
+        size_t hi = kinks.size() - 1;
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (total(kinks[mid]) >= 1.0) lo = mid; else hi = mid;
+        }
+        double atLo = total(kinks[lo]);
+        double atHi = total(kinks[hi]);
+        double shift = atLo > atHi ? kinks[lo] + (atLo - 1.0) / (atLo - atHi) * (kinks[hi] - kinks[lo])
+                                   : kinks[lo];
+        for (size_t i = 0; i < n; ++i) w[i] = std::clamp(w[i] - shift, lower[i], upper[i]);
+    }
+    
+    // Solve for trade-off t, starting from (and overwriting) feasible w
+    void solve(double tradeoff, std::vector<double>& w) const {
+        size_t n = dimension();
+        std::vector<double> y(w), next(n);
+        double momentum = 1.0;
+        
+        for (int it = 0; it < kMaxIterations; ++it) {
+            for (size_t i = 0; i < n; ++i) {
+                double gradient = -tradeoff * expected[i];
+                const double* row = &sigma[i * n];
+                for (size_t j = 0; j < n; ++j) gradient += row[j] * y[j];
+                next[i] = y[i] - step * gradient;
+            }
+            project(next.data());
+            
+            double moved = 0.0;
+            double reversal = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                double delta = next[i] - w[i];
+                moved += delta * delta;
+                reversal += (y[i] - next[i]) * delta;
+            }
+            
+            double nextMomentum = 0.5 * (1.0 + std::sqrt(1.0 + 4.0 * momentum * momentum));
+            if (reversal > 0.0) {
+                // The extrapolated step overshot: drop the momentum
+                nextMomentum = 1.0;
+                y = next;
+            } else {
+                double beta = (momentum - 1.0) / nextMomentum;
+                for (size_t i = 0; i < n; ++i) y[i] = next[i] + beta * (next[i] - w[i]);
+            }
+            w.swap(next);
+            momentum = nextMomentum;
+            
+            if (moved < 1e-20) break;
+        }
+    }
+    
+    FrontierPoint pointFor(std::vector<double> weights) const {
+        FrontierPoint point;
+        point.expectedReturn = expectedReturn(weights);
+        point.volatility = volatility(weights);
+        point.weights = std::move(weights);
+        return point;
+    }
+    
+    // Frontier point with the given volatility between the two end points;
+    // `w` carries the warm start between calls
+    FrontierPoint pointAt(double targetVolatility, const FrontierPoint& low, const FrontierPoint& high,
+                          std::vector<double>& w) const {
+        if (targetVolatility <= low.volatility) return low;
+        if (targetVolatility >= high.volatility) return high;
+        
+        double tLow = 0.0;
+        double tHigh = 1.0;
+        double gapLow = low.volatility - targetVolatility;
+        double gapHigh;
+        for (;;) {
+            solve(tHigh, w);
+            gapHigh = volatility(w) - targetVolatility;
+            if (gapHigh >= 0.0) break;
+            if (tHigh > 1e6) return high;
+            tLow = tHigh;
+            gapLow = gapHigh;
+            tHigh *= 4.0;
+        }
+        
+        // Regula falsi with the Illinois modification: a bracket end that
+        // survives twice running has its gap halved so both ends keep moving
+        int lastSide = 0;
+        for (int it = 0; it < kMaxSearchSteps && std::abs(gapHigh) > 1e-4 * targetVolatility; ++it) {
+            double t = (tLow * gapHigh - tHigh * gapLow) / (gapHigh - gapLow);
+            solve(t, w);
+            double gap = volatility(w) - targetVolatility;
+            if (std::abs(gap) <= 1e-4 * targetVolatility) break;
+            if (gap < 0.0) {
+                tLow = t;
+                gapLow = gap;
+                if (lastSide < 0) gapHigh *= 0.5;
+                lastSide = -1;
+            } else {
+                tHigh = t;
+                gapHigh = gap;
+                if (lastSide > 0) gapLow *= 0.5;
+                lastSide = 1;
+            }
+        }
+        return pointFor(w);
+    }
+    
+public:
+    // Annual expected returns and covariance (fractions), Sigma row-major
+    PortfolioOptimizer(std::vector<double> expectedReturns, std::vector<double> covariance,
+                       const OptimizerConstraints& constraints = {})
+        : expected(std::move(expectedReturns)), sigma(std::move(covariance)),
+          maxTurnover(constraints.maxTurnover) {
+        size_t n = dimension();
+        sigma.resize(n * n, 0.0);
+        lower = constraints.minWeights.size() == n ? constraints.minWeights : std::vector<double>(n, 0.0);
+        upper = constraints.maxWeights.size() == n ? constraints.maxWeights : std::vector<double>(n, 1.0);
+        
+        double lowerTotal = 0.0;
+        double upperTotal = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            lower[i] = std::clamp(lower[i], 0.0, 1.0);
+            upper[i] = std::clamp(upper[i], lower[i], 1.0);
+            lowerTotal += lower[i];
+            upperTotal += upper[i];
+        }
+        if (n > 0 && (lowerTotal > 1.0 || upperTotal < 1.0)) {
+            std::cerr << "Warning: Allocation bounds cannot sum to 100%. Ignoring them..." << std::endl;
+            std::fill(lower.begin(), lower.end(), 0.0);
+            std::fill(upper.begin(), upper.end(), 1.0);
+        }
+        
+        double eigenvalue = largestEigenvalue();
+        step = eigenvalue > 0.0 ? 1.0 / eigenvalue : 1.0;
+        
+        if (constraints.currentWeights.size() == n && n > 0) {
+            current = constraints.currentWeights;
+            project(current.data());
+        }
+    }
+    
+    double expectedReturn(const std::vector<double>& w) const {
+        double total = 0.0;
+        for (size_t i = 0; i < dimension(); ++i) total += w[i] * expected[i];
+        return total;
+    }
+    
+    double volatility(const std::vector<double>& w) const {
+        size_t n = dimension();
+        double variance = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double row = 0.0;
+            for (size_t j = 0; j < n; ++j) row += sigma[i * n + j] * w[j];
+            variance += w[i] * row;
+        }
+        return std::sqrt(std::max(0.0, variance));
+    }
+    
+    // Lowest-volatility portfolio within the bounds
+    FrontierPoint minimumVariance() const {
+        std::vector<double> w(dimension(), 1.0 / std::max<size_t>(1, dimension()));
+        if (w.empty()) return {};
+        project(w.data());
+        solve(0.0, w);
+        return pointFor(std::move(w));
+    }
+    
+    // Highest-return portfolio within the bounds: every asset at its
+    // minimum, then the remainder poured into the best returns first
+    FrontierPoint maximumReturn() const {
+        size_t n = dimension();
+        std::vector<double> w(lower);
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return expected[a] > expected[b]; });
+        
+        double remaining = 1.0 - std::accumulate(lower.begin(), lower.end(), 0.0);
+        for (size_t i : order) {
+            double add = std::min(remaining, upper[i] - lower[i]);
+            w[i] += add;
+            remaining -= add;
+        }
+        return pointFor(std::move(w));
+    }
+    
+    // Mean-variance optimum for one trade-off between return and variance
+    FrontierPoint optimalFor(double tradeoff) const {
+        FrontierPoint start = minimumVariance();
+        solve(std::max(0.0, tradeoff), start.weights);
+        return pointFor(std::move(start.weights));
+    }
+    
+    // `points` portfolios evenly spaced in volatility from the minimum
+    // variance portfolio to the maximum return one
+    std::vector<FrontierPoint> frontier(size_t points) const {
+        std::vector<FrontierPoint> result;
+        if (points == 0 || dimension() == 0) return result;
+        
+        FrontierPoint low = minimumVariance();
+        FrontierPoint high = maximumReturn();
+        std::vector<double> w = low.weights;
+        for (size_t k = 0; k < points; ++k) {
+            double fraction = points > 1 ? static_cast<double>(k) / static_cast<double>(points - 1) : 0.0;
+            double target = low.volatility + fraction * (high.volatility - low.volatility);
+            result.push_back(pointAt(target, low, high, w));
+        }
+        return result;
+    }
+    
+    // Frontier point for a risk score (0 = minimum variance, 100 = maximum
+    // return, linear in volatility in between). With current weights set,
+    // the move is scaled back toward them until it fits the turnover cap.
+    FrontierPoint forRiskScore(double riskScore) const {
+        if (dimension() == 0) return {};
+        
+        FrontierPoint low = minimumVariance();
+        FrontierPoint high = maximumReturn();
+        double fraction = std::clamp(riskScore / 100.0, 0.0, 1.0);
+        std::vector<double> w = low.weights;
+        FrontierPoint point = pointAt(low.volatility + fraction * (high.volatility - low.volatility),
+                                      low, high, w);
+        
+        if (!current.empty()) {
+            double turnover = 0.0;
+            for (size_t i = 0; i < dimension(); ++i) turnover += std::abs(point.weights[i] - current[i]);
+            if (turnover > maxTurnover) {
+                double scale = maxTurnover / turnover;
+                for (size_t i = 0; i < dimension(); ++i) {
+                    point.weights[i] = current[i] + scale * (point.weights[i] - current[i]);
+                }
+                point = pointFor(std::move(point.weights));
+            }
+        }
+        return point;
+    }
+};
+
+// Risk Analyzer class to assess portfolio risk
+class RiskAnalyzer {
+private:
+    double riskScore; // 0-100 (0 = lowest risk, 100 = highest risk)
+    SymbolMap<double> idealAllocation; // Based on risk score
+    double volatilityThreshold; // Threshold for considering an asset volatile
+    mutable VaREngine varEngine; // Caches its last result, so const callers share it
+    
+    std::vector<SymbolId> universe; // Instruments the ideal allocation is spread over
+    std::vector<ReturnPrior> priors; // Per universe instrument, from its asset class
+    std::vector<double> observedCorrelation; // Row-major over universe, NaN where not observed
+    size_t observedSamples = 0;
+    std::vector<double> observedReturns; // Annual percent from daily history, NaN until enough days
+    std::vector<double> observedVolatilities;
+    size_t observedDays = 0;
+    double minWeight = 5.0; // Per-asset allocation bounds (percent)
+    double maxWeight = 50.0;
+    double maxTurnover = 10.0; // Cap on sum |change| per market refresh (percent)
+    FrontierPoint target; // Frontier point behind the ideal allocation
+    
+    // Samples at which observed correlations and the prior weigh equally
+    static constexpr double kCorrelationShrinkage = 60.0;
+    static constexpr double kPriorCorrelation = 0.2;
+    // Days of history before daily means and volatilities count at all,
+    // and the days at which each weighs equally with its prior. Means are
+    // far noisier than volatilities, so they need much longer.
+    static constexpr size_t kMinHistoryDays = 30;
+    static constexpr double kReturnShrinkage = 250.0;
+    static constexpr double kVolatilityShrinkage = 60.0;
+    
+    static double shrink(double observed, double prior, double weight) {
+        return std::isnan(observed) ? prior : weight * observed + (1.0 - weight) * prior;
+    }
+    
+    // Optimizer over the universe: returns, volatilities and correlations
+    // each shrunk from what has been observed toward the asset-class prior
+    PortfolioOptimizer buildOptimizer(bool limitTurnover) const {
+        size_t n = universe.size();
+        if (priors.size() != n) return PortfolioOptimizer({}, {});
+        
+        std::vector<double> expected(n), vols(n), covariance(n * n);
+        double days = static_cast<double>(observedDays);
+        for (size_t i = 0; i < n; ++i) {
+            expected[i] = shrink(observedReturns[i], priors[i].annualReturn, days / (days + kReturnShrinkage)) / 100.0;
+            vols[i] = shrink(observedVolatilities[i], priors[i].annualVolatility,
+                             days / (days + kVolatilityShrinkage)) / 100.0;
+        }
+        
+        double blend = static_cast<double>(observedSamples) / (observedSamples + kCorrelationShrinkage);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                double correlation = 1.0;
+                if (i != j) {
+                    double observed = observedCorrelation[i * n + j];
+                    correlation = shrink(observed, kPriorCorrelation, blend);
+                }
+                covariance[i * n + j] = correlation * vols[i] * vols[j];
+            }
+        }
+        
+        // A universe too small or too large for the bounds is left unbounded
+        OptimizerConstraints constraints;
+        if (n * minWeight <= 100.0 && n * maxWeight >= 100.0) {
+            constraints.minWeights.assign(n, minWeight / 100.0);
+            constraints.maxWeights.assign(n, maxWeight / 100.0);
+        }
+        if (limitTurnover && !idealAllocation.empty()) {
+            for (SymbolId id : universe) {
+                const double* percent = idealAllocation.find(id);
+                constraints.currentWeights.push_back(percent ? *percent / 100.0 : 0.0);
+            }
+            constraints.maxTurnover = maxTurnover / 100.0;
+        }
+        return PortfolioOptimizer(std::move(expected), std::move(covariance), constraints);
+    }
+
+public:
+    // Targets stay empty until setUniverse() names the instruments
+    RiskAnalyzer(double riskScore = 50.0, double volatilityThreshold = 15.0)
+        : riskScore(riskScore), volatilityThreshold(volatilityThreshold) {}
+    
+    // Spread the ideal allocation over `assets`, with priors from each
+    // asset's class. The targets are re-solved only when the set of
+    // instruments changes, and observations over the old set are dropped.
+    void setUniverse(const AssetMap& assets) {
+        std::vector<SymbolId> current(universe);
+        std::vector<SymbolId> next(assets.ids());
+        std::sort(current.begin(), current.end());
+        std::sort(next.begin(), next.end());
+        bool changed = current != next;
+        if (changed) {
+            universe = assets.ids();
+            size_t n = universe.size();
+            observedCorrelation.assign(n * n, std::numeric_limits<double>::quiet_NaN());
+            observedSamples = 0;
+            observedReturns.assign(n, std::numeric_limits<double>::quiet_NaN());
+            observedVolatilities.assign(n, std::numeric_limits<double>::quiet_NaN());
+            observedDays = 0;
+        }
+        
+        priors.clear();
+        for (SymbolId id : universe) {
+            priors.push_back(ReturnPrior::forAsset(**assets.find(id)));
+        }
+        if (changed) updateIdealAllocation();
+    }
+    
+    // Set risk score and update ideal allocation
+    void setRiskScore(double newRiskScore) {
+        riskScore = std::min(100.0, std::max(0.0, newRiskScore));
+        updateIdealAllocation();
+    }
+    
+    // Get risk score
+    double getRiskScore() const {
+        return riskScore;
+    }
+    
+    // Update ideal allocation: the efficient-frontier point for the risk
+    // score, in whole tenths of a percent. A market refresh passes
+    // limitTurnover so targets drift by at most maxTurnover per update.
+    void updateIdealAllocation(bool limitTurnover = false) {
+        // Restored targets stand until setUniverse() supplies the priors
+        if (priors.size() != universe.size()) return;
+        PortfolioOptimizer optimizer = buildOptimizer(limitTurnover);
+        target = optimizer.forRiskScore(riskScore);
+        
+        idealAllocation.clear();
+        double total = 0.0;
+        size_t largest = 0;
+        for (size_t i = 0; i < universe.size(); ++i) {
+            double percent = std::round(target.weights[i] * 1000.0) / 10.0;
+            idealAllocation[universe[i]] = percent;
+            total += percent;
+            if (target.weights[i] > target.weights[largest]) largest = i;
+        }
+        // Rounding residue goes to the largest position
+        if (!universe.empty()) {
+            idealAllocation[universe[largest]] += 100.0 - total;
+        }
+    }
+    
+    // Feed correlations from the covariance window and re-solve the targets
+    void observeCorrelation(const CovarianceEngine& covariance) {
+        if (!covariance.isReady()) return;
+        size_t n = universe.size();
+        for (size_t a = 0; a < n; ++a) {
+            for (size_t b = 0; b < n; ++b) {
+                double& cell = observedCorrelation[a * n + b];
+                if (covariance.contains(universe[a]) && covariance.contains(universe[b])) {
+                    cell = covariance.correlation(covariance.indexOf(universe[a]), covariance.indexOf(universe[b]));
+                } else {
+                    cell = std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+        }
+        observedSamples = covariance.getCount();
+        updateIdealAllocation(true);
+    }
+    
+    // Annual means and volatilities from the daily return window, used
+    // from the next re-solve on; ignored until kMinHistoryDays have closed
+    void observeReturns(const DailyReturns& daily) {
+        const CovarianceEngine& window = daily.getCovariance();
+        observedDays = daily.getDayCount() >= kMinHistoryDays ? daily.getDayCount() : 0;
+        for (size_t i = 0; i < universe.size(); ++i) {
+            if (observedDays == 0 || !window.contains(universe[i])) {
+                observedReturns[i] = std::numeric_limits<double>::quiet_NaN();
+                observedVolatilities[i] = std::numeric_limits<double>::quiet_NaN();
+                continue;
+            }
+            size_t k = window.indexOf(universe[i]);
+            observedReturns[i] = window.mean(k) * 252.0 * 100.0;
+            observedVolatilities[i] = std::sqrt(std::max(0.0, window.covariance(k, k)) * 252.0) * 100.0;
+        }
+    }
+    
+    // Per-asset allocation bounds for the ideal allocation (percent)
+    void setAllocationBounds(double minPercent, double maxPercent) {
+        minWeight = minPercent;
+        maxWeight = maxPercent;
+        updateIdealAllocation();
+    }
+    
+    // Largest total change to the targets per market refresh (percent)
+    void setMaxTurnover(double percent) {
+        maxTurnover = std::max(0.0, percent);
+    }
+    
+    // `points` frontier portfolios from minimum variance to maximum return
+    std::vector<FrontierPoint> efficientFrontier(size_t points) const {
+        return buildOptimizer(false).frontier(points);
+    }
+    
+    const std::vector<SymbolId>& getUniverse() const {
+        return universe;
+    }
+    
+    // Get ideal allocation
+    const SymbolMap<double>& getIdealAllocation() const {
+        return idealAllocation;
+    }
+    
+    // Saved state. The targets depend on every refresh seen so far (turnover
+    // limits make them path-dependent), so they are restored as saved rather
+    // than re-solved. Priors and daily figures are not saved; setUniverse()
+    // and observeReturns() rebuild them from the restored holdings.
+    void save(BinaryWriter& out) const {
+        out.put(riskScore);
+        out.put(volatilityThreshold);
+        out.put(minWeight);
+        out.put(maxWeight);
+        out.put(maxTurnover);
+        out.put<std::uint64_t>(observedSamples);
+        out.put<std::uint32_t>(static_cast<std::uint32_t>(universe.size()));
+        for (SymbolId id : universe) {
+            out.putSymbol(id);
+        }
+        out.putArray(observedCorrelation);
+        out.put<std::uint32_t>(static_cast<std::uint32_t>(idealAllocation.size()));
+        for (const auto& [id, percent] : idealAllocation) {
+            out.putSymbol(id);
+            out.put(percent);
+        }
+        out.putArray(target.weights);
+        out.put(target.expectedReturn);
+        out.put(target.volatility);
+    }
+    
+    void load(BinaryReader& in) {
+        riskScore = in.get<double>();
+        volatilityThreshold = in.get<double>();
+        minWeight = in.get<double>();
+        maxWeight = in.get<double>();
+        maxTurnover = in.get<double>();
+        observedSamples = static_cast<size_t>(in.get<std::uint64_t>());
+        std::uint32_t n = in.get<std::uint32_t>();
+        universe.clear();
+        for (std::uint32_t i = 0; i < n && in.ok(); ++i) {
+            universe.push_back(in.getSymbol());
+        }
+        observedCorrelation = in.getArray<double>();
+        std::uint32_t count = in.get<std::uint32_t>();
+        idealAllocation.clear();
+        for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+            SymbolId id = in.getSymbol();
+            idealAllocation[id] = in.get<double>();
+        }
+        target.weights = in.getArray<double>();
+        target.expectedReturn = in.get<double>();
+        target.volatility = in.get<double>();
+        priors.clear();
+        observedReturns.assign(universe.size(), std::numeric_limits<double>::quiet_NaN());
+        observedVolatilities.assign(universe.size(), std::numeric_limits<double>::quiet_NaN());
+        observedDays = 0;
+        if (observedCorrelation.size() != universe.size() * universe.size() ||
+            target.weights.size() != universe.size()) {
+            in.fail();
+        }
+    }
+    
+    // Calculate portfolio volatility as sqrt(w^T Sigma w), which credits
+    // diversification; falls back to the value-weighted average of asset
+    // volatilities until the covariance window has samples
+    double calculatePortfolioVolatility(const PortfolioSnapshot& snapshot, const CovarianceEngine& covariance) const {
+        if (covariance.isReady()) {
+            return covariance.portfolioVolatility(snapshot);
+        }
+        return snapshot.getTotals().weightedVolatility;
+    }
+    
+    // Assess if an asset is too volatile
+    bool isAssetTooVolatile(const Asset& asset) const {
+        return asset.getVolatility() > volatilityThreshold;
+    }
+    
+    // Calculate risk-adjusted return (Sharpe Ratio-like)
+    double calculateRiskAdjustedReturn(const PortfolioSnapshot& snapshot, const CovarianceEngine& covariance,
+                                       double riskFreeRate = 0.5) const {
+        const HoldingsTable::Totals& totals = snapshot.getTotals();
+        if (totals.totalValue <= 0.0) return 0.0;
+        
+        double portfolioVolatility = calculatePortfolioVolatility(snapshot, covariance);
         
-        if (volatility > 20.0) {
-            analysis += "  This cryptocurrency shows extreme volatility. Consider reducing exposure.\n";
-        }
+        // Avoid division by zero
+        if (portfolioVolatility <= 0.0) return 0.0;
         
-        if (isStaking) {
-            analysis += "  You are earning " + std::to_string(stakingYield) + 
-                       "% APY through staking, which helps offset volatility.\n";
-        } else {
-            analysis += "  Consider staking options to earn passive income from your holdings.\n";
+        // (Portfolio Return - Risk-Free Rate) / Portfolio Volatility
+        return (totals.weightedReturn - riskFreeRate) / portfolioVolatility;
+    }
+    
+    // Value-at-Risk and Expected Shortfall over daily returns, one report
+    // per confidence level; updated only when holdings change or a day closes
+    const std::vector<RiskReport>& calculateValueAtRisk(const PortfolioSnapshot& snapshot,
+                                                        const DailyReturns& daily) const {
+        return varEngine.evaluate(snapshot, daily);
+    }
+    
+    // Confidence levels for VaR, e.g. {0.95, 0.99}
+    void setVaRConfidenceLevels(const std::vector<double>& levels) {
+        varEngine.setConfidenceLevels(levels);
+    }
+    
+    // Recommend rebalancing based on current allocation vs ideal
+    SymbolMap<double> recommendRebalancing(const PortfolioSnapshot& snapshot) const {
+        SymbolMap<double> recommendations;
+        
+        if (snapshot.getTotalValue() <= 0.0) return recommendations;
+        
+        // Compare with ideal allocation and generate recommendations
+        for (const auto& [id, idealPercent] : idealAllocation) {
+            double currentPercent = snapshot.weightOf(id);
+            
+            double difference = idealPercent - currentPercent;
+            
+            // Only recommend significant changes (more than 5% difference)
+            if (std::abs(difference) >= 5.0) {
+                recommendations[id] = difference;
+            }
         }
         
-        return analysis;
+        return recommendations;
     }
-};
-
-// Commodity (Gold) asset
-class Commodity : public Asset {
-private:
-    std::string grade; // e.g., "24K", "22K" for gold
-    bool isPhysical;   // physical gold vs paper gold (ETF)
-
-public:
-    Commodity(const std::string& name, const std::string& symbol, double currentPrice,
-             const std::string& grade = "24K", bool isPhysical = false, double quantity = 0.0)
-        : Asset(name, symbol, currentPrice, quantity),
-          grade(grade), isPhysical(isPhysical) {}
-    
-    // Getters
-    std::string getGrade() const { return grade; }
-    bool getIsPhysical() const { return isPhysical; }
     
-    // Inflation hedge calculation
-    double calculateInflationHedge(double inflationRate, int years) const {
-        double annualLossToInflation = inflationRate / 100.0;
-        double valueWithoutHedge = getCurrentValue() * std::pow(1 - annualLossToInflation, years);
-        return getCurrentValue() - valueWithoutHedge;
+    // Adjust risk score based on market conditions
+    void adjustRiskScoreForMarketConditions(double vix, double btcVolatility) {
+        double adjustment = 0.0;
+        
+        // VIX adjustment
+        if (vix > 30.0) {
+            // High market volatility, reduce risk
+            adjustment -= 10.0;
+        } else if (vix < 15.0) {
+            // Low market volatility, can increase risk
+            adjustment += 5.0;
+        }
+        
+        // BTC volatility adjustment
+        if (btcVolatility > 20.0) {
+            // High crypto volatility, reduce risk
+            adjustment -= 5.0;
+        }
+        
+        // Apply adjustment with limits
+        double newRiskScore = riskScore + adjustment;
+        setRiskScore(std::min(100.0, std::max(0.0, newRiskScore)));
     }
     
-    // Override display for commodity-specific details
-    void display() const override {
-        Asset::display();
-        std::cout << "  Grade: " << grade << std::endl;
-        std::cout << "  Physical Holding: " << (isPhysical ? "Yes" : "No") << std::endl;
-        std::cout << "  Inflation Hedge (5% inflation, 5 years): " 
-                  << Utils::formatCurrency(calculateInflationHedge(5.0, 5)) << std::endl;
+    // Display risk analysis
+    void display() const {
+        std::cout << "\n========== RISK ANALYSIS ==========\n" << std::endl;
+        std::cout << "Risk Score: " << riskScore << "/100" << std::endl;
+        std::cout << "Risk Profile: " << getRiskProfileStr() << std::endl;
+        std::cout << "Volatility Threshold: " << volatilityThreshold << "%" << std::endl;
+        
+        std::cout << "\nIdeal Asset Allocation:" << std::endl;
+        for (const auto& [id, percentage] : idealAllocation) {
+            std::cout << "  " << SymbolTable::global().name(id) << ": " << percentage << "%" << std::endl;
+        }
+        std::cout << "Expected Return: " << std::fixed << std::setprecision(2) << target.expectedReturn * 100.0
+                  << "% a year, Volatility: " << target.volatility * 100.0 << "%" << std::endl;
+        
         std::cout << std::endl;
     }
     
-    // Override get analysis for commodity-specific analysis
-    std::string getAnalysis() const override {
-        std::string analysis = Asset::getAnalysis();
+    // Display risk analysis with VaR / Expected Shortfall for the holdings
+    void display(const PortfolioSnapshot& snapshot, const DailyReturns& daily) const {
+        display();
+        
+        const std::vector<RiskReport>& reports = calculateValueAtRisk(snapshot, daily);
+        if (reports.empty()) {
+            std::cout << "Value at Risk: not enough daily price history yet ("
+                      << daily.getDayCount() << " days)." << std::endl << std::endl;
+            return;
+        }
         
-        analysis += "  This " + grade + " gold is held as " + 
-                   (isPhysical ? "physical metal" : "a paper investment") + ".\n";
+        const char* methods[] = {"Historical", "Parametric", "Monte Carlo"};
+        int horizon = varEngine.getHorizonDays();
+        std::cout << "Value at Risk (" << reports.front().samples << " daily returns";
+        if (std::optional<Date> through = daily.getLastClosedDay()) {
+            std::cout << " through " << through->toString();
+        }
+        std::cout << "):" << std::endl;
+        std::cout << "  " << std::left << std::setw(18) << "Method" << std::right
+                  << std::setw(14) << "1-day VaR" << std::setw(14) << "1-day ES"
+                  << std::setw(14) << (std::to_string(horizon) + "-day VaR")
+                  << std::setw(14) << (std::to_string(horizon) + "-day ES") << std::endl;
+        for (const RiskReport& report : reports) {
+            for (size_t m = 0; m < 3; ++m) {
+                std::ostringstream label;
+                label << methods[m] << " " << static_cast<int>(std::round(report.confidence * 100)) << "%";
+                std::cout << "  " << std::left << std::setw(18) << label.str() << std::right
+                          << std::setw(14) << Utils::formatCurrency(report.oneDay[m].valueAtRisk)
+                          << std::setw(14) << Utils::formatCurrency(report.oneDay[m].expectedShortfall)
+                          << std::setw(14) << Utils::formatCurrency(report.horizon[m].valueAtRisk)
+                          << std::setw(14) << Utils::formatCurrency(report.horizon[m].expectedShortfall) << std::endl;
+            }
+        }
         
-        if (volatility < 10.0) {
-            analysis += "  Gold is currently showing relative stability, providing a good hedge.\n";
+        const RiskReport& primary = reports.front();
+        double parametricVaR = primary.oneDay[static_cast<size_t>(VaRMethod::Parametric)].valueAtRisk;
+        std::cout << "\nVaR Contribution (parametric, 1-day " 
+                  << static_cast<int>(std::round(primary.confidence * 100)) << "%):" << std::endl;
+        for (const auto& holding : primary.holdings) {
+            double share = parametricVaR > 0.0 ? holding.componentVaR / parametricVaR * 100.0 : 0.0;
+            std::cout << "  " << std::left << std::setw(10) << SymbolTable::global().name(holding.id) << std::right
+                      << " marginal " << std::fixed << std::setprecision(4) << holding.marginalVaR
+                      << "  component " << Utils::formatCurrency(holding.componentVaR)
+                      << " (" << std::setprecision(1) << share << "%)" << std::endl;
+        }
+        std::cout << std::left << std::endl;
+    }
+    
+    // Get risk profile as string
+    std::string getRiskProfileStr() const {
+        if (riskScore < 30.0) {
+            return "Conservative";
+        } else if (riskScore < 70.0) {
+            return "Moderate";
         } else {
-            analysis += "  Gold is showing higher than usual volatility. Monitor global macro events.\n";
+            return "Aggressive";
         }
-        
-        return analysis;
     }
 };
 
-// Fiat Currency asset (e.g., USD)
-class FiatCurrency : public Asset {
+// Return model for Monte Carlo paths: correlated geometric Brownian motion,
+// or bootstrap resampling of observed joint return vectors
+enum class MonteCarloModel { GBM, Bootstrap };
+
+struct MonteCarloConfig {
+    MonteCarloModel model = MonteCarloModel::GBM;
+    size_t paths = 10000;
+    int months = 120;
+    int checkpointInterval = 12;    // Months between reported percentile bands
+    std::vector<double> percentiles = {5.0, 25.0, 50.0, 75.0, 95.0};
+};
+
+// One simulated position
+struct MonteCarloAsset {
+    SymbolId id;
+    double value;                   // Current market value
+    double annualReturn;            // Percent
+    double annualVolatility;        // Percent
+    double monthlyContribution;     // Added at the end of every month
+};
+
+struct MonteCarloResult {
+    MonteCarloModel model = MonteCarloModel::GBM;   // Model actually used
+    size_t paths = 0;
+    int months = 0;
+    double initialValue = 0.0;
+    double totalContributions = 0.0;
+    std::vector<double> percentiles;
+    std::vector<int> checkpointMonths;
+    std::vector<std::vector<double>> bands;         // [checkpoint][percentile]
+    std::vector<double> terminalValues;             // Sorted ascending
+    double meanTerminal = 0.0;
+    double probabilityOfLoss = 0.0;                 // Terminal value below amount invested
+    double elapsedSeconds = 0.0;
+    
+    // Terminal value at percentile p (0-100)
+    double terminalPercentile(double p) const {
+        if (terminalValues.empty()) return 0.0;
+        size_t index = static_cast<size_t>(std::clamp(p, 0.0, 100.0) / 100.0 * (terminalValues.size() - 1));
+        return terminalValues[index];
+    }
+    
+    // Counts of terminal values in `bins` equal-width buckets over [low, high];
+    // values outside the range land in the end buckets
+    std::vector<size_t> terminalHistogram(size_t bins, double low, double high) const {
+        std::vector<size_t> counts(bins, 0);
+        if (bins == 0 || high <= low) return counts;
+        double scale = bins / (high - low);
+        for (double value : terminalValues) {
+            double bucket = std::clamp((value - low) * scale, 0.0, static_cast<double>(bins - 1));
+            ++counts[static_cast<size_t>(bucket)];
+        }
+        return counts;
+    }
+};
+
+// Monte Carlo simulator for portfolio value over a monthly horizon. Paths
+// are simulated in fixed blocks, each with its own random stream, so results
+// depend only on the seed and never on the thread count. Within a block the
+// state is laid out asset-major with paths contiguous, so each step walks
+// one asset's paths in a single sequential pass.
+class MonteCarloEngine {
 private:
-    std::string country;
-    double interestRate;     // Current interest rate in the country
-    double inflationRate;    // Current inflation rate
+    static constexpr size_t kBlockPaths = 256;
+    
+    std::vector<MonteCarloAsset> assets;
+    std::vector<double> cholesky;   // Lower-triangular factor of the correlation, row-major
+    std::vector<double> shocks;     // Standardised joint returns for bootstrap, one row per sample
+    
+    size_t dimension() const { return assets.size(); }
+    
+    // Factor a correlation matrix, shrinking it toward the identity until it
+    // is positive definite
+    bool factor(std::vector<double> correlation) {
+        size_t n = dimension();
+        for (int attempt = 0; attempt < 20; ++attempt) {
+            std::vector<double> lower(n * n, 0.0);
+            bool ok = true;
+            for (size_t i = 0; i < n && ok; ++i) {
+                for (size_t j = 0; j <= i; ++j) {
+                    double sum = correlation[i * n + j];
+                    for (size_t k = 0; k < j; ++k) {
+                        sum -= lower[i * n + k] * lower[j * n + k];
+                    }
+                    if (i == j) {
+                        if (sum <= 1e-12) {
+                            ok = false;
+                            break;
+                        }
+                        lower[i * n + i] = std::sqrt(sum);
+                    } else {
+                        lower[i * n + j] = sum / lower[j * n + j];
+                    }
+                }
+            }
+            if (ok) {
+                cholesky = std::move(lower);
+                return true;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    if (i != j) correlation[i * n + j] *= 0.9;
+                }
+            }
+        }
+        return false;
+    }
 
 public:
-    FiatCurrency(const std::string& name, const std::string& symbol, double currentPrice,
-                const std::string& country, double interestRate = 0.0, double inflationRate = 0.0,
-                double quantity = 0.0)
-        : Asset(name, symbol, currentPrice, quantity),
-          country(country), interestRate(interestRate), inflationRate(inflationRate) {}
+    explicit MonteCarloEngine(std::vector<MonteCarloAsset> positions) : assets(std::move(positions)) {
+        size_t n = dimension();
+        cholesky.assign(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            cholesky[i * n + i] = 1.0;
+        }
+    }
     
-    // Getters
-    std::string getCountry() const { return country; }
-    double getInterestRate() const { return interestRate; }
-    double getInflationRate() const { return inflationRate; }
+    size_t assetCount() const { return assets.size(); }
+    const std::vector<MonteCarloAsset>& getAssets() const { return assets; }
+    bool hasBootstrapSamples() const { return !shocks.empty(); }
     
-    // Calculate real return (accounting for inflation)
-    double getRealReturn() const {
-        return interestRate - inflationRate;
+    // Correlation between asset returns, row-major n x n; the identity is
+    // kept if the matrix cannot be factored
+    bool setCorrelation(const std::vector<double>& correlation) {
+        if (correlation.size() != dimension() * dimension()) return false;
+        return factor(correlation);
     }
     
-    // Calculate purchasing power after a period
-    double calculatePurchasingPower(int years) const {
-        double realReturnRate = getRealReturn() / 100.0;
-        return getCurrentValue() * std::pow(1 + realReturnRate, years);
+    // Observed joint returns, row-major with one row of n returns per
+    // observation. Each column is standardised, so resampled rows keep their
+    // empirical shape and cross-asset dependence but are rescaled to each
+    // asset's assumed monthly return and volatility.
+    void setBootstrapReturns(const std::vector<double>& jointReturns) {
+        size_t n = dimension();
+        shocks.clear();
+        if (n == 0 || jointReturns.size() < 2 * n) return;
+        size_t samples = jointReturns.size() / n;
+        
+        shocks.assign(jointReturns.begin(), jointReturns.begin() + samples * n);
+        for (size_t a = 0; a < n; ++a) {
+            ReturnStats stats;
+            for (size_t s = 0; s < samples; ++s) {
+                stats.addReturn(shocks[s * n + a]);
+            }
+            double mean = stats.getMean();
+            double stddev = stats.getStdDev();
+            for (size_t s = 0; s < samples; ++s) {
+                shocks[s * n + a] = stddev > 0.0 ? (shocks[s * n + a] - mean) / stddev : 0.0;
+            }
+        }
     }
     
-    // Override display for fiat-specific details
-    void display() const override {
-        Asset::display();
-        std::cout << "  Country: " << country << std::endl;
-        std::cout << "  Interest Rate: " << interestRate << "%" << std::endl;
-        std::cout << "  Inflation Rate: " << inflationRate << "%" << std::endl;
-        std::cout << "  Real Return: " << getRealReturn() << "%" << std::endl;
-        std::cout << "  Purchasing Power (5 years): " 
-                  << Utils::formatCurrency(calculatePurchasingPower(5)) << std::endl;
-        std::cout << std::endl;
+    // Pearson correlation of joint returns (row-major, n per row); assets
+    // with no variation are uncorrelated with everything
+    static std::vector<double> correlationOf(const std::vector<double>& jointReturns, size_t n) {
+        std::vector<double> correlation(n * n, 0.0);
+        size_t samples = n ? jointReturns.size() / n : 0;
+        std::vector<double> mean(n, 0.0);
+        for (size_t s = 0; s < samples; ++s) {
+            for (size_t a = 0; a < n; ++a) mean[a] += jointReturns[s * n + a];
+        }
+        for (size_t a = 0; a < n; ++a) mean[a] /= std::max<size_t>(1, samples);
+        
+        std::vector<double> covariance(n * n, 0.0);
+        for (size_t s = 0; s < samples; ++s) {
+            const double* row = &jointReturns[s * n];
+            for (size_t i = 0; i < n; ++i) {
+                double di = row[i] - mean[i];
+                for (size_t j = 0; j <= i; ++j) {
+                    covariance[i * n + j] += di * (row[j] - mean[j]);
+                }
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            correlation[i * n + i] = 1.0;
+            for (size_t j = 0; j < i; ++j) {
+                double denom = std::sqrt(covariance[i * n + i] * covariance[j * n + j]);
+                double rho = denom > 0.0 ? covariance[i * n + j] / denom : 0.0;
+                correlation[i * n + j] = correlation[j * n + i] = rho;
+            }
+        }
+        return correlation;
     }
     
-    // Override get analysis for fiat-specific analysis
-    std::string getAnalysis() const override {
-        std::string analysis = Asset::getAnalysis();
+    MonteCarloResult run(const MonteCarloConfig& config) const {
+        auto start = std::chrono::steady_clock::now();
+        size_t n = dimension();
+        size_t paths = config.paths;
+        int months = std::max(1, config.months);
+        int interval = std::max(1, config.checkpointInterval);
+        
+        MonteCarloResult result;
+        result.model = (config.model == MonteCarloModel::Bootstrap && !shocks.empty())
+                       ? MonteCarloModel::Bootstrap : MonteCarloModel::GBM;
+        result.paths = paths;
+        result.months = months;
+        result.percentiles = config.percentiles;
+        for (int m = interval; m < months; m += interval) {
+            result.checkpointMonths.push_back(m);
+        }
+        result.checkpointMonths.push_back(months);
+        
+        // Per-asset monthly log drift and volatility; the drift is set so the
+        // expected annual growth equals the assumed annual return
+        std::vector<double> drift(n), sigma(n), contribution(n), initial(n);
+        for (size_t a = 0; a < n; ++a) {
+            double annualReturn = std::max(-0.99, assets[a].annualReturn / 100.0);
+            double annualVolatility = std::max(0.0, assets[a].annualVolatility / 100.0);
+            drift[a] = (std::log1p(annualReturn) - 0.5 * annualVolatility * annualVolatility) / 12.0;
+            sigma[a] = annualVolatility / std::sqrt(12.0);
+            contribution[a] = assets[a].monthlyContribution;
+            initial[a] = assets[a].value;
+            result.initialValue += assets[a].value;
+            result.totalContributions += assets[a].monthlyContribution * months;
+        }
+        if (paths == 0) return result;
         
-        analysis += "  " + name + " has an interest rate of " + std::to_string(interestRate) + 
-                   "% and inflation of " + std::to_string(inflationRate) + "%.\n";
+        size_t checkpoints = result.checkpointMonths.size();
+        std::vector<std::vector<float>> samples(checkpoints, std::vector<float>(paths));
+        result.terminalValues.resize(paths);
         
-        double realReturn = getRealReturn();
-        if (realReturn < 0) {
-            analysis += "  This currency has a negative real return, losing purchasing power over time.\n";
-            analysis += "  Consider alternatives for long-term holdings.\n";
-        } else if (realReturn < 1.0) {
-            analysis += "  This currency is barely maintaining purchasing power.\n";
-        } else {
-            analysis += "  This currency has a positive real return, which is favorable.\n";
+        bool bootstrap = result.model == MonteCarloModel::Bootstrap;
+        size_t shockRows = n ? shocks.size() / n : 0;
+        size_t blocks = (paths + kBlockPaths - 1) / kBlockPaths;
+        const RandomService& service = RandomService::global();
+        
+        ThreadPool::global().parallelFor(0, blocks, 1, [&](size_t blockBegin, size_t blockEnd) {
+            std::vector<double> values(n * kBlockPaths), normals(n * kBlockPaths), shock(n * kBlockPaths);
+            std::vector<double> totals(kBlockPaths);
+            
+            for (size_t block = blockBegin; block < blockEnd; ++block) {
+                size_t first = block * kBlockPaths;
+                size_t lanes = std::min(kBlockPaths, paths - first);
+                RandomStream rng = service.stream(RandomService::Domain::Simulation,
+                                                  static_cast<std::uint32_t>(block));
+                for (size_t a = 0; a < n; ++a) {
+                    std::fill_n(&values[a * kBlockPaths], lanes, initial[a]);
+                }
+                
+                size_t checkpoint = 0;
+                for (int month = 1; month <= months; ++month) {
+                    if (bootstrap) {
+                        for (size_t lane = 0; lane < lanes; ++lane) {
+                            const double* row = &shocks[(rng.nextUInt64() % shockRows) * n];
+                            for (size_t a = 0; a < n; ++a) {
+                                shock[a * kBlockPaths + lane] = row[a];
+                            }
+                        }
+                    } else {
+                        for (size_t a = 0; a < n; ++a) {
+                            rng.fillNormal(&normals[a * kBlockPaths], lanes);
+                        }
+                        for (size_t a = 0; a < n; ++a) {
+                            double* out = &shock[a * kBlockPaths];
+                            std::fill_n(out, lanes, 0.0);
+                            for (size_t j = 0; j <= a; ++j) {
+                                double weight = cholesky[a * n + j];
+                                if (weight == 0.0) continue;
+                                const double* z = &normals[j * kBlockPaths];
+                                for (size_t lane = 0; lane < lanes; ++lane) {
+                                    out[lane] += weight * z[lane];
+                                }
+                            }
+                        }
+                    }
+                    
+                    for (size_t a = 0; a < n; ++a) {
+                        double* value = &values[a * kBlockPaths];
+                        const double* e = &shock[a * kBlockPaths];
+                        const double mu = drift[a], vol = sigma[a], add = contribution[a];
+                        for (size_t lane = 0; lane < lanes; ++lane) {
+                            value[lane] = value[lane] * std::exp(mu + vol * e[lane]) + add;
+                        }
+                    }
+                    
+                    if (month == result.checkpointMonths[checkpoint]) {
+                        std::fill_n(totals.begin(), lanes, 0.0);
+                        for (size_t a = 0; a < n; ++a) {
+                            const double* value = &values[a * kBlockPaths];
+                            for (size_t lane = 0; lane < lanes; ++lane) {
+                                totals[lane] += value[lane];
+                            }
+                        }
+                        for (size_t lane = 0; lane < lanes; ++lane) {
+                            samples[checkpoint][first + lane] = static_cast<float>(totals[lane]);
+                        }
+                        ++checkpoint;
+                    }
+                }
+                std::copy_n(totals.begin(), lanes, &result.terminalValues[first]);
+            }
+        });
+        
+        // Percentile bands per checkpoint, one checkpoint per task
+        result.bands.assign(checkpoints, std::vector<double>(config.percentiles.size(), 0.0));
+        ThreadPool::global().parallelFor(0, checkpoints, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                std::vector<float>& column = samples[c];
+                for (size_t p = 0; p < config.percentiles.size(); ++p) {
+                    double q = std::clamp(config.percentiles[p], 0.0, 100.0) / 100.0;
+                    auto nth = column.begin() + static_cast<std::ptrdiff_t>(q * (paths - 1));
+                    std::nth_element(column.begin(), nth, column.end());
+                    result.bands[c][p] = *nth;
+                }
+            }
+        });
+        
+        std::sort(result.terminalValues.begin(), result.terminalValues.end());
+        double invested = result.initialValue + result.totalContributions;
+        double sum = 0.0;
+        size_t losses = 0;
+        for (double value : result.terminalValues) {
+            sum += value;
+            losses += value < invested;
+        }
+        result.meanTerminal = sum / paths;
+        result.probabilityOfLoss = static_cast<double>(losses) / paths;
+        result.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+
+// Daily closing prices for several symbols on a common calendar, stored
+// row-major (one row of prices per date) so a replay walks memory in order.
+// CSV layout: a header `date,SYMBOL,...` then one `YYYY-MM-DD,price,...`
+// row per day; blank or unparsable cells carry the previous price forward.
+class PriceTable {
+private:
+    std::vector<Date> dates;
+    std::vector<std::int32_t> monthKeys;   // year * 12 + (month - 1), for month and year boundaries
+    std::vector<SymbolId> symbols;
+    std::vector<double> prices;
+
+public:
+    PriceTable(std::vector<Date> rowDates, std::vector<SymbolId> columnSymbols, std::vector<double> rowMajorPrices)
+        : dates(std::move(rowDates)), symbols(std::move(columnSymbols)), prices(std::move(rowMajorPrices)) {
+        monthKeys.reserve(dates.size());
+        for (const Date& date : dates) {
+            int year;
+            unsigned month, day;
+            date.toCivil(year, month, day);
+            monthKeys.push_back(year * 12 + static_cast<std::int32_t>(month) - 1);
+        }
+    }
+    
+    // Load from CSV; nullptr (with a message on stderr) if the file cannot
+    // be read or has no complete rows. Rows are sorted by date and leading
+    // rows are dropped until every column has a price.
+    static std::shared_ptr<const PriceTable> load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Error: cannot open price file " << path << std::endl;
+            return nullptr;
         }
         
-        return analysis;
+        std::string line;
+        if (!std::getline(file, line)) {
+            std::cerr << "Error: price file " << path << " is empty" << std::endl;
+            return nullptr;
+        }
+        std::vector<SymbolId> columns;
+        {
+            std::stringstream header(line);
+            std::string cell;
+            std::getline(header, cell, ',');   // Date column
+            while (std::getline(header, cell, ',')) {
+                cell.erase(std::remove_if(cell.begin(), cell.end(), ::isspace), cell.end());
+                columns.push_back(SymbolTable::global().intern(cell));
+            }
+        }
+        if (columns.empty()) {
+            std::cerr << "Error: price file " << path << " has no symbol columns" << std::endl;
+            return nullptr;
+        }
+        
+        size_t n = columns.size();
+        std::vector<std::pair<Date, std::vector<double>>> rows;
+        std::vector<double> last(n, std::numeric_limits<double>::quiet_NaN());
+        while (std::getline(file, line)) {
+            if (line.empty() || line == "\r") continue;
+            std::stringstream row(line);
+            std::string cell;
+            std::getline(row, cell, ',');
+            std::int64_t timestamp = Utils::parseDate(cell);
+            if (timestamp == 0 && cell.rfind("1970-01-01", 0) != 0) continue;
+            
+            std::vector<double> values(n, std::numeric_limits<double>::quiet_NaN());
+            for (size_t j = 0; j < n && std::getline(row, cell, ','); ++j) {
+                char* end = nullptr;
+                double value = std::strtod(cell.c_str(), &end);
+                if (end != cell.c_str() && value > 0.0) values[j] = value;
+            }
+            rows.emplace_back(Date{static_cast<std::int32_t>(timestamp / 86400)}, std::move(values));
+        }
+        std::stable_sort(rows.begin(), rows.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        
+        std::vector<Date> dates;
+        std::vector<double> prices;
+        for (auto& [date, values] : rows) {
+            bool complete = true;
+            for (size_t j = 0; j < n; ++j) {
+                if (std::isnan(values[j])) values[j] = last[j];
+                else last[j] = values[j];
+                complete = complete && !std::isnan(values[j]);
+            }
+            if (!complete) continue;
+            dates.push_back(date);
+            prices.insert(prices.end(), values.begin(), values.end());
+        }
+        if (dates.empty()) {
+            std::cerr << "Error: price file " << path << " has no complete rows" << std::endl;
+            return nullptr;
+        }
+        return std::make_shared<const PriceTable>(std::move(dates), std::move(columns), std::move(prices));
+    }
+    
+    size_t rows() const { return dates.size(); }
+    size_t columns() const { return symbols.size(); }
+    const Date& dateAt(size_t row) const { return dates[row]; }
+    std::int32_t monthKeyAt(size_t row) const { return monthKeys[row]; }
+    SymbolId symbolAt(size_t column) const { return symbols[column]; }
+    const double* row(size_t index) const { return &prices[index * symbols.size()]; }
+    double price(size_t row, size_t column) const { return prices[row * symbols.size() + column]; }
+    
+    // Column of a symbol, or -1 if it is not in the table
+    int columnOf(SymbolId id) const {
+        auto it = std::find(symbols.begin(), symbols.end(), id);
+        return it == symbols.end() ? -1 : static_cast<int>(it - symbols.begin());
     }
 };
 
-// Market Data Fetcher class to get live market data
-class MarketDataFetcher {
-private:
-    std::string apiKey;
-    std::map<std::string, double> lastFetchedPrices;
-    std::mutex priceMutex;
+// One set of strategy parameters for a backtest
+struct BacktestConfig {
+    double initialCapital = 10000.0;
+    double monthlyAmount = 500.0;       // SIP contribution on the first trading day of each month
+    double driftThreshold = 5.0;        // Percentage points off target before rebalancing
+    double riskScore = 50.0;            // Selects RiskAnalyzer target allocation
+    double transactionCost = 0.1;       // Percent of traded value
+    bool recordEquityCurve = false;
+};
+
+struct BacktestResult {
+    BacktestConfig config;
+    double finalValue = 0.0;
+    double totalContributed = 0.0;      // Initial capital plus all contributions
+    double annualizedReturn = 0.0;      // Time-weighted, percent
+    double annualizedVolatility = 0.0;  // Percent
+    double maxDrawdown = 0.0;           // Percent, time-weighted
+    double sharpeRatio = 0.0;
+    int rebalances = 0;
+    double tradedValue = 0.0;
+    double costs = 0.0;
+    std::vector<double> equityCurve;    // Portfolio value per row, if recorded
+};
 
-    // Initialize cURL
-    CURL* initCurl() {
-        CURL* curl = curl_easy_init();
-        if (curl) {
-            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+// Replays a price table through SIP contributions and drift-threshold
+// rebalancing to RiskAnalyzer targets over the table's columns plus "USD",
+// which is held as cash. Returns are time-weighted (unit value), so
+// contributions do not count as performance.
+class Backtester {
+private:
+    std::shared_ptr<const PriceTable> prices;
+    double riskFreeRate;   // Annual, percent
+    
+    // Target weights per column with cash in the last slot
+    std::vector<double> targetWeights(double riskScore) const {
+        size_t n = prices->columns();
+        std::vector<double> weights(n + 1, 0.0);
+        SymbolId cash = SymbolTable::global().intern("USD");
+        
+        // Priors come from the asset class each column would be held as
+        AssetMap universe;
+        for (size_t column = 0; column < n; ++column) {
+            SymbolId id = prices->symbolAt(column);
+            universe[id] = AssetFactory::create(SymbolTable::global().name(id), prices->price(0, column),
+                                                0.0, riskFreeRate, 0.0);
         }
-        return curl;
-    }
-
-    // Fetch data from API
-    std::string fetchFromAPI(const std::string& url) {
-        CURL* curl = initCurl();
-        std::string responseData;
-        
-        if (!curl) {
-            std::cerr << "Failed to initialize cURL" << std::endl;
-            return "";
+        if (!universe.find(cash)) {
+            universe[cash] = AssetFactory::create("USD", 1.0, 0.0, riskFreeRate, 0.0);
         }
+        RiskAnalyzer analyzer(riskScore);
+        analyzer.setUniverse(universe);
         
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, Utils::WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseData);
-        
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            std::cerr << "cURL error: " << curl_easy_strerror(res) << std::endl;
-            curl_easy_cleanup(curl);
-            return "";
+        double total = 0.0;
+        for (const auto& [id, percentage] : analyzer.getIdealAllocation()) {
+            int column = prices->columnOf(id);
+            if (column >= 0) {
+                weights[column] += percentage;
+            } else if (id == cash) {
+                weights[n] += percentage;
+            } else {
+                continue;
+            }
+            total += percentage;
         }
-        
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-        if (http_code != 200) {
-            std::cerr << "HTTP error: " << http_code << std::endl;
-            curl_easy_cleanup(curl);
-            return "";
+        for (double& weight : weights) {
+            weight = total > 0.0 ? weight / total : 0.0;
         }
-        
-        curl_easy_cleanup(curl);
-        return responseData;
+        if (total <= 0.0) weights[n] = 1.0;
+        return weights;
     }
     
-    // Parse JSON for asset price
-    double extractPriceFromJSON(const std::string& jsonStr, const std::string& assetSymbol) {
-        try {
-            json j = json::parse(jsonStr);
+    BacktestResult replay(const BacktestConfig& config, const std::vector<double>& weights) const {
+        const PriceTable& table = *prices;
+        size_t n = table.columns();
+        size_t rows = table.rows();
+        double threshold = config.driftThreshold / 100.0;
+        double costRate = config.transactionCost / 100.0;
+        
+        BacktestResult result;
+        result.config = config;
+        if (config.recordEquityCurve) result.equityCurve.reserve(rows);
+        
+        std::vector<double> quantities(n, 0.0);
+        double cash = 0.0;
+        double units = 0.0;
+        double unitValue = 1.0;
+        double peakUnitValue = 1.0;
+        ReturnStats dailyReturns;
+        
+        for (size_t i = 0; i < rows; ++i) {
+            const double* p = table.row(i);
             
-            // Different APIs might have different JSON structures
-            // This is a simplified example - real implementation would need to handle various API formats
-            if (j.contains("price")) {
-                return j["price"].get<double>();
-            } else if (j.contains("rates") && j["rates"].contains(assetSymbol)) {
-                return j["rates"][assetSymbol].get<double>();
-            } else if (j.contains("data") && j["data"].contains("last")) {
-                return j["data"]["last"].get<double>();
-            } else if (j.contains("ticker") && j["ticker"].contains("price")) {
-                return j["ticker"]["price"].get<double>();
-            } else {
-                // For demonstration, return a simulated price if we can't find it in JSON
-                return simulatePrice(assetSymbol);
+            double contribution = 0.0;
+            if (i == 0) {
+                contribution = config.initialCapital;
+            } else if (table.monthKeyAt(i) != table.monthKeyAt(i - 1)) {
+                contribution = config.monthlyAmount;
+            }
+            
+            double value = cash;
+            for (size_t a = 0; a < n; ++a) {
+                value += quantities[a] * p[a];
+            }
+            if (i > 0 && units > 0.0) {
+                double previous = unitValue;
+                unitValue = value / units;
+                dailyReturns.addReturn(unitValue / previous - 1.0);
+            }
+            
+            // Contributions buy units at the pre-contribution unit value and
+            // are invested at target weights
+            if (contribution > 0.0) {
+                units += contribution / unitValue;
+                for (size_t a = 0; a < n; ++a) {
+                    quantities[a] += contribution * weights[a] / p[a];
+                }
+                cash += contribution * weights[n];
+                value += contribution;
+                result.totalContributed += contribution;
+            }
+            
+            // Rebalance everything back to target once any sleeve drifts too far
+            if (value > 0.0) {
+                double drift = std::abs(cash / value - weights[n]);
+                for (size_t a = 0; a < n; ++a) {
+                    drift = std::max(drift, std::abs(quantities[a] * p[a] / value - weights[a]));
+                }
+                if (drift >= threshold) {
+                    double traded = std::abs(cash - value * weights[n]);
+                    for (size_t a = 0; a < n; ++a) {
+                        traded += std::abs(quantities[a] * p[a] - value * weights[a]);
+                    }
+                    traded *= 0.5;   // Each dollar moved is one sale and one purchase
+                    double cost = traded * costRate;
+                    value -= cost;
+                    for (size_t a = 0; a < n; ++a) {
+                        quantities[a] = value * weights[a] / p[a];
+                    }
+                    cash = value * weights[n];
+                    
+                    ++result.rebalances;
+                    result.tradedValue += traded;
+                    result.costs += cost;
+                    if (units > 0.0) unitValue = value / units;
+                }
             }
-        } catch (const std::exception& e) {
-            std::cerr << "JSON parsing error: " << e.what() << std::endl;
-            return simulatePrice(assetSymbol);
+            
+            peakUnitValue = std::max(peakUnitValue, unitValue);
+            result.maxDrawdown = std::max(result.maxDrawdown, (1.0 - unitValue / peakUnitValue) * 100.0);
+            if (config.recordEquityCurve) result.equityCurve.push_back(value);
+            result.finalValue = value;
         }
-    }
-    
-    // Simulate price for demonstration or when API fails
-    double simulatePrice(const std::string& symbol) {
-        // Base prices for simulation
-        std::map<std::string, double> basePrices = {
-            {"BTC", 40000.0},
-            {"ETH", 2000.0},
-            {"EUR/USD", 1.10},
-            {"USD/INR", 75.0},
-            {"GBP/USD", 1.35},
-            {"XAU/USD", 1800.0},
-            {"USD", 1.0},
-            {"VTI", 200.0},
-            {"VOO", 380.0}
-        };
         
-        // If we already have a price for this symbol, apply some random variation
-        std::lock_guard<std::mutex> lock(priceMutex);
-        if (lastFetchedPrices.find(symbol) != lastFetchedPrices.end()) {
-            double lastPrice = lastFetchedPrices[symbol];
-            double newPrice = Utils::simulateVolatility(lastPrice);
-            lastFetchedPrices[symbol] = newPrice;
-            return newPrice;
+        double years = rows > 1 ? (table.dateAt(rows - 1).days - table.dateAt(0).days) / 365.25 : 0.0;
+        if (years > 0.0) {
+            double periodsPerYear = (rows - 1) / years;
+            result.annualizedReturn = (std::pow(unitValue, 1.0 / years) - 1.0) * 100.0;
+            result.annualizedVolatility = dailyReturns.getStdDev() * std::sqrt(periodsPerYear) * 100.0;
+            if (result.annualizedVolatility > 0.0) {
+                result.sharpeRatio = (result.annualizedReturn - riskFreeRate) / result.annualizedVolatility;
+            }
         }
-        
-        // Otherwise use base price or generate one
-        double basePrice = (basePrices.find(symbol) != basePrices.end()) ? 
-                           basePrices[symbol] : 100.0;
-        double newPrice = Utils::simulateVolatility(basePrice);
-        lastFetchedPrices[symbol] = newPrice;
-        return newPrice;
+        return result;
     }
 
 public:
-    MarketDataFetcher(const std::string& apiKey = "") : apiKey(apiKey) {
-        // Initialize cURL globally
-        curl_global_init(CURL_GLOBAL_ALL);
-    }
+    explicit Backtester(std::shared_ptr<const PriceTable> priceTable, double riskFreeRate = 0.5)
+        : prices(std::move(priceTable)), riskFreeRate(riskFreeRate) {}
     
-    ~MarketDataFetcher() {
-        // Clean up cURL
-        curl_global_cleanup();
-    }
+    const PriceTable& getPrices() const { return *prices; }
     
-    // Get price for a specific asset
-    double getPrice(const std::string& symbol, bool useRealAPI = false) {
-        if (useRealAPI) {
-            // Use different APIs based on asset type
-            std::string apiUrl;
-            
-            if (symbol == "BTC" || symbol == "ETH") {
-                // Cryptocurrency API (CoinGecko example)
-                apiUrl = "https://api.coingecko.com/api/v3/simple/price?ids=" + 
-                         (symbol == "BTC" ? "bitcoin" : "ethereum") + 
-                         "&vs_currencies=usd";
-            } else if (symbol == "XAU/USD") {
-                // Gold price API
-                apiUrl = "https://forex-data-feed.swissquote.com/public-quotes/bboquotes/instrument/XAU/USD";
-            } else if (symbol.find('/') != std::string::npos) {
-                // Forex API
-                apiUrl = "https://api.exchangerate-api.com/v4/latest/" + symbol.substr(0, 3);
-            } else {
-                // Stock/ETF API
-                apiUrl = "https://finnhub.io/api/v1/quote?symbol=" + symbol + "&token=" + apiKey;
-            }
-            
-            std::string response = fetchFromAPI(apiUrl);
-            return extractPriceFromJSON(response, symbol);
-        } else {
-            // Use simulated prices for demonstration
-            return simulatePrice(symbol);
-        }
+    BacktestResult run(const BacktestConfig& config) const {
+        return replay(config, targetWeights(config.riskScore));
     }
     
-    // Update multiple prices at once
-    std::map<std::string, double> updatePrices(const std::vector<std::string>& symbols, bool useRealAPI = false) {
-        std::map<std::string, double> updatedPrices;
-        
-        for (const auto& symbol : symbols) {
-            double price = getPrice(symbol, useRealAPI);
-            
-            std::lock_guard<std::mutex> lock(priceMutex);
-            lastFetchedPrices[symbol] = price;
-            updatedPrices[symbol] = price;
+    // Run every configuration across the thread pool; results keep the
+    // order of `configs`
+    std::vector<BacktestResult> sweep(const std::vector<BacktestConfig>& configs) const {
+        // Target weights depend only on the risk score; resolve them up front
+        std::map<double, std::vector<double>> targets;
+        for (const BacktestConfig& config : configs) {
+            if (targets.find(config.riskScore) == targets.end()) {
+                targets[config.riskScore] = targetWeights(config.riskScore);
+            }
         }
         
-        return updatedPrices;
+        std::vector<BacktestResult> results(configs.size());
+        ThreadPool::global().parallelFor(0, configs.size(), 8, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                results[i] = replay(configs[i], targets.at(configs[i].riskScore));
+            }
+        });
+        return results;
     }
+};
+
+// One position change in the transaction journal
+struct JournalRecord {
+    enum class Type : std::uint8_t { Buy = 1, Sell, SipRun, Rebalance };
     
-    // Get volatility index (VIX) - simulated
-    double getVIX() {
-        return simulatePrice("VIX");
+    Type type = Type::Buy;
+    std::uint64_t sequence = 0;    // Assigned by the journal, strictly increasing
+    std::string symbol;            // Buy, Sell
+    double amount = 0.0;           // Buy: cash invested; Sell: percentage of the position,
+                                   // or quantity when selling a specific lot
+    double price = 0.0;            // Buy, Sell: execution price
+    std::int64_t timestampMs = 0;  // Buy, Sell: trade time; SipRun: time of the investment
+    Date date;                     // Rebalance: day of the rebalance
+    LotLedger::Relief relief = LotLedger::Relief::FIFO;  // Sell: lots relieved
+    std::uint32_t lot = 0;         // Sell with Specific relief: the lot sold
+};
+
+// Append-only write-ahead journal: a 64-byte header, then records framed as
+// [u32 length][payload][u64 checksum]. append() only encodes into memory;
+// sync() writes and fsyncs everything appended so far, and concurrent
+// callers share one write and one fsync (group commit). A torn record at
+// the tail, left by a crash mid-write, is cut off when the journal opens.
+class TransactionJournal {
+public:
+    struct Stats {
+        std::uint64_t records = 0;
+        std::uint64_t syncs = 0;
+        std::uint64_t bytes = 0;
+    };
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t baseSequence;  // Records up to here were checkpointed away
+        std::uint8_t reserved[40];
+    };
+    static_assert(sizeof(Header) == 64, "TransactionJournal header must stay 64 bytes");
+    
+    static constexpr char kMagic[8] = {'F', 'A', 'J', 'O', 'U', 'R', 'N', '\0'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kByteOrder = 0x01020304;
+    
+    std::string path;
+    int fd;
+    Header header;
+    std::mutex mutex;
+    std::condition_variable flushed;
+    BinaryWriter scratch;
+    std::string pending;              // Encoded records not yet written
+    std::uint64_t lastSequence;       // Highest sequence appended
+    std::uint64_t durableSequence;    // Highest sequence on stable storage
+    bool flushing = false;
+    bool failed = false;
+    Stats stats;
+    
+    TransactionJournal(const std::string& path, int fd, const Header& header, std::uint64_t lastSequence)
+        : path(path), fd(fd), header(header), lastSequence(lastSequence), durableSequence(lastSequence) {}
+    
+    static void encode(BinaryWriter& out, const JournalRecord& record) {
+        out.put<std::uint8_t>(static_cast<std::uint8_t>(record.type));
+        out.put(record.sequence);
+        out.put(record.amount);
+        out.put(record.price);
+        out.put(record.timestampMs);
+        out.put(record.date.days);
+        out.putString(record.symbol);
+        out.put<std::uint8_t>(static_cast<std::uint8_t>(record.relief));
+        out.put(record.lot);
     }
     
-    // Get economic indicators - simulated
-    double getInflationRate(const std::string& country = "US") {
-        // Simulated inflation rates
-        std::map<std::string, double> inflationRates = {
-            {"US", 2.5},
-            {"EU", 2.0},
-            {"UK", 3.0},
-            {"IN", 5.5},
-            {"JP", 0.5}
-        };
-        
-        return inflationRates.find(country) != inflationRates.end() ? 
-               inflationRates[country] : 2.0;
+    static bool decode(const char* data, size_t size, JournalRecord& record) {
+        BinaryReader in(data, size);
+        std::uint8_t type = in.get<std::uint8_t>();
+        record.sequence = in.get<std::uint64_t>();
+        record.amount = in.get<double>();
+        record.price = in.get<double>();
+        record.timestampMs = in.get<std::int64_t>();
+        record.date.days = in.get<std::int32_t>();
+        record.symbol = in.getString();
+        
+        // Lot fields were added later; records written before them sell FIFO
+        record.relief = LotLedger::Relief::FIFO;
+        record.lot = 0;
+        if (!in.atEnd()) {
+            std::uint8_t relief = in.get<std::uint8_t>();
+            record.lot = in.get<std::uint32_t>();
+            if (relief > static_cast<std::uint8_t>(LotLedger::Relief::Specific)) return false;
+            record.relief = static_cast<LotLedger::Relief>(relief);
+        }
+        if (type < static_cast<std::uint8_t>(JournalRecord::Type::Buy) ||
+            type > static_cast<std::uint8_t>(JournalRecord::Type::Rebalance)) {
+            return false;
+        }
+        record.type = static_cast<JournalRecord::Type>(type);
+        return in.ok() && in.atEnd();
     }
     
-    // Get interest rate - simulated
-    double getInterestRate(const std::string& country = "US") {
-        // Simulated interest rates
-        std::map<std::string, double> interestRates = {
-            {"US", 0.5},
-            {"EU", 0.0},
-            {"UK", 0.75},
-            {"IN", 4.5},
-            {"JP", -0.1}
-        };
-        
-        return interestRates.find(country) != interestRates.end() ? 
-               interestRates[country] : 0.5;
+    // Walk the framed records in [data, data + size); stops at the first
+    // frame that is short or fails its checksum and returns the bytes that
+    // were intact
+    template <typename Fn>
+    static size_t scan(const char* data, size_t size, Fn&& fn) {
+        size_t offset = 0;
+        JournalRecord record;
+        while (size - offset >= sizeof(std::uint32_t)) {
+            std::uint32_t length;
+            std::memcpy(&length, data + offset, sizeof(length));
+            size_t frame = sizeof(length) + length + sizeof(std::uint64_t);
+            if (size - offset < frame) break;
+            
+            const char* payload = data + offset + sizeof(length);
+            std::uint64_t checksum;
+            std::memcpy(&checksum, payload + length, sizeof(checksum));
+            if (Utils::checksum64(payload, length, length) != checksum || !decode(payload, length, record)) break;
+            fn(record);
+            offset += frame;
+        }
+        return offset;
     }
-};
-
-// SIP Manager to handle systematic investment plans
-class SIPManager {
-private:
-    double monthlyAmount;
-    std::map<std::string, double> allocation; // Asset symbol to percentage allocation
-    std::chrono::system_clock::time_point lastInvestmentDate;
-    bool autoInvest;
 
 public:
-    SIPManager(double monthlyAmount = 0.0, bool autoInvest = true)
-        : monthlyAmount(monthlyAmount), autoInvest(autoInvest) {
-        // Initialize last investment date to current time
-        lastInvestmentDate = std::chrono::system_clock::now();
-    }
+    TransactionJournal(const TransactionJournal&) = delete;
+    TransactionJournal& operator=(const TransactionJournal&) = delete;
     
-    // Set monthly investment amount
-    void setMonthlyAmount(double amount) {
-        monthlyAmount = amount;
+    ~TransactionJournal() {
+        sync();
+#ifndef _WIN32
+        if (fd >= 0) close(fd);
+#endif
     }
     
-    // Set allocation percentages
-    void setAllocation(const std::map<std::string, double>& newAllocation) {
-        // Validate that percentages add up to 100%
-        double total = 0.0;
-        for (const auto& [symbol, percentage] : newAllocation) {
-            total += percentage;
+    // Open (or create) the journal at `path`; returns nullptr on failure
+    static std::unique_ptr<TransactionJournal> open(const std::string& path) {
+#ifdef _WIN32
+        std::cerr << "Transaction journal not supported on this platform: " << path << std::endl;
+        return nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::cerr << "Failed to open transaction journal: " << path << std::endl;
+            if (fd >= 0) close(fd);
+            return nullptr;
         }
         
-        if (std::abs(total - 100.0) > 0.01) {
-            std::cerr << "Warning: Allocation percentages do not add up to 100%. Adjusting..." << std::endl;
-            
-            // Adjust proportionally
-            allocation.clear();
-            for (const auto& [symbol, percentage] : newAllocation) {
-                allocation[symbol] = (percentage / total) * 100.0;
+        Header header{};
+        std::uint64_t lastSequence = 0;
+        size_t end = sizeof(Header);
+        if (static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = kVersion;
+            header.byteOrder = kByteOrder;
+            if (pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                ftruncate(fd, sizeof(Header)) != 0 || fsync(fd) != 0) {
+                std::cerr << "Failed to initialize transaction journal: " << path << std::endl;
+                close(fd);
+                return nullptr;
             }
         } else {
-            allocation = newAllocation;
+            if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+                header.version != kVersion || header.byteOrder != kByteOrder) {
+                std::cerr << "Invalid transaction journal: " << path << std::endl;
+                close(fd);
+                return nullptr;
+            }
+            
+            lastSequence = header.baseSequence;
+            size_t size = static_cast<size_t>(st.st_size);
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                std::cerr << "Failed to map transaction journal: " << path << std::endl;
+                close(fd);
+                return nullptr;
+            }
+            const char* records = static_cast<const char*>(mapping) + sizeof(Header);
+            end += scan(records, size - sizeof(Header), [&](const JournalRecord& record) {
+                lastSequence = std::max(lastSequence, record.sequence);
+            });
+            munmap(mapping, size);
+            
+            if (end < size && ftruncate(fd, static_cast<off_t>(end)) != 0) {
+                std::cerr << "Failed to cut torn tail of transaction journal: " << path << std::endl;
+                close(fd);
+                return nullptr;
+            }
         }
-    }
-    
-    // Check if it's time for the next investment
-    bool isTimeForInvestment() const {
-        auto now = std::chrono::system_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::hours>(now - lastInvestmentDate);
         
-        // Simplified: Consider a month as 30 days
-        return duration.count() >= 30 * 24;
+        if (lseek(fd, static_cast<off_t>(end), SEEK_SET) < 0) {
+            close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<TransactionJournal>(new TransactionJournal(path, fd, header, lastSequence));
+#endif
     }
     
-    // Execute the monthly investment
-    std::map<std::string, double> executeInvestment(bool force = false) {
-        if (!force && !isTimeForInvestment()) {
-            return {};
-        }
-        
-        std::map<std::string, double> investments;
-        
-        for (const auto& [symbol, percentage] : allocation) {
-            double amount = monthlyAmount * (percentage / 100.0);
-            investments[symbol] = amount;
+    // Visit every durable record with a sequence above `afterSequence`,
+    // oldest first
+    template <typename Fn>
+    size_t replay(std::uint64_t afterSequence, Fn&& fn) {
+        sync();
+        size_t applied = 0;
+#ifndef _WIN32
+        std::lock_guard<std::mutex> lock(mutex);
+        off_t size = lseek(fd, 0, SEEK_END);
+        if (size <= static_cast<off_t>(sizeof(Header))) return 0;
+        void* mapping = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Failed to map transaction journal: " << path << std::endl;
+            return 0;
         }
-        
-        // Update last investment date
-        lastInvestmentDate = std::chrono::system_clock::now();
-        
-        return investments;
+        const char* records = static_cast<const char*>(mapping) + sizeof(Header);
+        scan(records, static_cast<size_t>(size) - sizeof(Header), [&](const JournalRecord& record) {
+            if (record.sequence > afterSequence) {
+                fn(record);
+                ++applied;
+            }
+        });
+        munmap(mapping, static_cast<size_t>(size));
+#else
+        (void)afterSequence;
+        (void)fn;
+#endif
+        return applied;
     }
     
-    // Simulate multiple months of investments
-    std::map<std::string, std::vector<double>> simulateInvestments(int months) {
-        std::map<std::string, std::vector<double>> simulatedInvestments;
-        
-        for (int i = 0; i < months; ++i) {
-            auto monthlyInvestments = executeInvestment(true);
+    // Buffer a record and assign its sequence; durable after the next sync()
+    std::uint64_t append(JournalRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        record.sequence = ++lastSequence;
+        scratch.clear();
+        encode(scratch, record);
+        
+        const std::string& payload = scratch.data();
+        std::uint32_t length = static_cast<std::uint32_t>(payload.size());
+        std::uint64_t checksum = Utils::checksum64(payload.data(), length, length);
+        pending.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        pending += payload;
+        pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        ++stats.records;
+        return record.sequence;
+    }
+    
+    // Make every record appended so far durable. The first caller to find
+    // no flush in progress writes the whole pending buffer and fsyncs once;
+    // callers arriving meanwhile wait and are covered by the next flush.
+    bool sync() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::uint64_t target = lastSequence;
+        while (durableSequence < target && !failed) {
+            if (flushing) {
+                flushed.wait(lock);
+                continue;
+            }
             
-            for (const auto& [symbol, amount] : monthlyInvestments) {
-                simulatedInvestments[symbol].push_back(amount);
+            flushing = true;
+            std::string batch;
+            batch.swap(pending);
+            std::uint64_t upTo = lastSequence;
+            lock.unlock();
+#ifdef _WIN32
+            bool written = false;
+#else
+            bool written = Utils::writeAll(fd, batch.data(), batch.size()) && fdatasync(fd) == 0;
+#endif
+            lock.lock();
+            flushing = false;
+            if (written) {
+                durableSequence = upTo;
+                ++stats.syncs;
+                stats.bytes += batch.size();
+            } else {
+                std::cerr << "Failed to write transaction journal: " << path << std::endl;
+                failed = true;
             }
+            flushed.notify_all();
         }
-        
-        return simulatedInvestments;
-    }
-    
-    // Calculate projected growth of SIP over time
-    double calculateProjectedGrowth(int months, double annualReturnRate) {
-        double monthlyRate = annualReturnRate / 12.0 / 100.0;
-        double futureValue = 0.0;
-        
-        // Using SIP compound interest formula: P * ((1 + r)^n - 1) / r * (1 + r)
-        futureValue = monthlyAmount * ((std::pow(1 + monthlyRate, months) - 1) / monthlyRate) * (1 + monthlyRate);
-        
-        return futureValue;
+        return durableSequence >= target;
     }
     
-    // Get allocation
-    const std::map<std::string, double>& getAllocation() const {
-        return allocation;
+    // Continue numbering after `sequence`, e.g. when a saved state is newer
+    // than anything left in this journal
+    void skipTo(std::uint64_t sequence) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sequence > lastSequence && pending.empty()) {
+            lastSequence = durableSequence = sequence;
+        }
     }
     
-    // Get monthly amount
-    double getMonthlyAmount() const {
-        return monthlyAmount;
+    // Drop records already covered by a saved state up to `sequence`;
+    // later sequences keep counting from there
+    bool checkpoint(std::uint64_t sequence) {
+        if (!sync()) return false;
+#ifdef _WIN32
+        (void)sequence;
+        return false;
+#else
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sequence < lastSequence) return false;
+        header.baseSequence = sequence;
+        if (pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            ftruncate(fd, sizeof(Header)) != 0 || lseek(fd, sizeof(Header), SEEK_SET) < 0 || fsync(fd) != 0) {
+            std::cerr << "Failed to checkpoint transaction journal: " << path << std::endl;
+            return false;
+        }
+        return true;
+#endif
     }
     
-    // Toggle auto-invest
-    void toggleAutoInvest() {
-        autoInvest = !autoInvest;
+    // Getters
+    const std::string& getPath() const { return path; }
+    // True once a write or fsync failed; nothing appended after that is durable
+    bool hasFailed() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
     }
-    
-    // Get auto-invest status
-    bool getAutoInvestStatus() const {
-        return autoInvest;
+    std::uint64_t getLastSequence() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lastSequence;
     }
-    
-    // Display SIP details
-    void display() const {
-        std::cout << "\n========== SIP MANAGER ==========\n" << std::endl;
-        std::cout << "Monthly Investment: " << Utils::formatCurrency(monthlyAmount) << std::endl;
-        std::cout << "Auto-Invest: " << (autoInvest ? "Enabled" : "Disabled") << std::endl;
-        std::cout << "Current Allocation:" << std::endl;
-        
-        for (const auto& [symbol, percentage] : allocation) {
-            std::cout << "  " << symbol << ": " << percentage << "%" << std::endl;
-        }
-        
-        std::cout << "\nProjected Growth (10% annual return):" << std::endl;
-        std::cout << "  1 Year: " << Utils::formatCurrency(calculateProjectedGrowth(12, 10.0)) << std::endl;
-        std::cout << "  5 Years: " << Utils::formatCurrency(calculateProjectedGrowth(60, 10.0)) << std::endl;
-        std::cout << "  10 Years: " << Utils::formatCurrency(calculateProjectedGrowth(120, 10.0)) << std::endl;
-        std::cout << "  20 Years: " << Utils::formatCurrency(calculateProjectedGrowth(240, 10.0)) << std::endl;
-        
-        std::cout << std::endl;
+    Stats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
     }
 };
 
-// Risk Analyzer class to assess portfolio risk
-class RiskAnalyzer {
+// Portfolio Manager class to manage all assets
+class PortfolioManager {
 private:
-    double riskScore; // 0-100 (0 = lowest risk, 100 = highest risk)
-    std::map<std::string, double> idealAllocation; // Based on risk score
-    double volatilityThreshold; // Threshold for considering an asset volatile
-
-public:
-    RiskAnalyzer(double riskScore = 50.0, double volatilityThreshold = 15.0)
-        : riskScore(riskScore), volatilityThreshold(volatilityThreshold) {
-        updateIdealAllocation();
-    }
-    
-    // Set risk score and update ideal allocation
-    void setRiskScore(double newRiskScore) {
-        riskScore = std::min(100.0, std::max(0.0, newRiskScore));
-        updateIdealAllocation();
-    }
-    
-    // Get risk score
-    double getRiskScore() const {
-        return riskScore;
-    }
+    AssetMap assets;
+    HoldingsTable holdings; // SoA mirror of `assets`, refreshed whenever an asset changes
+    CovarianceEngine covariance; // Rolling covariance of asset returns, one sample per price update
+    DailyReturns dailyReturns; // Close-to-close daily returns behind VaR
+    RiskAnalyzer riskAnalyzer;
+    MarketDataFetcher dataFetcher;
+    std::unique_ptr<MarketDataSource> marketData; // Feeds updatePrices(); simulated by default
+    MarketBatch batch; // Reused across updates
+    SIPManager sipManager;
+    std::vector<std::pair<Date, double>> historicalValues; // Date, Total Value
+    double initialInvestment;
+    std::optional<Date> lastRebalanceDate;
+    std::string archiveDirectory; // Per-symbol price archives, empty = disabled
+    mutable std::shared_ptr<const PortfolioSnapshot> lastSnapshot; // Reused until the holdings change
+    std::unique_ptr<TransactionJournal> journal; // Write-ahead record of position changes, optional
+    std::uint64_t journalSequence = 0; // Last journal record reflected in this state
+    int journalBatchDepth = 0;
     
-    // Update ideal allocation based on risk score
-    void updateIdealAllocation() {
-        // Clear previous allocation
-        idealAllocation.clear();
-        
-        if (riskScore < 30.0) {
-            // Low risk
-            idealAllocation["SIP"] = 60.0;
-            idealAllocation["USD"] = 20.0;
-            idealAllocation["XAU/USD"] = 10.0;
-            idealAllocation["EUR/USD"] = 5.0;
-            idealAllocation["BTC"] = 5.0;
-        } else if (riskScore < 70.0) {
-            // Medium risk
-            idealAllocation["SIP"] = 40.0;
-            idealAllocation["EUR/USD"] = 20.0;
-            idealAllocation["BTC"] = 15.0;
-            idealAllocation["XAU/USD"] = 15.0;
-            idealAllocation["USD"] = 10.0;
-        } else {
-            // High risk
-            idealAllocation["SIP"] = 20.0;
-            idealAllocation["EUR/USD"] = 30.0;
-            idealAllocation["BTC"] = 30.0;
-            idealAllocation["XAU/USD"] = 10.0;
-            idealAllocation["USD"] = 10.0;
+    static constexpr size_t kMinCorrelationSamples = 30; // Joint returns needed to trust history
+
+    // Journal a change before it is applied; outside a JournalBatch it is
+    // made durable immediately. False if it could not be, in which case
+    // the caller must leave the portfolio unchanged.
+    bool journalChange(JournalRecord& record) {
+        if (!journal) return true;
+        if (!journal->hasFailed()) {
+            std::uint64_t sequence = journal->append(record);
+            if (journalBatchDepth > 0 || journal->sync()) {
+                journalSequence = sequence;
+                return true;
+            }
         }
+        std::cerr << "Change not applied: journal " << journal->getPath() << " is not writable" << std::endl;
+        return false;
     }
     
-    // Get ideal allocation
-    const std::map<std::string, double>& getIdealAllocation() const {
-        return idealAllocation;
-    }
-    
-    // Calculate portfolio volatility
-    double calculatePortfolioVolatility(const std::map<std::string, std::shared_ptr<Asset>>& assets) {
-        double totalValue = 0.0;
-        double weightedVolatility = 0.0;
+    // Re-apply one journaled change without journaling it again
+    void applyJournalRecord(const JournalRecord& record) {
+        SymbolId id;
+        std::shared_ptr<Asset>* asset = nullptr;
+        if (!record.symbol.empty() && SymbolTable::global().find(record.symbol, id)) {
+            asset = assets.find(id);
+        }
         
-        // Calculate total portfolio value
-        for (const auto& [symbol, asset] : assets) {
-            totalValue += asset->getCurrentValue();
+        // Trades journaled before trade times were recorded count as now
+        std::int64_t tradeTime = record.timestampMs > 0 ? record.timestampMs / 1000 : Clock::now();
+        switch (record.type) {
+            case JournalRecord::Type::Buy:
+                if (asset) (*asset)->buy(record.amount, record.price, tradeTime);
+                break;
+            case JournalRecord::Type::Sell:
+                if (asset && record.relief == LotLedger::Relief::Specific) {
+                    (*asset)->sellLot(record.lot, record.amount, record.price, tradeTime);
+                } else if (asset) {
+                    (*asset)->sell(record.amount, record.price, tradeTime, record.relief);
+                }
+                break;
+            case JournalRecord::Type::SipRun:
+                sipManager.setLastInvestmentDate(std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::milliseconds(record.timestampMs))));
+                break;
+            case JournalRecord::Type::Rebalance:
+                lastRebalanceDate = record.date;
+                break;
+        }
+        if (asset) holdings.upsert(id, **asset);
+        journalSequence = record.sequence;
+    }
+
+public:
+    // Journaled changes made while a batch is open share one sync, so a
+    // whole SIP run or rebalance costs a single fsync
+    class JournalBatch {
+    private:
+        PortfolioManager& manager;
+    
+    public:
+        explicit JournalBatch(PortfolioManager& manager) : manager(manager) {
+            ++manager.journalBatchDepth;
         }
         
-        if (totalValue <= 0.0) return 0.0;
+        JournalBatch(const JournalBatch&) = delete;
+        JournalBatch& operator=(const JournalBatch&) = delete;
         
-        // Calculate weighted volatility
-        for (const auto& [symbol, asset] : assets) {
-            double weight = asset->getCurrentValue() / totalValue;
-            weightedVolatility += weight * asset->getVolatility();
+        // The batch's changes are applied by now; if they cannot be made
+        // durable, only a saved state keeps them
+        ~JournalBatch() {
+            if (--manager.journalBatchDepth == 0 && manager.journal && !manager.journal->sync()) {
+                std::cerr << "Journaled changes are not durable: save the portfolio to keep them" << std::endl;
+            }
         }
+    };
+    
+    PortfolioManager(const UserProfile& userProfile)
+        : riskAnalyzer(convertRiskAppetiteToScore(userProfile.getRiskAppetite())),
+          marketData(std::make_unique<SimulatedMarketDataSource>(dataFetcher)),
+          sipManager(userProfile.getMonthlyInvestment()),
+          initialInvestment(userProfile.getInvestmentCapital()) {
+        
+        // Set up SIP allocation based on risk profile
+        setupInitialAllocation(userProfile);
         
-        return weightedVolatility;
+        // Add initial capital entry to historical values
+        historicalValues.push_back({Clock::today(), initialInvestment});
     }
     
-    // Assess if an asset is too volatile
-    bool isAssetTooVolatile(const Asset& asset) const {
-        return asset.getVolatility() > volatilityThreshold;
+    // Add a new asset to the portfolio; the targets now cover it too
+    void addAsset(const std::string& symbol, std::shared_ptr<Asset> asset) {
+        addAsset(SymbolTable::global().intern(symbol), asset);
+        riskAnalyzer.setUniverse(assets);
     }
     
-    // Calculate risk-adjusted return (Sharpe Ratio-like)
-    double calculateRiskAdjustedReturn(const std::map<std::string, std::shared_ptr<Asset>>& assets, double riskFreeRate = 0.5) {
-        double totalValue = 0.0;
-        double weightedReturn = 0.0;
-        
-        // Calculate total portfolio value and weighted return
-        for (const auto& [symbol, asset] : assets) {
-            totalValue += asset->getCurrentValue();
+    void addAsset(SymbolId id, std::shared_ptr<Asset> asset) {
+        if (!archiveDirectory.empty()) {
+            asset->attachArchive(PriceArchive::open(archivePath(id)));
         }
-        
-        if (totalValue <= 0.0) return 0.0;
-        
-        for (const auto& [symbol, asset] : assets) {
-            double weight = asset->getCurrentValue() / totalValue;
-            weightedReturn += weight * asset->getReturnPercentage();
+        assets[id] = asset;
+        holdings.upsert(id, *asset);
+        covariance.addInstrument(id);
+        dailyReturns.addInstrument(id);
+    }
+    
+    // Rebuild the covariance window from the assets' recorded price history;
+    // call after adding assets in bulk
+    void seedCovariance() {
+        std::vector<const PriceSeries*> series;
+        for (SymbolId id : covariance.getIds()) {
+            series.push_back(&(*assets.find(id))->getPriceHistory());
         }
-        
-        double portfolioVolatility = calculatePortfolioVolatility(assets);
-        
-        // Avoid division by zero
-        if (portfolioVolatility <= 0.0) return 0.0;
-        
-        // (Portfolio Return - Risk-Free Rate) / Portfolio Volatility
-        return (weightedReturn - riskFreeRate) / portfolioVolatility;
+        covariance.seed(series);
+        seedDailyReturns();
+        riskAnalyzer.observeReturns(dailyReturns);
+        riskAnalyzer.observeCorrelation(covariance);
     }
     
-    // Recommend rebalancing based on current allocation vs ideal
-    std::map<std::string, double> recommendRebalancing(const std::map<std::string, std::shared_ptr<Asset>>& assets) {
-        std::map<std::string, double> currentAllocation;
-        std::map<std::string, double> recommendations;
-        double totalValue = 0.0;
-        
-        // Calculate total portfolio value
-        for (const auto& [symbol, asset] : assets) {
-            totalValue += asset->getCurrentValue();
+    // Rebuild daily returns from the archives, or the in-memory history
+    void seedDailyReturns() {
+        std::vector<const Asset*> history;
+        for (SymbolId id : dailyReturns.getCovariance().getIds()) {
+            history.push_back(assets.find(id)->get());
         }
-        
-        if (totalValue <= 0.0) return recommendations;
-        
-        // Calculate current allocation percentages
-        for (const auto& [symbol, asset] : assets) {
-            currentAllocation[symbol] = (asset->getCurrentValue() / totalValue) * 100.0;
+        dailyReturns.seed(history);
+    }
+    
+    // Persist price history per symbol under `directory` (created if missing)
+    bool setArchiveDirectory(const std::string& directory) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            std::cerr << "Failed to create archive directory " << directory << ": " << ec.message() << std::endl;
+            return false;
         }
         
-        // Compare with ideal allocation and generate recommendations
-        for (const auto& [symbol, idealPercent] : idealAllocation) {
-            double currentPercent = (currentAllocation.find(symbol) != currentAllocation.end()) ? 
-                                   currentAllocation[symbol] : 0.0;
-            
-            double difference = idealPercent - currentPercent;
-            
-            // Only recommend significant changes (more than 5% difference)
-            if (std::abs(difference) >= 5.0) {
-                recommendations[symbol] = difference;
-            }
+        archiveDirectory = directory;
+        for (const auto& [id, asset] : assets) {
+            asset->attachArchive(PriceArchive::open(archivePath(id)));
         }
-        
-        return recommendations;
+        holdings.syncAll(assets);
+        seedDailyReturns();
+        return true;
     }
     
-    // Adjust risk score based on market conditions
-    void adjustRiskScoreForMarketConditions(double vix, double btcVolatility) {
-        double adjustment = 0.0;
-        
-        // VIX adjustment
-        if (vix > 30.0) {
-            // High market volatility, reduce risk
-            adjustment -= 10.0;
-        } else if (vix < 15.0) {
-            // Low market volatility, can increase risk
-            adjustment += 5.0;
+    // Saved holdings, SIP plan, risk targets and value history; see PortfolioState
+    void saveState(BinaryWriter& out) const {
+        out.put(initialInvestment);
+        out.put<std::uint8_t>(lastRebalanceDate ? 1 : 0);
+        out.put<std::int32_t>(lastRebalanceDate ? lastRebalanceDate->days : 0);
+        
+        std::vector<std::int32_t> days;
+        std::vector<double> values;
+        days.reserve(historicalValues.size());
+        values.reserve(historicalValues.size());
+        for (const auto& [date, value] : historicalValues) {
+            days.push_back(date.days);
+            values.push_back(value);
         }
+        out.putArray(days);
+        out.putArray(values);
         
-        // BTC volatility adjustment
-        if (btcVolatility > 20.0) {
-            // High crypto volatility, reduce risk
-            adjustment -= 5.0;
+        out.put<std::uint32_t>(static_cast<std::uint32_t>(assets.size()));
+        for (const auto& [id, asset] : assets) {
+            out.putSymbol(id);
+            AssetCodec::save(out, *asset);
         }
         
-        // Apply adjustment with limits
-        double newRiskScore = riskScore + adjustment;
-        setRiskScore(std::min(100.0, std::max(0.0, newRiskScore)));
+        sipManager.save(out);
+        riskAnalyzer.save(out);
     }
     
-    // Display risk analysis
-    void display() const {
-        std::cout << "\n========== RISK ANALYSIS ==========\n" << std::endl;
-        std::cout << "Risk Score: " << riskScore << "/100" << std::endl;
-        std::cout << "Risk Profile: " << getRiskProfileStr() << std::endl;
-        std::cout << "Volatility Threshold: " << volatilityThreshold << "%" << std::endl;
+    // Replace the whole portfolio with saved state. Nothing is re-solved:
+    // the covariance window is rebuilt from the restored histories, but the
+    // risk targets keep their saved values (unless the saved universe no
+    // longer matches the holdings). `appliedSequence` is the last
+    // journal record the state includes. Returns false, leaving this
+    // portfolio unusable, if the state is malformed.
+    bool restoreState(BinaryReader& in, std::uint64_t appliedSequence = 0) {
+        double savedInvestment = in.get<double>();
+        bool rebalanced = in.get<std::uint8_t>() != 0;
+        std::int32_t rebalanceDay = in.get<std::int32_t>();
+        std::vector<std::int32_t> days = in.getArray<std::int32_t>();
+        std::vector<double> values = in.getArray<double>();
+        if (!in.ok() || days.size() != values.size()) return false;
+        
+        AssetMap restored;
+        std::uint32_t count = in.get<std::uint32_t>();
+        for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+            SymbolId id = in.getSymbol();
+            std::shared_ptr<Asset> asset = AssetCodec::load(in);
+            if (asset) restored[id] = std::move(asset);
+        }
+        sipManager.load(in);
+        riskAnalyzer.load(in);
+        if (!in.ok()) return false;
+        
+        initialInvestment = savedInvestment;
+        journalSequence = appliedSequence;
+        lastRebalanceDate = rebalanced ? std::optional<Date>(Date{rebalanceDay}) : std::nullopt;
+        historicalValues.clear();
+        historicalValues.reserve(days.size());
+        for (size_t i = 0; i < days.size(); ++i) {
+            historicalValues.push_back({Date{days[i]}, values[i]});
+        }
         
-        std::cout << "\nIdeal Asset Allocation:" << std::endl;
-        for (const auto& [symbol, percentage] : idealAllocation) {
-            std::cout << "  " << symbol << ": " << percentage << "%" << std::endl;
+        std::vector<SymbolId> previous = covariance.getIds();
+        for (SymbolId id : previous) {
+            assets.erase(id);
+            holdings.remove(id);
+            covariance.removeInstrument(id);
+            dailyReturns.removeInstrument(id);
+        }
+        SymbolMap<double> prices;
+        for (const auto& [id, asset] : restored) {
+            addAsset(id, asset);
+            prices[id] = asset->getCurrentPrice();
         }
+        std::vector<const PriceSeries*> series;
+        for (SymbolId id : covariance.getIds()) {
+            series.push_back(&(*assets.find(id))->getPriceHistory());
+        }
+        covariance.seed(series);
+        seedDailyReturns();
+        riskAnalyzer.setUniverse(assets);
+        riskAnalyzer.observeReturns(dailyReturns);
         
-        std::cout << std::endl;
+        // Simulated prices carry on from where the saved session stopped
+        dataFetcher.getPriceBoard().publish(prices, Clock::nowMillis());
+        return true;
     }
     
-    // Get risk profile as string
-    std::string getRiskProfileStr() const {
-        if (riskScore < 30.0) {
-            return "Conservative";
-        } else if (riskScore < 70.0) {
-            return "Moderate";
-        } else {
-            return "Aggressive";
+    // Archive file for a symbol, e.g. "EUR/USD" -> "<dir>/EUR_USD.phist"
+    std::string archivePath(SymbolId id) const {
+        std::string fileName = SymbolTable::global().name(id);
+        std::replace(fileName.begin(), fileName.end(), '/', '_');
+        return (std::filesystem::path(archiveDirectory) / (fileName + ".phist")).string();
+    }
+    
+    // Journal position changes from now on. Records already in the journal
+    // are treated as superseded unless replayJournal() applied them first.
+    void setJournal(std::unique_ptr<TransactionJournal> newJournal) {
+        journal = std::move(newJournal);
+        if (!journal) return;
+        journalSequence = std::max(journalSequence, journal->getLastSequence());
+        journal->skipTo(journalSequence);
+    }
+    
+    // Apply journaled changes newer than this state, e.g. after restoring
+    // the last saved state following a crash. Returns the records applied.
+    size_t replayJournal(TransactionJournal& source) {
+        size_t applied = source.replay(journalSequence, [this](const JournalRecord& record) {
+            applyJournalRecord(record);
+        });
+        if (applied > 0) {
+            recordPortfolioValue();
         }
+        return applied;
     }
-};
-
-// Portfolio Manager class to manage all assets
-class PortfolioManager {
-private:
-    std::map<std::string, std::shared_ptr<Asset>> assets;
-    RiskAnalyzer riskAnalyzer;
-    MarketDataFetcher dataFetcher;
-    SIPManager sipManager;
-    std::vector<std::pair<std::string, double>> historicalValues; // Date, Total Value
-    double initialInvestment;
-    std::string lastRebalanceDate;
-
-public:
-    PortfolioManager(const UserProfile& userProfile)
-        : riskAnalyzer(convertRiskAppetiteToScore(userProfile.getRiskAppetite())),
-          sipManager(userProfile.getMonthlyInvestment()),
-          initialInvestment(userProfile.getInvestmentCapital()) {
-        
-        // Set up SIP allocation based on risk profile
-        setupInitialAllocation(userProfile);
-        
-        // Add initial capital entry to historical values
-        historicalValues.push_back({Utils::getCurrentDate(), initialInvestment});
+    
+    // The saved state now covers every journaled change, so drop them
+    bool checkpointJournal() {
+        return !journal || journal->checkpoint(journalSequence);
     }
     
-    // Add a new asset to the portfolio
-    void addAsset(const std::string& symbol, std::shared_ptr<Asset> asset) {
-        assets[symbol] = asset;
+    std::uint64_t getJournalSequence() const {
+        return journalSequence;
+    }
+    
+    TransactionJournal* getJournal() {
+        return journal.get();
+    }
+    
+    // Journaled buy of `amount` at the current price
+    bool buyAsset(SymbolId id, double amount) {
+        std::shared_ptr<Asset>* asset = assets.find(id);
+        if (!asset) return false;
+        
+        JournalRecord record;
+        record.type = JournalRecord::Type::Buy;
+        record.symbol = SymbolTable::global().name(id);
+        record.amount = amount;
+        record.price = (*asset)->getCurrentPrice();
+        record.timestampMs = Clock::nowMillis();
+        if (!journalChange(record)) return false;
+        
+        (*asset)->buy(amount, record.price, record.timestampMs / 1000);
+        holdings.upsert(id, **asset);
+        return true;
+    }
+    
+    // Journaled sale of `percentage` of a position, relieving lots by the
+    // asset's relief method; returns the proceeds
+    double sellAsset(SymbolId id, double percentage) {
+        std::shared_ptr<Asset>* asset = assets.find(id);
+        if (!asset || percentage <= 0 || percentage > 100) return 0.0;
+        
+        JournalRecord record;
+        record.type = JournalRecord::Type::Sell;
+        record.symbol = SymbolTable::global().name(id);
+        record.amount = percentage;
+        record.price = (*asset)->getCurrentPrice();
+        record.timestampMs = Clock::nowMillis();
+        record.relief = (*asset)->getLotRelief();
+        if (!journalChange(record)) return 0.0;
+        
+        double proceeds = (*asset)->sell(percentage, record.price, record.timestampMs / 1000, record.relief);
+        holdings.upsert(id, **asset);
+        return proceeds;
+    }
+    
+    // Journaled sale of up to `quantity` from one lot; returns the proceeds
+    double sellLot(SymbolId id, std::uint32_t lot, double quantity) {
+        std::shared_ptr<Asset>* asset = assets.find(id);
+        if (!asset || quantity <= 0 || !(*asset)->getLots().isOpen(lot)) return 0.0;
+        
+        JournalRecord record;
+        record.type = JournalRecord::Type::Sell;
+        record.symbol = SymbolTable::global().name(id);
+        record.amount = quantity;
+        record.price = (*asset)->getCurrentPrice();
+        record.timestampMs = Clock::nowMillis();
+        record.relief = LotLedger::Relief::Specific;
+        record.lot = lot;
+        if (!journalChange(record)) return 0.0;
+        
+        double proceeds = (*asset)->sellLot(lot, quantity, record.price, record.timestampMs / 1000);
+        holdings.upsert(id, **asset);
+        return proceeds;
+    }
+    
+    // Relief method for every holding's future sells
+    void setLotRelief(LotLedger::Relief method) {
+        for (const auto& [id, asset] : assets) {
+            asset->setLotRelief(method);
+        }
     }
     
     // Remove an asset from the portfolio
     bool removeAsset(const std::string& symbol) {
-        if (assets.find(symbol) != assets.end()) {
-            assets.erase(symbol);
-            return true;
+        SymbolId id;
+        if (!SymbolTable::global().find(symbol, id) || !assets.erase(id)) {
+            return false;
         }
-        return false;
+        holdings.remove(id);
+        covariance.removeInstrument(id);
+        dailyReturns.removeInstrument(id);
+        riskAnalyzer.setUniverse(assets);
+        riskAnalyzer.observeReturns(dailyReturns);
+        return true;
     }
     
     // Get an asset by symbol
     std::shared_ptr<Asset> getAsset(const std::string& symbol) {
-        if (assets.find(symbol) != assets.end()) {
-            return assets[symbol];
-        }
-        return nullptr;
+        SymbolId id;
+        return SymbolTable::global().find(symbol, id) ? getAsset(id) : nullptr;
+    }
+    
+    std::shared_ptr<Asset> getAsset(SymbolId id) {
+        std::shared_ptr<Asset>* asset = assets.find(id);
+        return asset ? *asset : nullptr;
+    }
+    
+    // Re-mirror all assets into the holdings table; needed after mutating
+    // an asset obtained through getAsset()
+    void refreshHoldings() {
+        holdings.syncAll(assets);
     }
     
     // Convert RiskAppetite enum to numerical score
@@ -1389,39 +8737,25 @@ public:
     
     // Set up initial allocation based on user profile
     void setupInitialAllocation(const UserProfile& userProfile) {
-        std::map<std::string, double> allocation;
-        
-        switch (userProfile.getRiskAppetite()) {
-            case RiskAppetite::LOW:
-                allocation["SIP"] = 60.0;
-                allocation["USD"] = 20.0;
-                allocation["XAU/USD"] = 10.0;
-                allocation["EUR/USD"] = 5.0;
-                allocation["BTC"] = 5.0;
-                break;
-                
-            case RiskAppetite::MEDIUM:
-                allocation["SIP"] = 40.0;
-                allocation["EUR/USD"] = 20.0;
-                allocation["BTC"] = 15.0;
-                allocation["XAU/USD"] = 15.0;
-                allocation["USD"] = 10.0;
-                break;
-                
-            case RiskAppetite::HIGH:
-                allocation["SIP"] = 20.0;
-                allocation["EUR/USD"] = 30.0;
-                allocation["BTC"] = 30.0;
-                allocation["XAU/USD"] = 10.0;
-                allocation["USD"] = 10.0;
-                break;
+        // Until anything is held the targets span the starter instruments,
+        // built as the assets initializePortfolio() will buy
+        AssetMap starter;
+        for (const char* symbol : {"SIP", "USD", "XAU/USD", "EUR/USD", "BTC"}) {
+            SymbolId id = SymbolTable::global().intern(symbol);
+            starter[id] = createAsset(id, 0.0);
         }
+        riskAnalyzer.setUniverse(starter);
         
-        // Set the allocation for SIP manager
-        sipManager.setAllocation(allocation);
-        
-        // Also update the risk analyzer's ideal allocation
+        // The risk analyzer solves for the efficient-frontier portfolio
+        // matching the user's risk appetite; SIPs follow the same weights
         riskAnalyzer.setRiskScore(convertRiskAppetiteToScore(userProfile.getRiskAppetite()));
+        sipManager.setAllocation(riskAnalyzer.getIdealAllocation());
+    }
+    
+    // The asset for `value` invested in a symbol at the current price
+    std::shared_ptr<Asset> createAsset(SymbolId id, double value) {
+        return AssetFactory::create(SymbolTable::global().name(id), dataFetcher.getPrice(id), value,
+                                    dataFetcher.getInterestRate("US"), dataFetcher.getInflationRate("US"));
     }
     
     // Initialize the portfolio with the given capital based on allocation
@@ -1430,66 +8764,94 @@ public:
         const auto& allocation = sipManager.getAllocation();
         
         // Initialize assets with allocated capital
-        for (const auto& [symbol, percentage] : allocation) {
-            double amount = capital * (percentage / 100.0);
-            
-            // Fetch current price
-            double price = dataFetcher.getPrice(symbol);
-            
-            // Create appropriate asset type based on symbol
-            std::shared_ptr<Asset> asset;
-            
-            double quantity = amount / price;
-            
-            if (symbol == "SIP") {
-                // Index ETF as SIP
-                asset = std::make_shared<SIP>("Vanguard Total Stock Market ETF", "VTI", price, quantity);
-            } else if (symbol == "BTC") {
-                // Cryptocurrency
-                asset = std::make_shared<Cryptocurrency>("Bitcoin", "BTC", price, 1000000000000.0, quantity);
-            } else if (symbol == "XAU/USD") {
-                // Gold
-                asset = std::make_shared<Commodity>("Gold", "XAU/USD", price, "24K", false, quantity);
-            } else if (symbol == "USD") {
-                // USD as cash
-                double interestRate = dataFetcher.getInterestRate("US");
-                double inflationRate = dataFetcher.getInflationRate("US");
-                asset = std::make_shared<FiatCurrency>("US Dollar", "USD", 1.0, "United States", 
-                                                      interestRate, inflationRate, amount);
-            } else if (symbol.find('/') != std::string::npos) {
-                // Forex
-                std::string baseCurrency = symbol.substr(0, 3);
-                std::string quoteCurrency = symbol.substr(4, 3);
-                asset = std::make_shared<Forex>(baseCurrency + " to " + quoteCurrency, symbol, 
-                                               price, baseCurrency, quoteCurrency, quantity);
-            } else {
-                // Generic asset as fallback
-                asset = std::make_shared<Asset>(symbol, symbol, price, quantity);
-            }
-            
-            addAsset(symbol, asset);
+        for (const auto& [id, percentage] : allocation) {
+            addAsset(id, createAsset(id, capital * (percentage / 100.0)));
         }
+        riskAnalyzer.setUniverse(assets);
+        seedCovariance();
         
         // Record initial portfolio value
         recordPortfolioValue();
     }
     
-    // Update asset prices with latest market data
-    void updatePrices(bool useRealAPI = false) {
-        std::vector<std::string> symbols;
-        
-        for (const auto& [symbol, asset] : assets) {
-            symbols.push_back(symbol);
+    // Switch the market data source behind updatePrices()
+    void setMarketDataSource(std::unique_ptr<MarketDataSource> source) {
+        if (source) marketData = std::move(source);
+    }
+    
+    // Build the source described by `spec` on this portfolio's fetcher;
+    // keeps the current source if it cannot be opened
+    bool setMarketData(const MarketDataSpec& spec) {
+        std::unique_ptr<MarketDataSource> source = spec.create(dataFetcher);
+        if (!source) return false;
+        marketData = std::move(source);
+        return true;
+    }
+    
+    const MarketDataSource& getMarketDataSource() const {
+        return *marketData;
+    }
+    
+    // Latest applied price per symbol, readable from any thread
+    const PriceBoard& getPriceBoard() const {
+        return dataFetcher.getPriceBoard();
+    }
+    
+    // Apply the next batch from the market data source, stamped with the
+    // batch's own time; false once the source is exhausted (end of a
+    // replay, closed feed)
+    bool updatePrices() {
+        if (!marketData->next(assets.ids(), batch)) {
+            return false;
         }
         
-        std::map<std::string, double> newPrices = dataFetcher.updatePrices(symbols, useRealAPI);
-        
-        for (const auto& [symbol, price] : newPrices) {
-            if (assets.find(symbol) != assets.end()) {
-                assets[symbol]->updateCurrentPrice(price);
+        std::int64_t timestamp = batch.timestampMs / 1000;
+        bool applied = false;
+        for (const auto& [id, price] : batch.prices) {
+            if (std::shared_ptr<Asset>* asset = assets.find(id)) {
+                (*asset)->updateCurrentPrice(price, timestamp);
+                holdings.upsert(id, **asset);
+                applied = true;
             }
         }
+        if (applied) {
+            absorbPrices(batch);
+        }
+        return true;
+    }
+    
+    // Consume ticks pushed by a feed reader: every tick updates its asset
+    // in arrival order, then holdings, covariance, the target allocation
+    // and the recorded value are refreshed once for the whole drain with
+    // each symbol's latest price. Returns the number of ticks taken.
+    size_t applyTicks(TickIngestor& ingestor, size_t maxTicks = std::numeric_limits<size_t>::max()) {
+        batch.prices.clear();
+        batch.timestampMs = 0;
+        size_t taken = ingestor.drain([this](const MarketTick& tick) {
+            if (std::shared_ptr<Asset>* asset = assets.find(tick.symbol)) {
+                (*asset)->updateCurrentPrice(tick.price, tick.timestampMs / 1000);
+                batch.prices[tick.symbol] = tick.price;
+                batch.timestampMs = std::max(batch.timestampMs, tick.timestampMs);
+            }
+        }, maxTicks);
         
+        if (!batch.prices.empty()) {
+            for (const auto& [id, price] : batch.prices) {
+                holdings.upsert(id, **assets.find(id));
+            }
+            absorbPrices(batch);
+        }
+        return taken;
+    }
+    
+    // Portfolio-level follow-up to a round of price changes; the prices
+    // also go on the price board for readers on other threads
+    void absorbPrices(const MarketBatch& applied) {
+        dataFetcher.getPriceBoard().publish(applied.prices, applied.timestampMs);
+        covariance.update(applied.prices);
+        dailyReturns.update(applied.prices, applied.timestampMs / 1000);
+        riskAnalyzer.observeReturns(dailyReturns);
+        riskAnalyzer.observeCorrelation(covariance);
         recordPortfolioValue();
     }
     
@@ -1499,32 +8861,37 @@ public:
             return;
         }
         
-        std::map<std::string, double> investments = sipManager.executeInvestment(force);
+        JournalBatch batch(*this);
+        auto previousRun = sipManager.getLastInvestmentDate();
+        SymbolMap<double> investments = sipManager.executeInvestment(force);
         
-        for (const auto& [symbol, amount] : investments) {
-            if (assets.find(symbol) != assets.end() && amount > 0) {
-                assets[symbol]->buy(amount);
+        for (const auto& [id, amount] : investments) {
+            if (amount > 0 && buyAsset(id, amount)) {
                 std::cout << "SIP Investment: Bought " << Utils::formatCurrency(amount) 
-                          << " worth of " << symbol << std::endl;
+                          << " worth of " << SymbolTable::global().name(id) << std::endl;
             }
         }
         
+        if (sipManager.getLastInvestmentDate() != previousRun) {
+            JournalRecord record;
+            record.type = JournalRecord::Type::SipRun;
+            record.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                sipManager.getLastInvestmentDate().time_since_epoch()).count();
+            journalChange(record);
+        }
+        
         recordPortfolioValue();
     }
     
     // Record current portfolio value for historical tracking
     void recordPortfolioValue() {
         double totalValue = getTotalValue();
-        historicalValues.push_back({Utils::getCurrentDate(), totalValue});
+        historicalValues.push_back({Clock::today(), totalValue});
     }
     
     // Calculate total portfolio value
     double getTotalValue() const {
-        double total = 0.0;
-        for (const auto& [symbol, asset] : assets) {
-            total += asset->getCurrentValue();
-        }
-        return total;
+        return holdings.totalValue();
     }
     
     // Calculate total return percentage
@@ -1533,23 +8900,24 @@ public:
         return ((getTotalValue() - initialInvestment) / initialInvestment) * 100.0;
     }
     
-    // Get portfolio composition as percentages
-    std::map<std::string, double> getPortfolioComposition() const {
-        std::map<std::string, double> composition;
-        double totalValue = getTotalValue();
-        
-        if (totalValue <= 0) return composition;
-        
-        for (const auto& [symbol, asset] : assets) {
-            composition[symbol] = (asset->getCurrentValue() / totalValue) * 100.0;
+    // Immutable view of the current holdings; taken once per holdings
+    // version, so callers between two changes share the same snapshot
+    std::shared_ptr<const PortfolioSnapshot> snapshot() const {
+        if (!lastSnapshot || lastSnapshot->getVersion() != holdings.getVersion()) {
+            lastSnapshot = std::make_shared<const PortfolioSnapshot>(holdings, initialInvestment);
         }
-        
-        return composition;
+        return lastSnapshot;
+    }
+    
+    // Get portfolio composition as percentages
+    SymbolMap<double> getPortfolioComposition() const {
+        return snapshot()->composition();
     }
     
     // Rebalance portfolio based on risk analyzer recommendations
     void rebalancePortfolio() {
-        auto recommendations = riskAnalyzer.recommendRebalancing(assets);
+        std::shared_ptr<const PortfolioSnapshot> before = snapshot();
+        auto recommendations = riskAnalyzer.recommendRebalancing(*before);
         
         if (recommendations.empty()) {
             std::cout << "Portfolio is well-balanced. No rebalancing needed." << std::endl;
@@ -1558,9 +8926,11 @@ public:
         
         std::cout << "\n========== REBALANCING PORTFOLIO ==========\n" << std::endl;
         
-        double totalValue = getTotalValue();
+        JournalBatch batch(*this);
+        double totalValue = before->getTotalValue();
         
-        for (const auto& [symbol, percentageDiff] : recommendations) {
+        for (const auto& [id, percentageDiff] : recommendations) {
+            const std::string& symbol = SymbolTable::global().name(id);
             double targetAmount = totalValue * (std::abs(percentageDiff) / 100.0);
             
             if (percentageDiff > 0) {
@@ -1569,25 +8939,25 @@ public:
                           << " worth of " << symbol << " (increase by " 
                           << std::fixed << std::setprecision(1) << percentageDiff << "%)" << std::endl;
                 
-                if (assets.find(symbol) != assets.end()) {
-                    assets[symbol]->buy(targetAmount);
-                }
+                buyAsset(id, targetAmount);
             } else {
                 // Need to sell some of this asset
                 std::cout << "Recommendation: SELL " << Utils::formatCurrency(targetAmount) 
                           << " worth of " << symbol << " (decrease by " 
                           << std::fixed << std::setprecision(1) << std::abs(percentageDiff) << "%)" << std::endl;
                 
-                if (assets.find(symbol) != assets.end()) {
-                    double sellPercentage = std::abs(percentageDiff);
-                    assets[symbol]->sell(sellPercentage);
-                }
+                sellAsset(id, std::abs(percentageDiff));
             }
         }
         
-        lastRebalanceDate = Utils::getCurrentDate();
+        JournalRecord record;
+        record.type = JournalRecord::Type::Rebalance;
+        record.date = Clock::today();
+        if (journalChange(record)) {
+            lastRebalanceDate = record.date;
+        }
         recordPortfolioValue();
-        std::cout << "\nRebalancing completed on " << lastRebalanceDate << std::endl;
+        std::cout << "\nRebalancing completed on " << record.date.toString() << std::endl;
     }
     
     // Get risk analyzer reference
@@ -1602,30 +8972,33 @@ public:
     
     // Display portfolio summary
     void displayPortfolioSummary() const {
+        displayPortfolioSummary(*snapshot());
+    }
+    
+    void displayPortfolioSummary(const PortfolioSnapshot& snapshot) const {
         std::cout << "\n========== PORTFOLIO SUMMARY ==========\n" << std::endl;
         
-        double totalValue = getTotalValue();
-        double totalReturn = getTotalReturnPercentage();
+        double totalValue = snapshot.getTotalValue();
+        double totalReturn = snapshot.getTotalReturnPercentage();
         
         std::cout << "Total Portfolio Value: " << Utils::formatCurrency(totalValue) << std::endl;
-        std::cout << "Initial Investment: " << Utils::formatCurrency(initialInvestment) << std::endl;
+        std::cout << "Initial Investment: " << Utils::formatCurrency(snapshot.getInitialInvestment()) << std::endl;
         std::cout << "Total Return: " << std::fixed << std::setprecision(2) << totalReturn << "%" << std::endl;
-        std::cout << "Gain/Loss: " << Utils::formatCurrency(totalValue - initialInvestment) << std::endl;
+        std::cout << "Gain/Loss: " << Utils::formatCurrency(totalValue - snapshot.getInitialInvestment()) << std::endl;
         
-        if (!lastRebalanceDate.empty()) {
-            std::cout << "Last Rebalanced: " << lastRebalanceDate << std::endl;
+        if (lastRebalanceDate) {
+            std::cout << "Last Rebalanced: " << lastRebalanceDate->toString() << std::endl;
         }
         
         std::cout << "\n--- Asset Breakdown ---" << std::endl;
-        auto composition = getPortfolioComposition();
-        
-        for (const auto& [symbol, asset] : assets) {
-            std::cout << "\n" << symbol << ":" << std::endl;
-            std::cout << "  Value: " << Utils::formatCurrency(asset->getCurrentValue()) << std::endl;
+        const std::vector<SymbolId>& ids = snapshot.getIds();
+        for (size_t row = 0; row < ids.size(); ++row) {
+            std::cout << "\n" << SymbolTable::global().name(ids[row]) << ":" << std::endl;
+            std::cout << "  Value: " << Utils::formatCurrency(snapshot.getValues()[row]) << std::endl;
             std::cout << "  Allocation: " << std::fixed << std::setprecision(1) 
-                      << composition.at(symbol) << "%" << std::endl;
+                      << snapshot.getWeights()[row] << "%" << std::endl;
             std::cout << "  Return: " << std::fixed << std::setprecision(2) 
-                      << asset->getReturnPercentage() << "%" << std::endl;
+                      << snapshot.getReturns()[row] << "%" << std::endl;
         }
         
         std::cout << std::endl;
@@ -1635,13 +9008,14 @@ public:
     void displayDetailedAnalysis() const {
         std::cout << "\n========== DETAILED PORTFOLIO ANALYSIS ==========\n" << std::endl;
         
-        for (const auto& [symbol, asset] : assets) {
+        for (const auto& [id, asset] : assets) {
             asset->display();
         }
         
         // Portfolio-level metrics
-        double portfolioVolatility = riskAnalyzer.calculatePortfolioVolatility(assets);
-        double riskAdjustedReturn = riskAnalyzer.calculateRiskAdjustedReturn(assets);
+        std::shared_ptr<const PortfolioSnapshot> current = snapshot();
+        double portfolioVolatility = riskAnalyzer.calculatePortfolioVolatility(*current, covariance);
+        double riskAdjustedReturn = riskAnalyzer.calculateRiskAdjustedReturn(*current, covariance);
         
         std::cout << "--- Portfolio Metrics ---" << std::endl;
         std::cout << "Portfolio Volatility: " << std::fixed << std::setprecision(2) 
@@ -1649,15 +9023,245 @@ public:
         std::cout << "Risk-Adjusted Return: " << std::fixed << std::setprecision(2) 
                   << riskAdjustedReturn << std::endl;
         
-        // Display ASCII pie chart
-        auto composition = getPortfolioComposition();
-        std::cout << "\n--- Portfolio Composition ---" << std::endl;
-        std::cout << Utils::generateASCIIPieChart(composition) << std::endl;
-    }
-    
-    // Get all assets
-    const std::map<std::string, std::shared_ptr<Asset>>& getAssets() const {
-        return assets;
+        riskAnalyzer.display(*current, dailyReturns);
+        
+        // Display ASCII pie chart
+        std::map<std::string, double> composition;
+        for (const auto& [id, percentage] : current->composition()) {
+            composition[SymbolTable::global().name(id)] = percentage;
+        }
+        std::cout << "\n--- Portfolio Composition ---" << std::endl;
+        std::cout << Utils::generateASCIIPieChart(composition) << std::endl;
+    }
+    
+    // Monte Carlo projection of the whole portfolio: asset-class priors for
+    // return and volatility, correlation and bootstrap samples from the
+    // recorded price history, and monthly SIP contributions split by the
+    // SIP allocation across the assets actually held
+    MonteCarloResult runMonteCarlo(const MonteCarloConfig& config) const {
+        const SymbolMap<double>& allocation = sipManager.getAllocation();
+        double heldAllocation = 0.0;
+        for (const auto& [id, percentage] : allocation) {
+            if (assets.contains(id)) heldAllocation += percentage;
+        }
+        
+        std::vector<MonteCarloAsset> positions;
+        std::vector<const PriceSeries*> series;
+        for (const auto& [id, asset] : assets) {
+            ReturnPrior prior = ReturnPrior::forAsset(*asset);
+            const double* percentage = allocation.find(id);
+            double contribution = (percentage && heldAllocation > 0.0)
+                                  ? sipManager.getMonthlyAmount() * (*percentage / heldAllocation) : 0.0;
+            positions.push_back({id, asset->getCurrentValue(), prior.annualReturn,
+                                 prior.annualVolatility, contribution});
+            series.push_back(&asset->getPriceHistory());
+        }
+        
+        MonteCarloEngine engine(std::move(positions));
+        std::vector<double> history = CovarianceEngine::jointReturns(series);
+        if (history.size() / std::max<size_t>(1, series.size()) >= kMinCorrelationSamples) {
+            engine.setCorrelation(MonteCarloEngine::correlationOf(history, series.size()));
+            engine.setBootstrapReturns(history);
+        }
+        return engine.run(config);
+    }
+    
+    // Get all assets
+    const AssetMap& getAssets() const {
+        return assets;
+    }
+    
+    // Get the struct-of-arrays holdings mirror
+    const HoldingsTable& getHoldings() const {
+        return holdings;
+    }
+    
+    // Get the rolling covariance of asset returns
+    const CovarianceEngine& getCovariance() const {
+        return covariance;
+    }
+    
+    // Get the daily returns behind VaR
+    const DailyReturns& getDailyReturns() const {
+        return dailyReturns;
+    }
+};
+
+// Whole-application state in one compact binary file: a fixed 64-byte
+// header, the symbol table, then the profile and portfolio sections. The
+// header carries a format version, a byte-order mark, a checksum of the
+// body and the last transaction journal record included, so files from
+// another build or a torn write are rejected instead of half-loaded.
+// Saving writes a temporary file, syncs it and renames it over the old
+// state, so a crash leaves either the old or the new file intact.
+class PortfolioState {
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t bodySize;
+        std::uint64_t checksum;
+        std::int64_t createdAtMs;
+        std::uint64_t journalSequence;  // Last journal record included, 0 = none
+        std::uint8_t reserved[16];
+    };
+    static_assert(sizeof(Header) == 64, "PortfolioState header must stay 64 bytes");
+    
+    static constexpr char kMagic[8] = {'F', 'A', 'S', 'T', 'A', 'T', 'E', '\0'};
+    static constexpr std::uint32_t kVersion = 3;  // 2: per-asset lot ledgers, 3: compacted lot ids
+    static constexpr std::uint32_t kByteOrder = 0x01020304;
+
+public:
+    // Serialise the profile and portfolio and atomically replace `path`
+    static bool save(const std::string& path, const UserProfile& profile, const PortfolioManager& portfolio) {
+        BinaryWriter sections;
+        profile.save(sections);
+        portfolio.saveState(sections);
+        
+        BinaryWriter symbolTable;
+        symbolTable.put<std::uint32_t>(static_cast<std::uint32_t>(sections.getSymbols().size()));
+        for (SymbolId id : sections.getSymbols()) {
+            symbolTable.putString(SymbolTable::global().name(id));
+        }
+        
+        std::string file(sizeof(Header), '\0');
+        file.reserve(sizeof(Header) + symbolTable.data().size() + sections.data().size());
+        file += symbolTable.data();
+        file += sections.data();
+        
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.byteOrder = kByteOrder;
+        header.bodySize = file.size() - sizeof(Header);
+        header.checksum = Utils::checksum64(file.data() + sizeof(Header), file.size() - sizeof(Header));
+        header.createdAtMs = Clock::nowMillis();
+        header.journalSequence = portfolio.getJournalSequence();
+        std::memcpy(&file[0], &header, sizeof(Header));
+        
+        return writeAtomically(path, file);
+    }
+    
+    // Load state saved by save(); `profile` and `portfolio` are only
+    // replaced when the whole file verifies and parses
+    static bool load(const std::string& path, UserProfile& profile, std::unique_ptr<PortfolioManager>& portfolio) {
+        std::string buffer;
+        const char* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = static_cast<size_t>(st.st_size);
+            mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Failed to map saved state: " << path << std::endl;
+            return false;
+        }
+        data = static_cast<const char*>(mapping);
+#endif
+        
+        bool loaded = parse(path, data, size, profile, portfolio);
+#ifndef _WIN32
+        munmap(mapping, size);
+#endif
+        return loaded;
+    }
+
+private:
+    static bool parse(const std::string& path, const char* data, size_t size,
+                      UserProfile& profile, std::unique_ptr<PortfolioManager>& portfolio) {
+        Header header;
+        if (size < sizeof(Header)) {
+            std::cerr << "Saved state is truncated: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(Header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.byteOrder != kByteOrder) {
+            std::cerr << "Not a saved state for this platform: " << path << std::endl;
+            return false;
+        }
+        if (header.version == 0 || header.version > kVersion) {
+            std::cerr << "Unsupported saved state version " << header.version << ": " << path << std::endl;
+            return false;
+        }
+        const char* body = data + sizeof(Header);
+        if (header.bodySize != size - sizeof(Header) ||
+            Utils::checksum64(body, static_cast<size_t>(header.bodySize)) != header.checksum) {
+            std::cerr << "Saved state is corrupted: " << path << std::endl;
+            return false;
+        }
+        
+        BinaryReader in(body, static_cast<size_t>(header.bodySize));
+        in.setVersion(header.version);
+        in.readSymbols();
+        UserProfile restoredProfile;
+        restoredProfile.load(in);
+        if (!in.ok()) return false;
+        
+        auto restored = std::make_unique<PortfolioManager>(restoredProfile);
+        if (!restored->restoreState(in, header.journalSequence) || !in.atEnd()) {
+            std::cerr << "Saved state is malformed: " << path << std::endl;
+            return false;
+        }
+        
+        profile = restoredProfile;
+        portfolio = std::move(restored);
+        return true;
+    }
+    
+    static bool writeAtomically(const std::string& path, const std::string& contents) {
+        std::string temporary = path + ".tmp";
+#ifdef _WIN32
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            if (!file.flush()) {
+                std::cerr << "Failed to write saved state: " << temporary << std::endl;
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        if (ec) {
+            std::cerr << "Failed to replace saved state " << path << ": " << ec.message() << std::endl;
+            return false;
+        }
+        return true;
+#else
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Failed to create saved state: " << temporary << std::endl;
+            return false;
+        }
+        bool written = Utils::writeAll(fd, contents.data(), contents.size()) && fsync(fd) == 0;
+        close(fd);
+        if (!written || ::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::cerr << "Failed to write saved state: " << path << std::endl;
+            ::unlink(temporary.c_str());
+            return false;
+        }
+        
+        // Make the rename itself durable
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        int dirFd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+        return true;
+#endif
     }
 };
 
@@ -1682,6 +9286,9 @@ public:
         double vix = dataFetcher.getVIX();
         double btcPrice = dataFetcher.getPrice("BTC");
         
+        // One snapshot of the holdings serves every portfolio-level check
+        std::shared_ptr<const PortfolioSnapshot> snapshot = portfolioManager.snapshot();
+        
         // Analyze individual assets
         analyzeAssets();
         
@@ -1689,10 +9296,10 @@ public:
         analyzeMarketConditions(vix);
         
         // Portfolio balance analysis
-        analyzePortfolioBalance();
+        analyzePortfolioBalance(*snapshot);
         
         // Risk analysis
-        analyzeRiskMetrics();
+        analyzeRiskMetrics(*snapshot);
         
         // Generate specific buy/sell/hold signals
         generateTradingSignals();
@@ -1702,7 +9309,8 @@ public:
     void analyzeAssets() {
         const auto& assets = portfolioManager.getAssets();
         
-        for (const auto& [symbol, asset] : assets) {
+        for (const auto& [id, asset] : assets) {
+            const std::string& symbol = SymbolTable::global().name(id);
             double volatility = asset->getVolatility();
             double returnPercentage = asset->getReturnPercentage();
             
@@ -1752,12 +9360,14 @@ public:
     }
     
     // Analyze portfolio balance
-    void analyzePortfolioBalance() {
-        auto composition = portfolioManager.getPortfolioComposition();
-        
+    void analyzePortfolioBalance(const PortfolioSnapshot& snapshot) {
         // Check for over-concentration
-        for (const auto& [symbol, percentage] : composition) {
+        const std::vector<SymbolId>& ids = snapshot.getIds();
+        for (size_t row = 0; row < ids.size(); ++row) {
+            SymbolId id = ids[row];
+            double percentage = snapshot.getWeights()[row];
             if (percentage > 40.0) {
+                const std::string& symbol = SymbolTable::global().name(id);
                 alerts.push_back("CONCENTRATION RISK: " + symbol + " represents " + 
                                std::to_string(static_cast<int>(percentage)) + "% of portfolio");
                 recommendations.push_back("Consider rebalancing to reduce " + symbol + " concentration");
@@ -1765,8 +9375,7 @@ public:
         }
         
         // Check if rebalancing is needed
-        auto rebalanceRecommendations = portfolioManager.getRiskAnalyzer().recommendRebalancing(
-            portfolioManager.getAssets());
+        auto rebalanceRecommendations = portfolioManager.getRiskAnalyzer().recommendRebalancing(snapshot);
         
         if (!rebalanceRecommendations.empty()) {
             recommendations.push_back("REBALANCING NEEDED: Portfolio allocation has drifted from target");
@@ -1774,11 +9383,12 @@ public:
     }
     
     // Analyze risk metrics
-    void analyzeRiskMetrics() {
+    void analyzeRiskMetrics(const PortfolioSnapshot& snapshot) {
+        const CovarianceEngine& covariance = portfolioManager.getCovariance();
         double portfolioVolatility = portfolioManager.getRiskAnalyzer().calculatePortfolioVolatility(
-            portfolioManager.getAssets());
+            snapshot, covariance);
         double riskAdjustedReturn = portfolioManager.getRiskAnalyzer().calculateRiskAdjustedReturn(
-            portfolioManager.getAssets());
+            snapshot, covariance);
         
         if (portfolioVolatility > 20.0) {
             alerts.push_back("HIGH PORTFOLIO VOLATILITY: " + 
@@ -1789,14 +9399,59 @@ public:
         if (riskAdjustedReturn < 0.5) {
             recommendations.push_back("LOW RISK-ADJUSTED RETURN: Review asset allocation for better efficiency");
         }
+        
+        // Tail risk: 1-day VaR at the first confidence level, and any single
+        // holding that carries most of it
+        const std::vector<RiskReport>& varReports = portfolioManager.getRiskAnalyzer().calculateValueAtRisk(
+            snapshot, portfolioManager.getDailyReturns());
+        if (!varReports.empty() && varReports.front().portfolioValue > 0.0) {
+            const RiskReport& report = varReports.front();
+            const VaRFigure& historical = report.get(VaRMethod::Historical);
+            const VaRFigure& parametric = report.get(VaRMethod::Parametric);
+            double worst = std::max(historical.valueAtRisk, parametric.valueAtRisk);
+            double worstPercent = worst / report.portfolioValue * 100.0;
+            int confidence = static_cast<int>(std::round(report.confidence * 100));
+            
+            if (worstPercent > 5.0) {
+                alerts.push_back("HIGH VALUE AT RISK: 1-day " + std::to_string(confidence) + "% VaR is " +
+                                 Utils::formatCurrency(worst) + " (" + 
+                                 std::to_string(static_cast<int>(worstPercent)) + "% of portfolio)");
+            }
+            for (const auto& holding : report.holdings) {
+                if (parametric.valueAtRisk > 0.0 && holding.componentVaR > 0.5 * parametric.valueAtRisk &&
+                    report.holdings.size() > 1) {
+                    recommendations.push_back("RISK CONCENTRATION: " + SymbolTable::global().name(holding.id) +
+                                              " contributes " + 
+                                              std::to_string(static_cast<int>(holding.componentVaR / parametric.valueAtRisk * 100)) +
+                                              "% of portfolio VaR; consider trimming it");
+                }
+            }
+        }
+        
+        // Sizeable holdings that move together give little diversification
+        if (covariance.getCount() >= 10) {
+            std::vector<double> weights = covariance.weightsFor(snapshot);
+            const auto& ids = covariance.getIds();
+            for (size_t i = 0; i < ids.size(); ++i) {
+                for (size_t j = i + 1; j < ids.size(); ++j) {
+                    if (weights[i] < 0.05 || weights[j] < 0.05) continue;
+                    double rho = covariance.correlation(i, j);
+                    if (rho > 0.8) {
+                        alerts.push_back("HIGH CORRELATION: " + SymbolTable::global().name(ids[i]) + " and " +
+                                         SymbolTable::global().name(ids[j]) + " move together (" +
+                                         std::to_string(static_cast<int>(rho * 100)) + "%)");
+                    }
+                }
+            }
+        }
     }
     
     // Generate specific trading signals
     void generateTradingSignals() {
         const auto& assets = portfolioManager.getAssets();
         
-        for (const auto& [symbol, asset] : assets) {
-            std::string signal = generateSignalForAsset(symbol, asset);
+        for (const auto& [id, asset] : assets) {
+            std::string signal = generateSignalForAsset(SymbolTable::global().name(id), asset);
             if (!signal.empty()) {
                 recommendations.push_back(signal);
             }
@@ -1808,8 +9463,17 @@ public:
         double returnPercentage = asset->getReturnPercentage();
         double volatility = asset->getVolatility();
         
-        // Simple signal logic
+        // Simple signal logic, refined by streaming indicators where available
         if (symbol == "BTC") {
+            auto crypto = std::dynamic_pointer_cast<Cryptocurrency>(asset);
+            if (crypto && crypto->getTrend() == "Overbought") {
+                return "BTC SIGNAL: SELL - RSI overbought at " + 
+                       std::to_string(static_cast<int>(crypto->getRSI().value()));
+            } else if (crypto && crypto->getTrend() == "Oversold") {
+                return "BTC SIGNAL: BUY - RSI oversold at " + 
+                       std::to_string(static_cast<int>(crypto->getRSI().value()));
+            }
+            
             if (returnPercentage > 15.0 && volatility > 20.0) {
                 return "BTC SIGNAL: SELL - High gains with high volatility suggest profit-taking";
             } else if (returnPercentage < -10.0 && volatility < 15.0) {
@@ -1818,6 +9482,11 @@ public:
                 return "BTC SIGNAL: HOLD - Wait for clearer trend";
             }
         } else if (symbol == "XAU/USD") {
+            auto gold = std::dynamic_pointer_cast<Commodity>(asset);
+            if (gold && gold->getBands().isReady() && asset->getCurrentPrice() < gold->getBands().getLower()) {
+                return "GOLD SIGNAL: BUY - Price below lower Bollinger band";
+            }
+            
             if (volatility < 5.0 && returnPercentage < 5.0) {
                 return "GOLD SIGNAL: BUY - Stable and underperforming, good hedge opportunity";
             } else if (returnPercentage > 10.0) {
@@ -1830,6 +9499,11 @@ public:
             } else if (returnPercentage > 8.0) {
                 return symbol + " SIGNAL: HOLD - Good forex performance, maintain position";
             }
+            
+            auto forex = std::dynamic_pointer_cast<Forex>(asset);
+            if (forex && forex->getTrend() == "Bearish") {
+                return symbol + " SIGNAL: REDUCE - Price below its short-term average";
+            }
         }
         
         return "";
@@ -1866,8 +9540,9 @@ public:
         std::cout << "Report Date: " << Utils::getCurrentDate() << std::endl;
         
         // Portfolio performance
-        double totalValue = portfolioManager.getTotalValue();
-        double totalReturn = portfolioManager.getTotalReturnPercentage();
+        std::shared_ptr<const PortfolioSnapshot> snapshot = portfolioManager.snapshot();
+        double totalValue = snapshot->getTotalValue();
+        double totalReturn = snapshot->getTotalReturnPercentage();
         
         std::cout << "\n--- Performance Summary ---" << std::endl;
         std::cout << "Portfolio Value: " << Utils::formatCurrency(totalValue) << std::endl;
@@ -1879,31 +9554,30 @@ public:
         
         std::cout << "\n--- SIP Growth Projections ---" << std::endl;
         std::cout << "Monthly Investment: " << Utils::formatCurrency(monthlyInvestment) << std::endl;
-        std::cout << "Projected Value (1 year): " << Utils::formatCurrency(
-            sipManager.calculateProjectedGrowth(12, 10.0)) << std::endl;
-        std::cout << "Projected Value (5 years): " << Utils::formatCurrency(
-            sipManager.calculateProjectedGrowth(60, 10.0)) << std::endl;
+        ProjectionMatrix projection = sipManager.projectGrowthGrid({12, 60}, {10.0});
+        std::cout << "Projected Value (1 year): " << Utils::formatCurrency(projection.at(0, 0, 0)) << std::endl;
+        std::cout << "Projected Value (5 years): " << Utils::formatCurrency(projection.at(1, 0, 0)) << std::endl;
         
         // Risk assessment
         std::cout << "\n--- Risk Assessment ---" << std::endl;
         double portfolioVolatility = const_cast<PortfolioManager&>(portfolioManager)
-            .getRiskAnalyzer().calculatePortfolioVolatility(portfolioManager.getAssets());
+            .getRiskAnalyzer().calculatePortfolioVolatility(*snapshot, portfolioManager.getCovariance());
         std::cout << "Portfolio Volatility: " << std::fixed << std::setprecision(2) 
                   << portfolioVolatility << "%" << std::endl;
         
         // Asset performance
         std::cout << "\n--- Top Performers ---" << std::endl;
-        std::vector<std::pair<std::string, double>> assetReturns;
+        std::vector<std::pair<SymbolId, double>> assetReturns;
         
-        for (const auto& [symbol, asset] : portfolioManager.getAssets()) {
-            assetReturns.push_back({symbol, asset->getReturnPercentage()});
+        for (size_t row = 0; row < snapshot->size(); ++row) {
+            assetReturns.push_back({snapshot->getIds()[row], snapshot->getReturns()[row]});
         }
         
         std::sort(assetReturns.begin(), assetReturns.end(), 
                  [](const auto& a, const auto& b) { return a.second > b.second; });
         
         for (size_t i = 0; i < std::min(size_t(3), assetReturns.size()); ++i) {
-            std::cout << "  " << (i+1) << ". " << assetReturns[i].first << ": " 
+            std::cout << "  " << (i+1) << ". " << SymbolTable::global().name(assetReturns[i].first) << ": " 
                       << std::fixed << std::setprecision(2) << assetReturns[i].second << "%" << std::endl;
         }
         
@@ -1919,12 +9593,53 @@ private:
     std::unique_ptr<MarketDataFetcher> dataFetcher;
     std::unique_ptr<AdvisorEngine> advisorEngine;
     bool isInitialized;
+    MarketDataSpec marketData; // Source for market updates, simulated unless chosen on the command line
+    std::string ingestPath;    // Feed streamed into the portfolio in the background, empty = none
+    OverflowPolicy ingestPolicy = OverflowPolicy::Merge;
+    std::unique_ptr<TickIngestor> ingestor;
+    std::string statePath = "portfolio_state.bin"; // Saved on exit
+    bool restoreOnStart = false;
+    std::string journalPath = "portfolio_journal.bin"; // Position changes since the last save, empty = none
+    std::optional<LotLedger::Relief> lotRelief; // Overrides each holding's lot relief when set
+    std::string archiveDirectory; // Per-symbol price archives, empty = none
 
 public:
     CLIInterface() : isInitialized(false) {
         dataFetcher = std::make_unique<MarketDataFetcher>();
     }
     
+    void setMarketData(const MarketDataSpec& spec) {
+        marketData = spec;
+    }
+    
+    // Where the profile and portfolio are saved on exit; with `restore`
+    // the saved state is loaded instead of running the profile setup
+    void setStateFile(const std::string& path, bool restore) {
+        statePath = path;
+        restoreOnStart = restore;
+    }
+    
+    // Lots relieved first when selling, e.g. highest cost to defer gains
+    void setLotRelief(LotLedger::Relief method) {
+        lotRelief = method;
+    }
+    
+    // Journal every buy, sell, SIP run and rebalance between saves
+    void setJournalFile(const std::string& path) {
+        journalPath = path;
+    }
+    
+    // Archive every price point per symbol under `directory`
+    void setArchiveDirectory(const std::string& directory) {
+        archiveDirectory = directory;
+    }
+    
+    // Stream ticks from a local socket, pipe or file into the portfolio
+    void setTickFeed(const std::string& path, OverflowPolicy policy) {
+        ingestPath = path;
+        ingestPolicy = policy;
+    }
+    
     ~CLIInterface() {
         // Smart pointers will automatically clean up
         // But we should ensure curl cleanup is done
@@ -1937,7 +9652,7 @@ public:
     void run() {
         displayWelcome();
         
-        if (!setupUser()) {
+        if (!(restoreOnStart && restoreUser()) && !setupUser()) {
             std::cout << "Setup failed. Exiting..." << std::endl;
             return;
         }
@@ -1960,19 +9675,48 @@ public:
         std::cout << std::endl;
     }
     
+    // Move an earlier session's state and journal aside (as
+    // "<path>.<epoch seconds>.bak") so a new profile never saves over
+    // them; false if one exists and could not be moved
+    bool setAsideEarlierSession() {
+        std::string suffix = "." + std::to_string(Clock::now()) + ".bak";
+        for (const std::string& path : {statePath, journalPath}) {
+            std::error_code ec;
+            if (path.empty() || !std::filesystem::exists(path, ec)) continue;
+            std::filesystem::rename(path, path + suffix, ec);
+            if (ec) {
+                std::cerr << "Failed to move " << path << " aside: " << ec.message() << std::endl;
+                return false;
+            }
+            std::cout << "📦 Kept the earlier " << path << " as " << path + suffix << std::endl;
+        }
+        return true;
+    }
+    
     // Set up user profile and initialize portfolio
     bool setupUser() {
+        // A state or journal left by an earlier session (unrestored, or
+        // unreadable) may hold the only record of its trades
+        if (!setAsideEarlierSession()) {
+            return false;
+        }
+        
         userProfile.setup();
         userProfile.displayProfile();
         
         // Initialize portfolio manager
         portfolioManager = std::make_unique<PortfolioManager>(userProfile);
+        if (!archiveDirectory.empty()) {
+            portfolioManager->setArchiveDirectory(archiveDirectory);
+        }
         portfolioManager->initializePortfolio(userProfile.getInvestmentCapital());
-        
-        // Initialize advisor engine
-        advisorEngine = std::make_unique<AdvisorEngine>(*portfolioManager, *dataFetcher);
-        
-        isInitialized = true;
+        if (!journalPath.empty()) {
+            // Start a fresh journal and save the new portfolio as the base
+            // it replays onto after a crash
+            portfolioManager->setJournal(TransactionJournal::open(journalPath));
+            saveState();
+        }
+        connectServices();
         
         std::cout << "✅ Portfolio initialized successfully!" << std::endl;
         std::cout << "💰 Initial allocation completed based on your risk profile." << std::endl;
@@ -1980,6 +9724,71 @@ public:
         return true;
     }
     
+    // Pick up where the last session left off; false if there is no usable
+    // saved state, in which case the normal setup runs
+    bool restoreUser() {
+        auto started = std::chrono::steady_clock::now();
+        if (!PortfolioState::load(statePath, userProfile, portfolioManager)) {
+            std::cout << "⚠️  No saved state restored from " << statePath << ", starting a new profile" << std::endl;
+            return false;
+        }
+        if (!archiveDirectory.empty()) {
+            portfolioManager->setArchiveDirectory(archiveDirectory);
+        }
+        if (!journalPath.empty()) {
+            std::unique_ptr<TransactionJournal> journal = TransactionJournal::open(journalPath);
+            if (journal) {
+                size_t replayed = portfolioManager->replayJournal(*journal);
+                if (replayed > 0) {
+                    std::cout << "📒 Replayed " << replayed << " journaled changes from " << journalPath << std::endl;
+                }
+            } else {
+                std::cout << "⚠️  Journal " << journalPath << " could not be opened: nothing replayed, "
+                          << "and changes this session are kept only by saving" << std::endl;
+            }
+            portfolioManager->setJournal(std::move(journal));
+        }
+        connectServices();
+        
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        userProfile.displayProfile();
+        std::cout << "✅ Portfolio restored from " << statePath << " in " << std::fixed << std::setprecision(1)
+                  << elapsedMs << " ms" << std::endl;
+        return true;
+    }
+    
+    // Save the profile and portfolio; the journal restarts from the saved state
+    bool saveState() {
+        if (!PortfolioState::save(statePath, userProfile, *portfolioManager)) {
+            return false;
+        }
+        portfolioManager->checkpointJournal();
+        return true;
+    }
+    
+    // Market data, advisor and tick feed around a ready portfolio
+    void connectServices() {
+        if (lotRelief) {
+            portfolioManager->setLotRelief(*lotRelief);
+        }
+        
+        if (!portfolioManager->setMarketData(marketData)) {
+            std::cout << "⚠️  Market data source unavailable, using simulated prices" << std::endl;
+        }
+        
+        // Initialize advisor engine
+        advisorEngine = std::make_unique<AdvisorEngine>(*portfolioManager, *dataFetcher);
+        
+        if (!ingestPath.empty()) {
+            ingestor = TickIngestor::open(ingestPath, ingestPolicy);
+            if (ingestor) {
+                std::cout << "📡 Streaming ticks from " << ingestPath << std::endl;
+            }
+        }
+        
+        isInitialized = true;
+    }
+    
     // Main menu system
     void mainMenu() {
         while (true) {
@@ -1989,6 +9798,11 @@ public:
             std::cout << "Enter your choice: ";
             std::cin >> choice;
             
+            // Ticks streamed while waiting for input land before the action
+            if (ingestor) {
+                portfolioManager->applyTicks(*ingestor);
+            }
+            
             switch (choice) {
                 case 1:
                     viewPortfolioSummary();
@@ -2017,7 +9831,16 @@ public:
                 case 9:
                     simulateScenarios();
                     break;
+                case 10:
+                    backtestStrategy();
+                    break;
+                case 11:
+                    sellFromLot();
+                    break;
                 case 0:
+                    if (saveState()) {
+                        std::cout << "\n💾 Portfolio saved to " << statePath << std::endl;
+                    }
                     std::cout << "\n👋 Thank you for using Dynamic AI Financial Advisor!" << std::endl;
                     std::cout << "💡 Remember: Invest wisely and stay diversified!" << std::endl;
                     return;
@@ -2041,6 +9864,8 @@ public:
         std::cout << "7. 📋 Generate Monthly Report" << std::endl;
         std::cout << "8. 🎯 Adjust Risk Profile" << std::endl;
         std::cout << "9. 🔮 Simulate Scenarios" << std::endl;
+        std::cout << "10. 🧪 Backtest Strategy" << std::endl;
+        std::cout << "11. 🧾 Sell From a Lot" << std::endl;
         std::cout << "0. 🚪 Exit" << std::endl;
         std::cout << std::endl;
     }
@@ -2072,8 +9897,11 @@ public:
             return;
         }
         
-        std::cout << "🔄 Updating market data..." << std::endl;
-        portfolioManager->updatePrices(false); // Use simulated data for demo
+        std::cout << "🔄 Updating market data (" << portfolioManager->getMarketDataSource().describe() << ")..." << std::endl;
+        if (!portfolioManager->updatePrices()) {
+            std::cout << "⚠️  Market data source has no more data" << std::endl;
+            return;
+        }
         std::cout << "✅ Market data updated successfully!" << std::endl;
     }
     
@@ -2181,6 +10009,54 @@ public:
         std::cout << "💡 Consider rebalancing portfolio to match new risk profile." << std::endl;
     }
     
+    // Sell from one purchase lot, e.g. to realise a chosen gain or loss
+    void sellFromLot() {
+        if (!isInitialized) {
+            std::cout << "❌ Portfolio not initialized!" << std::endl;
+            return;
+        }
+        
+        std::cout << "\n========== SELL FROM A LOT ==========\n" << std::endl;
+        std::cout << "Enter symbol: ";
+        std::string symbol;
+        std::cin >> symbol;
+        std::shared_ptr<Asset> asset = portfolioManager->getAsset(symbol);
+        if (!asset || asset->getLots().openLotCount() == 0) {
+            std::cout << "❌ No open lots for " << symbol << std::endl;
+            return;
+        }
+        
+        double price = asset->getCurrentPrice();
+        std::cout << std::left << std::setw(8) << "Lot" << std::setw(14) << "Acquired" << std::setw(16) << "Quantity"
+                  << std::setw(16) << "Unit Cost" << "Gain at " << Utils::formatCurrency(price) << std::endl;
+        asset->getLots().forEachOpen([&](std::uint32_t id, const LotLedger::Lot& lot) {
+            std::cout << std::left << std::setw(8) << id
+                      << std::setw(14) << Date{static_cast<std::int32_t>(lot.acquired / 86400)}.toString()
+                      << std::setw(16) << std::fixed << std::setprecision(6) << lot.quantity
+                      << std::setw(16) << Utils::formatCurrency(lot.unitCost)
+                      << Utils::formatCurrency(lot.quantity * (price - lot.unitCost)) << std::endl;
+        });
+        
+        std::cout << "\nLot to sell from: ";
+        std::uint32_t lot;
+        std::cin >> lot;
+        if (!asset->getLots().isOpen(lot)) {
+            std::cout << "❌ Lot " << lot << " is not open" << std::endl;
+            return;
+        }
+        std::cout << "Quantity to sell (0 = whole lot): ";
+        double quantity;
+        std::cin >> quantity;
+        if (quantity <= 0) quantity = asset->getLots().lot(lot).quantity;
+        
+        double proceeds = portfolioManager->sellLot(SymbolTable::global().intern(symbol), lot, quantity);
+        if (proceeds > 0) {
+            std::cout << "✅ Sold from lot " << lot << " for " << Utils::formatCurrency(proceeds) << std::endl;
+        } else {
+            std::cout << "❌ Nothing sold from lot " << lot << std::endl;
+        }
+    }
+    
     // Simulate scenarios
     void simulateScenarios() {
         if (!isInitialized) {
@@ -2193,21 +10069,51 @@ public:
         
         double currentValue = portfolioManager->getTotalValue();
         
-        // Simulate different market scenarios
-        std::cout << "\n--- Market Scenario Analysis ---" << std::endl;
-        std::cout << "Current Portfolio Value: " << Utils::formatCurrency(currentValue) << std::endl;
-        
-        // Bull market scenario (+20% growth)
-        double bullValue = currentValue * 1.20;
-        std::cout << "🐂 Bull Market (+20%): " << Utils::formatCurrency(bullValue) << std::endl;
+        // Monte Carlo projection of the whole portfolio with SIP contributions
+        MonteCarloConfig config;
+        config.paths = 10000;
+        config.months = 120;
+        MonteCarloResult result = portfolioManager->runMonteCarlo(config);
         
-        // Bear market scenario (-30% decline)
-        double bearValue = currentValue * 0.70;
-        std::cout << "🐻 Bear Market (-30%): " << Utils::formatCurrency(bearValue) << std::endl;
+        std::cout << "\n--- Monte Carlo Projection (" << config.months / 12 << " years, "
+                  << result.paths << " paths) ---" << std::endl;
+        std::cout << "Current Portfolio Value: " << Utils::formatCurrency(currentValue) << std::endl;
+        std::cout << "Model: " << (result.model == MonteCarloModel::Bootstrap ? "Bootstrapped returns" : "Correlated GBM")
+                  << " (" << std::fixed << std::setprecision(2) << result.elapsedSeconds << "s)" << std::endl;
         
-        // Recession scenario (-40% decline)
-        double recessionValue = currentValue * 0.60;
-        std::cout << "📉 Recession (-40%): " << Utils::formatCurrency(recessionValue) << std::endl;
+        std::cout << "\n" << std::left << std::setw(8) << "Year";
+        for (double p : result.percentiles) {
+            std::cout << std::right << std::setw(16) << ("P" + std::to_string(static_cast<int>(p)));
+        }
+        std::cout << std::endl;
+        for (size_t c = 0; c < result.checkpointMonths.size(); ++c) {
+            std::cout << std::left << std::setw(8) << std::setprecision(1) << result.checkpointMonths[c] / 12.0;
+            for (double value : result.bands[c]) {
+                std::cout << std::right << std::setw(16) << Utils::formatCurrency(value, 0);
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::left;
+        
+        std::cout << "\nTotal Invested: " << Utils::formatCurrency(result.initialValue + result.totalContributions) << std::endl;
+        std::cout << "Expected Final Value: " << Utils::formatCurrency(result.meanTerminal) << std::endl;
+        std::cout << "Probability of Loss: " << std::fixed << std::setprecision(1) 
+                  << result.probabilityOfLoss * 100.0 << "%" << std::endl;
+        
+        // Terminal value distribution between the 1st and 99th percentiles
+        double low = result.terminalPercentile(1.0);
+        double high = result.terminalPercentile(99.0);
+        const size_t bins = 10;
+        std::vector<size_t> histogram = result.terminalHistogram(bins, low, high);
+        size_t tallest = std::max<size_t>(1, *std::max_element(histogram.begin(), histogram.end()));
+        std::cout << "\nFinal Value Distribution:" << std::endl;
+        for (size_t b = 0; b < bins; ++b) {
+            double bucketLow = low + (high - low) * b / bins;
+            double share = result.paths ? 100.0 * histogram[b] / result.paths : 0.0;
+            std::cout << std::right << std::setw(14) << Utils::formatCurrency(bucketLow, 0) << std::left << " "
+                      << std::string(30 * histogram[b] / tallest, '#') << " "
+                      << std::fixed << std::setprecision(1) << share << "%" << std::endl;
+        }
         
         // High inflation scenario
         std::cout << "\n--- Inflation Impact Analysis ---" << std::endl;
@@ -2226,9 +10132,10 @@ public:
         double monthlyInvestment = sipManager.getMonthlyAmount();
         
         if (monthlyInvestment > 0) {
-            double conservativeGrowth = sipManager.calculateProjectedGrowth(120, 8.0);  // 8% annual
-            double moderateGrowth = sipManager.calculateProjectedGrowth(120, 12.0);     // 12% annual
-            double aggressiveGrowth = sipManager.calculateProjectedGrowth(120, 15.0);   // 15% annual
+            ProjectionMatrix growth = sipManager.projectGrowthGrid({120}, {8.0, 12.0, 15.0});
+            double conservativeGrowth = growth.at(0, 0, 0);  // 8% annual
+            double moderateGrowth = growth.at(0, 1, 0);      // 12% annual
+            double aggressiveGrowth = growth.at(0, 2, 0);    // 15% annual
             
             std::cout << "🟢 Conservative (8% annual, 10 years): " 
                       << Utils::formatCurrency(conservativeGrowth) << std::endl;
@@ -2241,6 +10148,92 @@ public:
         std::cout << "\n💡 Scenarios help you prepare for different market conditions!" << std::endl;
     }
     
+    // Backtest the current SIP and rebalancing settings over a price file,
+    // then sweep nearby parameter sets
+    void backtestStrategy() {
+        if (!isInitialized) {
+            std::cout << "❌ Portfolio not initialized!" << std::endl;
+            return;
+        }
+        
+        std::string path;
+        std::cout << "Enter price history CSV path (date,SYMBOL,...): ";
+        std::cin >> path;
+        
+        auto prices = PriceTable::load(path);
+        if (!prices) {
+            std::cout << "❌ Could not load price history." << std::endl;
+            return;
+        }
+        Backtester backtester(prices);
+        
+        std::cout << "\n========== STRATEGY BACKTEST ==========\n" << std::endl;
+        std::cout << "Period: " << prices->dateAt(0).toString() << " to " 
+                  << prices->dateAt(prices->rows() - 1).toString() 
+                  << " (" << prices->rows() << " days, " << prices->columns() << " symbols)" << std::endl;
+        
+        // Current settings
+        BacktestConfig current;
+        current.initialCapital = userProfile.getInvestmentCapital();
+        current.monthlyAmount = portfolioManager->getSIPManager().getMonthlyAmount();
+        current.riskScore = portfolioManager->getRiskAnalyzer().getRiskScore();
+        current.recordEquityCurve = true;
+        BacktestResult result = backtester.run(current);
+        
+        std::cout << "\n--- Current Strategy ---" << std::endl;
+        std::cout << "Total Invested: " << Utils::formatCurrency(result.totalContributed) << std::endl;
+        std::cout << "Final Value: " << Utils::formatCurrency(result.finalValue) << std::endl;
+        std::cout << "Annualized Return: " << std::fixed << std::setprecision(2) << result.annualizedReturn << "%" << std::endl;
+        std::cout << "Annualized Volatility: " << result.annualizedVolatility << "%" << std::endl;
+        std::cout << "Max Drawdown: " << result.maxDrawdown << "%" << std::endl;
+        std::cout << "Sharpe Ratio: " << result.sharpeRatio << std::endl;
+        std::cout << "Rebalances: " << result.rebalances << " (costs " << Utils::formatCurrency(result.costs) << ")" << std::endl;
+        
+        std::cout << "\nEquity Curve (year start):" << std::endl;
+        for (size_t i = 0; i < result.equityCurve.size(); ++i) {
+            if (i == 0 || prices->monthKeyAt(i) / 12 != prices->monthKeyAt(i - 1) / 12) {
+                std::cout << "  " << prices->dateAt(i).toString() << "  " 
+                          << Utils::formatCurrency(result.equityCurve[i]) << std::endl;
+            }
+        }
+        
+        // Parameter sweep around the current settings
+        std::vector<BacktestConfig> configs;
+        for (double amountScale : {0.5, 1.0, 2.0}) {
+            for (double threshold : {2.5, 5.0, 10.0, 20.0, 1000.0}) {
+                for (double riskScore : {20.0, 50.0, 80.0}) {
+                    BacktestConfig config = current;
+                    config.monthlyAmount = current.monthlyAmount * amountScale;
+                    config.driftThreshold = threshold;
+                    config.riskScore = riskScore;
+                    config.recordEquityCurve = false;
+                    configs.push_back(config);
+                }
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<BacktestResult> sweep = backtester.sweep(configs);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        std::sort(sweep.begin(), sweep.end(), [](const BacktestResult& a, const BacktestResult& b) {
+            return a.sharpeRatio > b.sharpeRatio;
+        });
+        std::cout << "\n--- Top Parameter Sets by Sharpe (" << configs.size() << " runs, " 
+                  << std::setprecision(3) << elapsed << "s) ---" << std::endl;
+        for (size_t i = 0; i < std::min<size_t>(5, sweep.size()); ++i) {
+            const BacktestResult& r = sweep[i];
+            std::cout << "  SIP " << Utils::formatCurrency(r.config.monthlyAmount) << ", drift ";
+            if (r.config.driftThreshold >= 100.0) {
+                std::cout << "never";
+            } else {
+                std::cout << std::setprecision(1) << r.config.driftThreshold << "%";
+            }
+            std::cout << std::setprecision(2) << ", risk " << static_cast<int>(r.config.riskScore)
+                      << ": return " << r.annualizedReturn << "%, vol " << r.annualizedVolatility
+                      << "%, drawdown " << r.maxDrawdown << "%, Sharpe " << r.sharpeRatio << std::endl;
+        }
+    }
+    
     // Pause and clear screen utility
     void pauseAndClear() {
         std::cout << "\nPress Enter to continue...";
@@ -2256,11 +10249,811 @@ public:
     }
 };
 
+// Micro-benchmarks for hot paths, run with `--benchmark`
+namespace Benchmarks {
+    // Average wall time of `fn` in microseconds
+    template <typename Fn>
+    double timeMicros(int iterations, Fn&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+    }
+    
+    // Portfolio valuation: walking a string-keyed map of Asset objects
+    // versus one pass over the struct-of-arrays holdings table
+    void runValuationBenchmark(size_t positions = 10000, int iterations = 200) {
+        std::map<std::string, std::shared_ptr<Asset>> byName;
+        HoldingsTable holdings;
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<> priceDist(1.0, 1000.0);
+        std::uniform_real_distribution<> quantityDist(0.1, 100.0);
+        
+        for (size_t i = 0; i < positions; ++i) {
+            std::string symbol = "BENCH" + std::to_string(i);
+            auto asset = std::make_shared<Asset>(symbol, symbol, priceDist(gen), quantityDist(gen));
+            asset->updateCurrentPrice(asset->getCurrentPrice() * 1.01);
+            byName[symbol] = asset;
+            holdings.upsert(SymbolTable::global().intern(symbol), *asset);
+        }
+        
+        volatile double sink = 0.0;
+        double mapMicros = timeMicros(iterations, [&]() {
+            double totalValue = 0.0;
+            for (const auto& [symbol, asset] : byName) {
+                totalValue += asset->getCurrentValue();
+            }
+            double weightedReturn = 0.0;
+            double weightedVolatility = 0.0;
+            for (const auto& [symbol, asset] : byName) {
+                double weight = asset->getCurrentValue() / totalValue;
+                weightedReturn += weight * asset->getReturnPercentage();
+                weightedVolatility += weight * asset->getVolatility();
+            }
+            sink = totalValue + weightedReturn + weightedVolatility;
+        });
+        double tableMicros = timeMicros(iterations, [&]() {
+            HoldingsTable::Totals totals = holdings.computeTotals();
+            sink = totals.totalValue + totals.weightedReturn + totals.weightedVolatility;
+        });
+        double snapshotMicros = timeMicros(iterations, [&]() {
+            PortfolioSnapshot snapshot(holdings, 0.0);
+            sink = snapshot.getTotalValue() + snapshot.getWeights().back();
+        });
+        (void)sink;
+        
+        std::cout << "Portfolio valuation (" << positions << " positions):" << std::endl;
+        std::cout << "  Map walk:       " << std::fixed << std::setprecision(1) << mapMicros << " us" << std::endl;
+        std::cout << "  Holdings table: " << std::fixed << std::setprecision(1) << tableMicros << " us" << std::endl;
+        std::cout << "  Full snapshot:  " << std::fixed << std::setprecision(1) << snapshotMicros << " us" << std::endl;
+        std::cout << "  Speedup:        " << std::fixed << std::setprecision(1) 
+                  << (tableMicros > 0.0 ? mapMicros / tableMicros : 0.0) << "x" << std::endl;
+    }
+    
+    // Normal variates per second from one stream
+    void runRandomBenchmark(size_t count = 10000000) {
+        RandomStream rng = RandomService::global().stream(RandomService::Domain::Simulation, 0);
+        std::vector<double> buffer(4096);
+        size_t rounds = count / buffer.size();
+        
+        double micros = timeMicros(1, [&]() {
+            for (size_t r = 0; r < rounds; ++r) {
+                rng.fillNormal(buffer.data(), buffer.size());
+            }
+        });
+        double generated = static_cast<double>(rounds * buffer.size());
+        
+        std::cout << "Normal sampling (" << static_cast<size_t>(generated) << " draws):" << std::endl;
+        std::cout << "  Throughput:     " << std::fixed << std::setprecision(1)
+                  << generated / micros << " M/s" << std::endl;
+    }
+    
+    // Monte Carlo paths per second for a correlated five-asset portfolio
+    void runMonteCarloBenchmark(size_t paths = 200000, int months = 120) {
+        std::vector<MonteCarloAsset> positions = {
+            {0, 6000.0, 10.0, 16.0, 300.0},
+            {1, 1000.0, 20.0, 70.0, 50.0},
+            {2, 1000.0, 5.0, 15.0, 50.0},
+            {3, 1000.0, 0.0, 8.0, 50.0},
+            {4, 1000.0, 2.0, 0.0, 50.0}
+        };
+        std::vector<double> correlation = {
+            1.0, 0.3, 0.1, 0.0, 0.0,
+            0.3, 1.0, 0.0, 0.0, 0.0,
+            0.1, 0.0, 1.0, 0.2, 0.0,
+            0.0, 0.0, 0.2, 1.0, 0.0,
+            0.0, 0.0, 0.0, 0.0, 1.0
+        };
+        MonteCarloEngine engine(positions);
+        engine.setCorrelation(correlation);
+        
+        MonteCarloConfig config;
+        config.paths = paths;
+        config.months = months;
+        MonteCarloResult result = engine.run(config);
+        
+        std::cout << "Monte Carlo (" << paths << " paths x " << months << " months, "
+                  << ThreadPool::global().size() << " threads):" << std::endl;
+        std::cout << "  Elapsed:        " << std::fixed << std::setprecision(2) << result.elapsedSeconds << " s" << std::endl;
+        std::cout << "  Throughput:     " << std::fixed << std::setprecision(2)
+                  << paths / result.elapsedSeconds / 1e6 << " M paths/s" << std::endl;
+    }
+    
+    // Projection grid versus one closed-form evaluation per cell
+    void runProjectionBenchmark(size_t horizons = 480, size_t rates = 200, size_t contributions = 50) {
+        std::vector<int> months(horizons);
+        std::vector<double> annualRates(rates), amounts(contributions);
+        for (size_t h = 0; h < horizons; ++h) months[h] = static_cast<int>(h + 1);
+        for (size_t r = 0; r < rates; ++r) annualRates[r] = 0.1 * (r + 1);
+        for (size_t c = 0; c < contributions; ++c) amounts[c] = 100.0 * (c + 1);
+        
+        volatile double sink = 0.0;
+        double perCellMicros = timeMicros(1, [&]() {
+            std::vector<double> values(horizons * rates * contributions);
+            size_t i = 0;
+            for (int n : months) {
+                for (double rate : annualRates) {
+                    for (double amount : amounts) {
+                        double monthlyRate = rate / 12.0 / 100.0;
+                        values[i++] = amount * ((std::pow(1 + monthlyRate, n) - 1) / monthlyRate) * (1 + monthlyRate);
+                    }
+                }
+            }
+            sink = values.back();
+        });
+        double gridMicros = timeMicros(1, [&]() {
+            ProjectionMatrix grid = GrowthProjector::grid(months, annualRates, amounts, 0.0,
+                                                          ContributionTiming::StartOfMonth);
+            sink = grid.values.back();
+        });
+        (void)sink;
+        
+        std::cout << "Projection grid (" << horizons * rates * contributions << " cells):" << std::endl;
+        std::cout << "  Per-cell pow:   " << std::fixed << std::setprecision(1) << perCellMicros / 1000.0 << " ms" << std::endl;
+        std::cout << "  Grid kernel:    " << std::fixed << std::setprecision(1) << gridMicros / 1000.0 << " ms" << std::endl;
+        std::cout << "  Speedup:        " << std::fixed << std::setprecision(1)
+                  << (gridMicros > 0.0 ? perCellMicros / gridMicros : 0.0) << "x" << std::endl;
+    }
+    
+    // Parameter sweep over 20 years of synthetic daily prices
+    void runBacktestBenchmark(size_t configCount = 2000) {
+        const size_t days = 20 * 252;
+        std::vector<SymbolId> symbols;
+        for (const char* symbol : {"SIP", "EUR/USD", "BTC", "XAU/USD"}) {
+            symbols.push_back(SymbolTable::global().intern(symbol));
+        }
+        const double drifts[] = {0.0004, 0.0, 0.0015, 0.0002};
+        const double vols[] = {0.01, 0.005, 0.04, 0.009};
+        
+        RandomStream rng = RandomService::global().stream(RandomService::Domain::Simulation, 0);
+        std::vector<Date> dates(days);
+        std::vector<double> prices(days * symbols.size());
+        std::vector<double> level = {200.0, 1.1, 40000.0, 1800.0};
+        Date start = Date::fromCivil(2005, 1, 3);
+        for (size_t d = 0; d < days; ++d) {
+            dates[d] = Date{start.days + static_cast<std::int32_t>(d / 5 * 7 + d % 5)};   // Weekdays
+            for (size_t a = 0; a < symbols.size(); ++a) {
+                level[a] *= std::exp(drifts[a] + vols[a] * rng.normal());
+                prices[d * symbols.size() + a] = level[a];
+            }
+        }
+        Backtester backtester(std::make_shared<const PriceTable>(dates, symbols, prices));
+        
+        std::vector<BacktestConfig> configs(configCount);
+        for (size_t i = 0; i < configCount; ++i) {
+            configs[i].monthlyAmount = 100.0 + 10.0 * (i % 50);
+            configs[i].driftThreshold = 1.0 + (i / 50) % 20;
+            configs[i].riskScore = 10.0 + 40.0 * (i / 1000 % 3);
+        }
+        
+        double micros = timeMicros(1, [&]() { backtester.sweep(configs); });
+        std::cout << "Backtest sweep (" << configCount << " configs x " << days << " days):" << std::endl;
+        std::cout << "  Elapsed:        " << std::fixed << std::setprecision(2) << micros / 1e6 << " s" << std::endl;
+    }
+    
+    // Covariance update and w^T Sigma w at several hundred instruments
+    void runCovarianceBenchmark(size_t instruments = 500, size_t ticks = 500) {
+        CovarianceEngine engine(252);
+        for (size_t i = 0; i < instruments; ++i) {
+            engine.addInstrument(SymbolTable::global().intern("COV" + std::to_string(i)));
+        }
+        RandomStream rng = RandomService::global().stream(RandomService::Domain::Simulation, 1);
+        std::vector<double> returns(instruments);
+        std::vector<double> weights(instruments, 1.0 / instruments);
+        
+        double updateMicros = timeMicros(static_cast<int>(ticks), [&]() {
+            double market = rng.normal();
+            for (double& r : returns) r = 0.01 * (0.5 * market + rng.normal());
+            engine.addReturns(returns.data());
+        });
+        volatile double sink = 0.0;
+        double varianceMicros = timeMicros(1000, [&]() { sink = engine.portfolioVariance(weights.data()); });
+        (void)sink;
+        
+        std::cout << "Covariance (" << instruments << " instruments, window " << engine.getWindow() << "):" << std::endl;
+        std::cout << "  Tick update:    " << std::fixed << std::setprecision(1) << updateMicros << " us" << std::endl;
+        std::cout << "  w'Sw:           " << std::fixed << std::setprecision(1) << varianceMicros << " us" << std::endl;
+    }
+    
+    void runOptimizerBenchmark(size_t assets = 100) {
+        RandomStream rng = RandomService::global().stream(RandomService::Domain::Simulation, 2);
+        const size_t factors = 5;
+        std::vector<double> loadings(assets * factors);
+        for (double& loading : loadings) loading = 0.1 * rng.normal();
+        std::vector<double> expected(assets), covariance(assets * assets);
+        for (size_t i = 0; i < assets; ++i) {
+            expected[i] = rng.uniform(0.02, 0.12);
+            for (size_t j = 0; j < assets; ++j) {
+                double sum = i == j ? 0.01 : 0.0;
+                for (size_t k = 0; k < factors; ++k) sum += loadings[i * factors + k] * loadings[j * factors + k];
+                covariance[i * assets + j] = sum;
+            }
+        }
+        OptimizerConstraints constraints;
+        constraints.maxWeights.assign(assets, 0.1);
+        PortfolioOptimizer optimizer(expected, covariance, constraints);
+        
+        AssetMap starter;
+        for (const char* symbol : {"SIP", "USD", "XAU/USD", "EUR/USD", "BTC"}) {
+            starter[SymbolTable::global().intern(symbol)] = AssetFactory::create(symbol, 1.0, 0.0, 0.5, 2.5);
+        }
+        double defaultMicros = timeMicros(20, [&]() {
+            RiskAnalyzer analyzer(50.0);
+            analyzer.setUniverse(starter);
+        });
+        double scoreMicros = timeMicros(5, [&]() { optimizer.forRiskScore(50.0); });
+        double frontierMicros = timeMicros(1, [&]() { optimizer.frontier(20); });
+        
+        std::cout << "Optimizer:" << std::endl;
+        std::cout << "  Default targets (5 assets):      " << std::fixed << std::setprecision(1)
+                  << defaultMicros / 1000.0 << " ms" << std::endl;
+        std::cout << "  Risk-score point (" << assets << " assets):  " << std::fixed << std::setprecision(1)
+                  << scoreMicros / 1000.0 << " ms" << std::endl;
+        std::cout << "  20-point frontier (" << assets << " assets): " << std::fixed << std::setprecision(1)
+                  << frontierMicros / 1000.0 << " ms" << std::endl;
+    }
+    
+    // Pulling two rates out of an exchange-rate response: full DOM parse
+    // versus the targeted streaming scan
+    void runQuoteParsingBenchmark(size_t currencies = 160, int iterations = 2000) {
+        std::string body = "{\"result\":\"success\",\"base_code\":\"EUR\",\"rates\":{";
+        for (size_t i = 0; i < currencies; ++i) {
+            char code[4] = {static_cast<char>('A' + i / 26 % 26), static_cast<char>('A' + i % 26), 'X', '\0'};
+            body += (i ? ",\"" : "\"") + std::string(code) + "\":" + std::to_string(1.0 + i * 0.013);
+        }
+        body += ",\"USD\":1.0923,\"GBP\":0.8612}}";
+        
+        volatile double sink = 0.0;
+        double domMicros = timeMicros(iterations, [&]() {
+            json document = json::parse(body);
+            sink = document["rates"]["USD"].get<double>() + document["rates"]["GBP"].get<double>();
+        });
+        double streamMicros = timeMicros(iterations, [&]() {
+            JsonFieldExtractor extractor;
+            extractor.addTarget({"rates", "USD"}, 0);
+            extractor.addTarget({"rates", "GBP"}, 1);
+            extractor.extract(body);
+            sink = *extractor.found(0) + *extractor.found(1);
+        });
+        (void)sink;
+        
+        std::cout << "Quote parsing (" << currencies << " rates):" << std::endl;
+        std::cout << "  DOM:            " << std::fixed << std::setprecision(1) << domMicros << " us" << std::endl;
+        std::cout << "  Streaming:      " << std::fixed << std::setprecision(1) << streamMicros << " us" << std::endl;
+    }
+    
+    // Full update pipeline driven by a recorded file replayed flat out:
+    // parse, price update, holdings, covariance and allocation per batch
+    void runReplayBenchmark(size_t batches = 20000) {
+        std::string path = (std::filesystem::temp_directory_path() / "financeadvisor_replay.csv").string();
+        const char* symbols[] = {"SIP", "USD", "XAU/USD", "EUR/USD", "BTC"};
+        double prices[] = {200.0, 1.0, 1800.0, 1.1, 40000.0};
+        RandomStream rng = RandomService::global().stream(RandomService::Domain::Simulation, 3);
+        {
+            std::ofstream out(path, std::ios::trunc | std::ios::binary);
+            std::string lines;
+            for (size_t t = 0; t < batches; ++t) {
+                lines.clear();
+                for (size_t k = 0; k < 5; ++k) {
+                    prices[k] *= 1.0 + 0.001 * rng.normal();
+                    TickCodec::format(lines, 1700000000000LL + static_cast<std::int64_t>(t) * 1000,
+                                      SymbolTable::global().intern(symbols[k]), prices[k]);
+                }
+                out << lines;
+            }
+        }
+        
+        double parseMicros = timeMicros(1, [&]() {
+            std::unique_ptr<ReplayMarketDataSource> replay = ReplayMarketDataSource::open(path);
+            MarketBatch batch;
+            while (replay && replay->next({}, batch)) {}
+        });
+        
+        UserProfile profile;
+        PortfolioManager manager(profile);
+        manager.initializePortfolio(100000.0);
+        MarketDataSpec spec;
+        spec.kind = MarketDataSpec::Kind::Replay;
+        spec.path = path;
+        manager.setMarketData(spec);
+        double pipelineMicros = timeMicros(1, [&]() {
+            while (manager.updatePrices()) {}
+        });
+        std::filesystem::remove(path);
+        
+        double ticks = static_cast<double>(batches * 5);
+        std::cout << "Replay (" << batches << " batches, " << batches * 5 << " ticks):" << std::endl;
+        std::cout << "  Parse only:     " << std::fixed << std::setprecision(0)
+                  << ticks / (parseMicros / 1e6) << " ticks/s" << std::endl;
+        std::cout << "  Full pipeline:  " << std::fixed << std::setprecision(0)
+                  << ticks / (pipelineMicros / 1e6) << " ticks/s" << std::endl;
+    }
+    
+    // Ticks per second from a generated feed written into a pipe and
+    // applied to a fresh portfolio; with `archiveDirectory` set every tick
+    // is archived, as in a CLI session run with --archive
+    double ingestRate(size_t ticks, const std::string& archiveDirectory, size_t& applied) {
+        applied = 0;
+#ifndef _WIN32
+        UserProfile profile;
+        PortfolioManager manager(profile);
+        if (!archiveDirectory.empty()) manager.setArchiveDirectory(archiveDirectory);
+        manager.initializePortfolio(100000.0);
+        
+        // Generated now so every tick is newer than the opening prices
+        std::string feed;
+        TickGenerator generator;
+        generator.generate(feed, ticks);
+        
+        int fds[2];
+        if (pipe(fds) != 0) return 0.0;
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<TickIngestor> ingestor = TickIngestor::fromDescriptor(fds[0], OverflowPolicy::Block);
+        std::thread writer([&]() {
+            for (size_t offset = 0; offset < feed.size(); ) {
+                ssize_t bytes = write(fds[1], feed.data() + offset, feed.size() - offset);
+                if (bytes <= 0) break;
+                offset += static_cast<size_t>(bytes);
+            }
+            close(fds[1]);
+        });
+        while (!ingestor->finished()) {
+            size_t taken = manager.applyTicks(*ingestor);
+            if (taken == 0) std::this_thread::yield();
+            applied += taken;
+        }
+        writer.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return applied / seconds;
+#else
+        return 0.0;
+#endif
+    }
+    
+    void runIngestBenchmark(size_t ticks = 1000000) {
+#ifndef _WIN32
+        size_t applied = 0, archived = 0;
+        double rate = ingestRate(ticks, "", applied);
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "financeadvisor_archive";
+        std::filesystem::remove_all(directory);
+        double archivedRate = ingestRate(ticks, directory.string(), archived);
+        std::filesystem::remove_all(directory);
+        
+        std::cout << "Tick ingestion (" << applied << " ticks through a pipe):" << std::endl;
+        std::cout << "  Applied:        " << std::fixed << std::setprecision(0)
+                  << rate << " ticks/s" << std::endl;
+        std::cout << "  With archives:  " << std::fixed << std::setprecision(0)
+                  << archivedRate << " ticks/s" << std::endl;
+#endif
+    }
+    
+#ifndef _WIN32
+    // Stand-in for the quote providers on a loopback port, answering the
+    // paths MarketDataEndpoints::local() documents with fixed quotes. One
+    // request per connection, served in arrival order.
+    class LocalQuoteServer {
+    private:
+        int listener = -1;
+        int port = 0;
+        std::atomic<bool> stopping{false};
+        std::atomic<std::uint64_t> served{0};
+        std::thread worker;
+        
+        static std::string bodyFor(const std::string& path) {
+            if (path.compare(0, 13, "/simple/price") == 0) {
+                return R"({"bitcoin":{"usd":43125.5},"ethereum":{"usd":2280.25}})";
+            }
+            if (path.compare(0, 8, "/latest/") == 0) {
+                return R"({"base":")" + path.substr(8) + R"(","rates":{"GBP":0.8571,"USD":1.0875}})";
+            }
+            if (path.compare(0, 6, "/quote") == 0) {
+                return R"({"c":231.75,"h":233.1,"l":230.4})";
+            }
+            // Metals, Swissquote layout
+            return R"([{"topo":{"platform":"SwissquoteLtd"},"spreadProfilePrices":[{"spreadProfile":"prime","bid":2034.5,"ask":2035.1}]}])";
+        }
+        
+        void serve(int connection) {
+            std::string request;
+            char buffer[4096];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                ssize_t bytes = recv(connection, buffer, sizeof(buffer), 0);
+                if (bytes <= 0) return;
+                request.append(buffer, static_cast<size_t>(bytes));
+            }
+            // "GET <path> HTTP/1.1"
+            size_t pathStart = request.find(' ') + 1;
+            std::string path = request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+            std::string body = bodyFor(path);
+            std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                                   std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            for (size_t offset = 0; offset < response.size(); ) {
+                ssize_t bytes = send(connection, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+                if (bytes <= 0) return;
+                offset += static_cast<size_t>(bytes);
+            }
+            served.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        void loop() {
+            pollfd waiting{listener, POLLIN, 0};
+            while (!stopping.load(std::memory_order_acquire)) {
+                if (poll(&waiting, 1, 50) <= 0) continue;
+                int connection = accept(listener, nullptr, nullptr);
+                if (connection < 0) continue;
+                serve(connection);
+                close(connection);
+            }
+        }
+    
+    public:
+        // Listens on 127.0.0.1 at a port the system picks
+        LocalQuoteServer() {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            if (listener < 0) return;
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0;
+            socklen_t length = sizeof(address);
+            if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+                listen(listener, 64) != 0 ||
+                getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+                std::cerr << "Failed to start local quote server: " << std::strerror(errno) << std::endl;
+                close(listener);
+                listener = -1;
+                return;
+            }
+            port = ntohs(address.sin_port);
+            worker = std::thread([this]() { loop(); });
+        }
+        
+        ~LocalQuoteServer() {
+            stopping.store(true, std::memory_order_release);
+            if (worker.joinable()) worker.join();
+            if (listener >= 0) close(listener);
+        }
+        
+        LocalQuoteServer(const LocalQuoteServer&) = delete;
+        LocalQuoteServer& operator=(const LocalQuoteServer&) = delete;
+        
+        bool running() const { return listener >= 0; }
+        std::uint64_t getServed() const { return served.load(std::memory_order_relaxed); }
+        std::string baseUrl() const { return "http://127.0.0.1:" + std::to_string(port); }
+    };
+#endif
+    
+    // Live fetch path end to end against the local stand-in: planning,
+    // concurrent HttpClient requests and quote extraction. The served
+    // quotes are fixed, so any symbol that fell back to simulation shows
+    // up as a mismatch.
+    void runEndpointBenchmark(size_t refreshes = 200) {
+#ifndef _WIN32
+        LocalQuoteServer server;
+        if (!server.running()) return;
+        MarketDataFetcher fetcher;
+        fetcher.setEndpoints(MarketDataEndpoints::local(server.baseUrl()));
+        
+        const std::pair<const char*, double> expected[] = {
+            {"BTC", 43125.5}, {"ETH", 2280.25}, {"EUR/USD", 1.0875}, {"EUR/GBP", 0.8571},
+            {"XAU/USD", 2034.5}, {"VTI", 231.75}};
+        std::vector<SymbolId> symbols;
+        for (const auto& [symbol, price] : expected) {
+            symbols.push_back(SymbolTable::global().intern(symbol));
+        }
+        
+        size_t mismatches = 0;
+        double micros = timeMicros(1, [&]() {
+            for (size_t r = 0; r < refreshes; ++r) {
+                SymbolMap<double> prices = fetcher.updatePrices(symbols, true);
+                for (size_t k = 0; k < symbols.size(); ++k) {
+                    if (*prices.find(symbols[k]) != expected[k].second) ++mismatches;
+                }
+            }
+        });
+        
+        std::cout << "Live fetch via local stand-in (" << symbols.size() << " symbols, "
+                  << server.getServed() / std::max<size_t>(1, refreshes) << " requests/refresh):" << std::endl;
+        std::cout << "  Refresh:        " << std::fixed << std::setprecision(2)
+                  << micros / refreshes / 1000.0 << " ms" << std::endl;
+        std::cout << "  Quotes:         " << (mismatches == 0 ? "all match" : std::to_string(mismatches) + " mismatched")
+                  << std::endl;
+#endif
+    }
+    
+    // Quote reads from several threads while one thread keeps publishing:
+    // mutex-guarded map versus the price board
+    void runPriceBoardBenchmark(size_t readers = 4, size_t readsPerThread = 2000000) {
+        std::vector<SymbolId> ids;
+        for (size_t i = 0; i < 64; ++i) ids.push_back(SymbolTable::global().intern("PB" + std::to_string(i)));
+        
+        auto contend = [&](auto&& publish, auto&& read) {
+            std::atomic<bool> done{false};
+            std::thread writer([&]() {
+                for (std::int64_t tick = 1; !done.load(std::memory_order_relaxed); ++tick) {
+                    publish(ids[static_cast<size_t>(tick) % ids.size()], static_cast<double>(tick));
+                }
+            });
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < readers; ++t) {
+                threads.emplace_back([&, t]() {
+                    volatile double sink = 0.0;
+                    for (size_t i = 0; i < readsPerThread; ++i) sink = read(ids[(i + t) % ids.size()]);
+                    (void)sink;
+                });
+            }
+            for (std::thread& thread : threads) thread.join();
+            double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            done.store(true);
+            writer.join();
+            return elapsed / static_cast<double>(readers * readsPerThread);
+        };
+        
+        SymbolMap<double> guarded;
+        std::mutex guard;
+        for (SymbolId id : ids) guarded[id] = 1.0;
+        double mutexNanos = contend(
+            [&](SymbolId id, double price) { std::lock_guard<std::mutex> lock(guard); guarded[id] = price; },
+            [&](SymbolId id) { std::lock_guard<std::mutex> lock(guard); return *guarded.find(id); });
+        
+        PriceBoard board;
+        double boardNanos = contend(
+            [&](SymbolId id, double price) { board.publish(id, price, 0); },
+            [&](SymbolId id) { return board.price(id); });
+        
+        std::cout << "Price reads (" << readers << " readers, 1 writer):" << std::endl;
+        std::cout << "  Mutex map:      " << std::fixed << std::setprecision(1) << mutexNanos << " ns/read" << std::endl;
+        std::cout << "  Price board:    " << std::fixed << std::setprecision(1) << boardNanos << " ns/read" << std::endl;
+    }
+    
+    // Save and restore of a portfolio whose histories have filled the
+    // in-memory retention tiers
+    void runStateBenchmark(size_t updates = 20000) {
+        std::string path = (std::filesystem::temp_directory_path() / "financeadvisor_state.bin").string();
+        UserProfile profile;
+        PortfolioManager manager(profile);
+        manager.initializePortfolio(100000.0);
+        for (size_t i = 0; i < updates; ++i) manager.updatePrices();
+        
+        double saveMicros = timeMicros(1, [&]() { PortfolioState::save(path, profile, manager); });
+        std::uintmax_t bytes = std::filesystem::file_size(path);
+        
+        UserProfile restoredProfile;
+        std::unique_ptr<PortfolioManager> restored;
+        double loadMicros = timeMicros(1, [&]() { PortfolioState::load(path, restoredProfile, restored); });
+        std::filesystem::remove(path);
+        
+        std::cout << "Saved state (" << updates << " updates, " << bytes / 1024 << " KiB):" << std::endl;
+        std::cout << "  Save:           " << std::fixed << std::setprecision(2) << saveMicros / 1000.0 << " ms" << std::endl;
+        std::cout << "  Restore:        " << std::fixed << std::setprecision(2) << loadMicros / 1000.0 << " ms" << std::endl;
+    }
+    
+    // Journaled buys synced one at a time versus grouped into batches, and
+    // replay of the resulting journal
+    void runJournalBenchmark(size_t operations = 200000, size_t batchSize = 1000) {
+        std::string path = (std::filesystem::temp_directory_path() / "financeadvisor_journal.bin").string();
+        std::filesystem::remove(path);
+        UserProfile profile;
+        PortfolioManager manager(profile);
+        manager.initializePortfolio(100000.0);
+        manager.setJournal(TransactionJournal::open(path));
+        std::vector<SymbolId> ids = manager.snapshot()->getIds();
+        
+        size_t unbatched = std::min<size_t>(operations, 2000);
+        double singleMicros = timeMicros(1, [&]() {
+            for (size_t i = 0; i < unbatched; ++i) manager.buyAsset(ids[i % ids.size()], 10.0);
+        });
+        double batchedMicros = timeMicros(1, [&]() {
+            for (size_t i = 0; i < operations; i += batchSize) {
+                PortfolioManager::JournalBatch batch(manager);
+                for (size_t k = i; k < std::min(operations, i + batchSize); ++k) {
+                    manager.buyAsset(ids[k % ids.size()], 10.0);
+                }
+            }
+        });
+        TransactionJournal::Stats stats = manager.getJournal()->getStats();
+        
+        PortfolioManager replayed(profile);
+        replayed.initializePortfolio(100000.0);
+        size_t records = 0;
+        double replayMicros = timeMicros(1, [&]() {
+            std::unique_ptr<TransactionJournal> journal = TransactionJournal::open(path);
+            if (journal) records = replayed.replayJournal(*journal);
+        });
+        std::filesystem::remove(path);
+        
+        std::cout << "Journal (" << operations << " buys, " << stats.syncs << " syncs, "
+                  << stats.bytes / 1024 << " KiB):" << std::endl;
+        std::cout << "  Sync per op:    " << std::fixed << std::setprecision(0)
+                  << unbatched / (singleMicros / 1e6) << " ops/s" << std::endl;
+        std::cout << "  Group commit:   " << std::fixed << std::setprecision(0)
+                  << operations / (batchedMicros / 1e6) << " ops/s (" << batchSize << " per sync)" << std::endl;
+        std::cout << "  Replay:         " << std::fixed << std::setprecision(0)
+                  << records / (replayMicros / 1e6) << " records/s" << std::endl;
+    }
+    
+    // Small sells against a long history of SIP lots under each relief
+    // method, with a linear scan for the costliest lot as the baseline
+    void runLotLedgerBenchmark(size_t lotCount = 100000, size_t sells = 20000) {
+        RandomStream rng = RandomService::global().stream(RandomService::Domain::Simulation, 5);
+        std::vector<double> costs(lotCount);
+        double price = 100.0;
+        for (double& cost : costs) {
+            price *= 1.0 + 0.01 * rng.normal();
+            cost = price;
+        }
+        
+        auto build = [&]() {
+            LotLedger ledger;
+            for (size_t i = 0; i < lotCount; ++i) {
+                ledger.add(1600000000 + static_cast<std::int64_t>(i) * 86400, 1.0, costs[i]);
+            }
+            return ledger;
+        };
+        
+        std::cout << "Lot relief (" << lotCount << " lots, " << sells << " sells of 0.75 units):" << std::endl;
+        for (LotLedger::Relief method : {LotLedger::Relief::FIFO, LotLedger::Relief::LIFO, LotLedger::Relief::HighestCost}) {
+            LotLedger ledger = build();
+            double micros = timeMicros(1, [&]() {
+                for (size_t i = 0; i < sells; ++i) ledger.relieve(0.75, price, 1900000000, method);
+            });
+            std::cout << "  " << std::left << std::setw(16) << (LotLedger::reliefName(method) + ":") << std::right
+                      << std::fixed << std::setprecision(0) << micros * 1000.0 / sells << " ns/sell" << std::endl;
+        }
+        
+        std::vector<double> held(lotCount, 1.0);
+        size_t scanned = std::min<size_t>(sells, 2000);
+        double scanMicros = timeMicros(1, [&]() {
+            for (size_t i = 0; i < scanned; ++i) {
+                double wanted = 0.75;
+                while (wanted > 0.0) {
+                    size_t best = lotCount;
+                    for (size_t k = 0; k < lotCount; ++k) {
+                        if (held[k] > 0.0 && (best == lotCount || costs[k] > costs[best])) best = k;
+                    }
+                    if (best == lotCount) break;
+                    double taken = std::min(wanted, held[best]);
+                    held[best] -= taken;
+                    wanted -= taken;
+                }
+            }
+        });
+        std::cout << "  Scan (highest): " << std::fixed << std::setprecision(0)
+                  << scanMicros * 1000.0 / scanned << " ns/sell" << std::endl;
+    }
+    
+    void runAll() {
+        std::cout << "\n========== BENCHMARKS ==========\n" << std::endl;
+        runValuationBenchmark();
+        runRandomBenchmark();
+        runMonteCarloBenchmark();
+        runProjectionBenchmark();
+        runBacktestBenchmark();
+        runCovarianceBenchmark();
+        runOptimizerBenchmark();
+        runQuoteParsingBenchmark();
+        runEndpointBenchmark();
+        runReplayBenchmark();
+        runIngestBenchmark();
+        runPriceBoardBenchmark();
+        runStateBenchmark();
+        runJournalBenchmark();
+        runLotLedgerBenchmark();
+        std::cout << std::endl;
+    }
+}
+
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        bool benchmark = false;
+        MarketDataSpec marketData;
+        std::string ingestPath;
+        OverflowPolicy ingestPolicy = OverflowPolicy::Merge;
+        std::string generatePath;
+        size_t generateTicks = 1000000;
+        double generateRate = 0.0;
+        std::string statePath = "portfolio_state.bin";
+        bool restore = false;
+        std::string journalPath = "portfolio_journal.bin";
+        std::optional<LotLedger::Relief> lotRelief;
+        std::string archiveDirectory;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                benchmark = true;
+            } else if (arg == "--seed" && i + 1 < argc) {
+                // Fixed seed makes simulated market runs reproducible
+                RandomService::global().setSeed(std::stoull(argv[++i]));
+            } else if (arg == "--live") {
+                marketData.kind = MarketDataSpec::Kind::Http;
+            } else if (arg == "--replay" && i + 1 < argc) {
+                // Recorded "timestampMs,SYMBOL,price" ticks, one batch per update
+                marketData.kind = MarketDataSpec::Kind::Replay;
+                marketData.path = argv[++i];
+            } else if (arg == "--replay-speed" && i + 1 < argc) {
+                marketData.speed = std::stod(argv[++i]);
+            } else if (arg == "--feed" && i + 1 < argc) {
+                // Named pipe or Unix-domain socket streaming ticks in the same format
+                marketData.kind = MarketDataSpec::Kind::Feed;
+                marketData.path = argv[++i];
+            } else if (arg == "--record" && i + 1 < argc) {
+                marketData.recordPath = argv[++i];
+            } else if (arg == "--ingest" && i + 1 < argc) {
+                // Push ticks from a socket, pipe or file as they arrive
+                ingestPath = argv[++i];
+            } else if (arg == "--ingest-policy" && i + 1 < argc) {
+                std::string policy = argv[++i];
+                if (policy == "merge") {
+                    ingestPolicy = OverflowPolicy::Merge;
+                } else if (policy == "block") {
+                    ingestPolicy = OverflowPolicy::Block;
+                } else if (policy == "drop") {
+                    ingestPolicy = OverflowPolicy::DropNewest;
+                } else {
+                    std::cerr << "Unknown --ingest-policy " << policy << " (expected merge, block or drop)" << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--generate-feed" && i + 1 < argc) {
+                // Write synthetic ticks to a pipe or file instead of running the advisor
+                generatePath = argv[++i];
+            } else if (arg == "--generate-ticks" && i + 1 < argc) {
+                generateTicks = std::stoull(argv[++i]);
+            } else if (arg == "--generate-rate" && i + 1 < argc) {
+                generateRate = std::stod(argv[++i]);
+            } else if (arg == "--state" && i + 1 < argc) {
+                // Saved profile and portfolio, written on exit
+                statePath = argv[++i];
+            } else if (arg == "--restore") {
+                restore = true;
+            } else if (arg == "--journal" && i + 1 < argc) {
+                // Write-ahead journal of position changes, replayed by --restore
+                journalPath = argv[++i];
+            } else if (arg == "--archive" && i + 1 < argc) {
+                // Directory of per-symbol price archives, off unless given
+                archiveDirectory = argv[++i];
+            } else if (arg == "--lot-relief" && i + 1 < argc) {
+                std::string method = argv[++i];
+                if (method == "fifo") {
+                    lotRelief = LotLedger::Relief::FIFO;
+                } else if (method == "lifo") {
+                    lotRelief = LotLedger::Relief::LIFO;
+                } else if (method == "hifo") {
+                    lotRelief = LotLedger::Relief::HighestCost;
+                } else {
+                    std::cerr << "Unknown --lot-relief " << method << " (expected fifo, lifo or hifo)" << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--market-endpoint" && i + 1 < argc) {
+                // Serve every provider from one base URL, e.g. a local stand-in
+                MarketDataEndpoints::defaults() = MarketDataEndpoints::local(argv[++i]);
+            }
+        }
+        
+        if (benchmark) {
+            Benchmarks::runAll();
+            return 0;
+        }
+        
+        if (!generatePath.empty()) {
+            return TickGenerator().run(generatePath, generateTicks, generateRate) ? 0 : 1;
+        }
+        
         // Initialize the CLI interface and run the application
         CLIInterface app;
+        app.setMarketData(marketData);
+        app.setStateFile(statePath, restore);
+        app.setJournalFile(journalPath);
+        app.setArchiveDirectory(archiveDirectory);
+        if (lotRelief) {
+            app.setLotRelief(*lotRelief);
+        }
+        if (!ingestPath.empty()) {
+            app.setTickFeed(ingestPath, ingestPolicy);
+        }
         app.run();
         
     } catch (const std::exception& e) {
@@ -2272,4 +11065,4 @@ int main() {
     }
     
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file